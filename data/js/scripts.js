@@ -6,8 +6,14 @@ let two_twelve_canTouch = true;     // Setting: Can 2 and 12 be adjacent?
 let sameNumbers_canTouch = true;    // Setting: Can same numbers be adjacent?
 let sameResource_canTouch = true;   // Setting: Can same resources be adjacent?
 let manualDice = true;              // Setting: Can players manually select dice values?
+let minBalance = 0;                 // Setting: Lowest balance score (0-100) of new boards
 
 let currentSelectedNumber = 0;      // Currently selected number token (0 means none)
+let boardETag = null;               // ETag of the last board state received from /getboard
+let lastState = null;               // Last full state received from the server
+let pushConnected = false;          // Is the /events push channel open?
+
+const JOB_POLL_INTERVAL = 100;      // Milliseconds between polls of a pending board job
 
 // DOM Element references (populated in window.load)
 var numberButtons,
@@ -20,25 +26,105 @@ var numberButtons,
   option3,
   option4,
   option5,
+  minBalanceInput,
+  minBalanceValue,
   settingsModa,
   closeSettingsBtn;
 
 // -------------- Communication with Server --------------
 
+/**
+ * Apply a full state received from the server
+ * @param {Object} data - Board state data from server
+ */
+function applyServerState(data) {
+  lastState = data;
+
+  // Update local state with server data
+  gameStarted = data.gameStarted
+  extension = data.extension;
+  currentSelectedNumber = data.selectedNumber;
+  manualDice = data.manualDice;
+  minBalance = data.minBalance;
+  updateStates(data);
+}
+
+/**
+ * Apply the fields that changed during play, as sent by the server
+ * A delta carries selectedNumber, plus gameStarted when a game started or ended
+ * @param {Object} delta - Changed fields
+ */
+function applyStateDelta(delta) {
+  if (lastState && delta.gameStarted !== undefined) {
+    lastState.gameStarted = delta.gameStarted;
+    lastState.selectedNumber = delta.selectedNumber;
+    applyServerState(lastState);
+    return;
+  }
+  if (lastState) {
+    lastState.selectedNumber = delta.selectedNumber;
+  }
+  currentSelectedNumber = delta.selectedNumber;
+  updateBoardColors(currentSelectedNumber);
+  updateNumberButtonColors(currentSelectedNumber);
+}
+
+/**
+ * Follow state changes pushed by the server (Server-Sent Events)
+ * The server starts every stream with the whole state ("state"), then
+ * sends "number" and "game" events with only what changed, or a new
+ * "state" when the board or settings changed. While the stream is down
+ * the browser reconnects on its own and the page falls back to polling.
+ */
+function subscribeToState() {
+  if (!window.EventSource) {
+    return;
+  }
+  const events = new EventSource('/events');
+  events.onopen = () => { pushConnected = true; };
+  events.onerror = () => { pushConnected = false; };
+
+  events.addEventListener('state', event => {
+    boardETag = null;
+    applyServerState(JSON.parse(event.data));
+  });
+
+  const onDelta = event => {
+    boardETag = null;
+    applyStateDelta(JSON.parse(event.data));
+  };
+  events.addEventListener('game', onDelta);
+  events.addEventListener('number', onDelta);
+}
+
 /**
  * Periodically fetch board state from server to keep UI in sync
- * This runs every second to poll the server for any changes
+ * This runs every second while the push channel is down.
+ * The ETag of the last state is sent along: the server answers 304
+ * without a body while nothing changed, and only the changed fields
+ * while just the selected number or game flags moved.
  */
 setInterval(() => {
-  fetch('/getboard')
-    .then(response => response.json())
+  if (pushConnected) {
+    return;
+  }
+  const headers = boardETag ? { 'If-None-Match': boardETag } : {};
+  const since = (boardETag && lastState) ? '?since=' + encodeURIComponent(boardETag) : '';
+  fetch('/getboard' + since, { headers: headers, cache: 'no-store' })
+    .then(response => {
+      // 304: nothing changed; 503: the board is still starting up
+      if (response.status === 304 || !response.ok) {
+        return null;
+      }
+      boardETag = response.headers.get('ETag');
+      return response.json();
+    })
     .then(data => {
-      // Update local state with server data
-      gameStarted = data.gameStarted
-      extension = data.extension;
-      currentSelectedNumber = data.selectedNumber;
-      manualDice = data.manualDice;
-      updateStates(data);
+      if (data && data.delta) {
+        applyStateDelta(data);
+      } else if (data) {
+        applyServerState(data);
+      }
     })
     .catch(err => console.error("Error fetching board:", err));
 }, 1000);
@@ -75,6 +161,7 @@ function updateStates(data) {
     option3.disabled = true;
     option4.disabled = true;
     option5.disabled = true;
+    minBalanceInput.disabled = true;
     startGameBtn.textContent = "End Game";
   } else {
     // Hide number buttons and re-enable mode/options when game is not active
@@ -88,6 +175,7 @@ function updateStates(data) {
     option3.disabled = false;
     option4.disabled = false;
     option5.disabled = false;
+    minBalanceInput.disabled = false;
     startGameBtn.textContent = "Start Game";
   }
 
@@ -97,6 +185,8 @@ function updateStates(data) {
   option3.checked = data.sameNumbersCanTouch;
   option4.checked = data.sameResourceCanTouch;
   option5.checked = data.manualDice;
+  minBalanceInput.value = data.minBalance;
+  minBalanceValue.textContent = data.minBalance;
 
   // Update visual appearance of board elements
   updateBoardColors(currentSelectedNumber);
@@ -105,18 +195,57 @@ function updateStates(data) {
 
 // -------------- Board Mode Selection --------------
 
+/**
+ * Apply a board returned by /setclassic, /setextension or /getjob
+ * A pending response (HTTP 202) carries a job id instead of a board;
+ * the job is then polled until its board is ready
+ * @param {Object} data - Server response
+ */
+function applyShuffle(data) {
+  if (data.pending) {
+    setTimeout(() => waitForJob(data.job), JOB_POLL_INTERVAL);
+    return;
+  }
+  extension = data.extension;
+  updateStates(data);
+}
+
+/**
+ * Poll a board generation job until it finishes
+ * A superseded job (HTTP 410) is dropped; the regular /getboard poll
+ * then shows whatever board replaced it. A job whose rules allow no
+ * board (HTTP 422) keeps the current board and tells the user why
+ * @param {number} job - Generation id returned by the server
+ */
+function waitForJob(job) {
+  fetch('/getjob?id=' + job)
+    .then(response => {
+      if (response.status === 410) {
+        return null;
+      }
+      if (response.status === 422) {
+        return response.json().then(data => {
+          alert(data.error + ". Relax the rules and shuffle again.");
+          return null;
+        });
+      }
+      return response.json();
+    })
+    .then(data => {
+      if (data) {
+        applyShuffle(data.pending ? { pending: true, job: job } : data);
+      }
+    })
+    .catch(err => console.error("Board job error:", err));
+}
+
 /**
  * Set board to classic mode or shuffle existing classic board
  */
 function setClassic() {
   fetch('/setclassic')
     .then(response => response.json())
-    .then(data => {
-      if (!data.extension) {
-        extension = false;
-        updateStates(data);
-      }
-    })
+    .then(applyShuffle)
     .catch(err => console.error("Set classic error:", err));
 }
 
@@ -126,12 +255,7 @@ function setClassic() {
 function setExtension() {
   fetch('/setextension')
     .then(response => response.json())
-    .then(data => {
-      if (data.extension) {
-        extension = true;
-        updateStates(data);
-      }
-    })
+    .then(applyShuffle)
     .catch(err => console.error("Set extension error:", err));
 }
 
@@ -144,15 +268,18 @@ function setExtension() {
  *   - resources: array of resource IDs
  *   - numbers: array of token values (with desert hexes as 0)
  *   - extension: boolean indicating board mode
+ *   - rows: optional hexes per row, sent when a scenario map replaces the board
  */
 function generateBoard(boardData) {
   const boardDiv = document.getElementById('board');
   boardDiv.innerHTML = ''; // Clear any existing content
 
-  // Determine row sizes based on board mode
-  const rowSizes = boardData.extension
-    ? [4, 5, 6, 6, 5, 4]  // Extension board layout
-    : [3, 4, 5, 4, 3];    // Classic board layout
+  // Determine row sizes based on board mode (a scenario map sends its own)
+  const rowSizes = boardData.rows
+    ? boardData.rows
+    : boardData.extension
+      ? [4, 5, 6, 6, 5, 4]  // Extension board layout
+      : [3, 4, 5, 4, 3];    // Classic board layout
 
   let hexIndex = 0;
   // Loop through each row
@@ -161,16 +288,16 @@ function generateBoard(boardData) {
     rowDiv.classList.add('row');
 
     // Apply offset to create proper hexagonal grid layout
-    if (boardData.extension && row < 3) {
+    if (!boardData.rows && boardData.extension && row < 3) {
       rowDiv.classList.add('offsetLeft');
     }
-    else if (boardData.extension && row >= 3) {
+    else if (!boardData.rows && boardData.extension && row >= 3) {
       rowDiv.classList.add('offsetRight');
     }
 
     // Loop through each hex in the row
     for (let col = 0; col < rowSizes[row]; col++) {
-      // Ensure we don't overrun the arrays
+      // Ensure we don't overrun the arrays (empty while the server has no board yet)
       if (hexIndex >= boardData.resources.length) break;
 
       const resourceId = boardData.resources[hexIndex];
@@ -285,6 +412,7 @@ function rollDice() {
 window.addEventListener('load', () => {
   loadElementValues();
   addSettingsListeners();
+  subscribeToState();
 });
 
 /**
@@ -303,6 +431,8 @@ function loadElementValues() {
   option3 = document.getElementById("option3");
   option4 = document.getElementById("option4");
   option5 = document.getElementById("option5");
+  minBalanceInput = document.getElementById("minBalance");
+  minBalanceValue = document.getElementById("minBalanceValue");
   settingsModal = document.getElementById("settingsModal");
   closeSettingsBtn = document.getElementById("closeSettingsBtn");
 }
@@ -360,6 +490,15 @@ function addSettingsListeners() {
       .catch(err => console.error("Error updating sameResourceCanTouch:", err));
   });
 
+  // Minimum balance slider: show the value while dragging, send it on release
+  minBalanceInput.addEventListener("input", function () {
+    minBalanceValue.textContent = this.value;
+  });
+  minBalanceInput.addEventListener("change", function () {
+    fetch('/minBalance?value=' + this.value)
+      .catch(err => console.error("Error updating minBalance:", err));
+  });
+
   // Manual dice toggle
   option5.addEventListener("change", function () {
     let value = this.checked ? "1" : "0";
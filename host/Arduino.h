@@ -0,0 +1,57 @@
+/**
+ * Arduino.h (host shim)
+ *
+ * Minimal stand-in for the Arduino core used by the native build
+ * (env:native). It only provides what the board generator needs:
+ * fixed-width integer types and a Serial object for logging.
+ *
+ * Serial output is discarded unless HOST_SERIAL_STDOUT is defined,
+ * so logging does not distort benchmark timings.
+ */
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <iostream>
+
+/**
+ * HostSerial class
+ *
+ * Mimics the print/println interface of the Arduino Serial port
+ */
+class HostSerial
+{
+public:
+    template <typename T>
+    void print(const T &value)
+    {
+#ifdef HOST_SERIAL_STDOUT
+        std::cout << value;
+#else
+        (void)value;
+#endif
+    }
+
+    template <typename T>
+    void println(const T &value)
+    {
+#ifdef HOST_SERIAL_STDOUT
+        std::cout << value << '\n';
+#else
+        (void)value;
+#endif
+    }
+
+    void println()
+    {
+#ifdef HOST_SERIAL_STDOUT
+        std::cout << '\n';
+#endif
+    }
+};
+
+inline HostSerial Serial;
+
+#endif // HOST_ARDUINO_H
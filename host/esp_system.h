@@ -0,0 +1,25 @@
+/**
+ * esp_system.h (host shim)
+ *
+ * Replaces the ESP32 hardware random number generator with the
+ * host's random device for the native build (env:native).
+ */
+
+#ifndef HOST_ESP_SYSTEM_H
+#define HOST_ESP_SYSTEM_H
+
+#include <stdint.h>
+#include <random>
+
+/**
+ * Return a 32-bit random number
+ *
+ * @return Random value from std::random_device
+ */
+inline uint32_t esp_random()
+{
+    static std::random_device device;
+    return device();
+}
+
+#endif // HOST_ESP_SYSTEM_H
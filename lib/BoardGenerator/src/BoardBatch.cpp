@@ -0,0 +1,207 @@
+#include <stdio.h>
+#include "BoardBatch.h"
+#include "BoardRules.h"
+
+/**
+ * Order boards of the same size by their packed words
+ *
+ * @return True if a sorts before b
+ */
+static bool boardLess(const Board &a, const Board &b)
+{
+    for (int i = 0; i < BOARD_WORDS; i++)
+    {
+        if (a.cells[i] != b.cells[i])
+            return a.cells[i] < b.cells[i];
+    }
+    return false;
+}
+
+/**
+ * Canonical form of a board under its symmetries
+ * Every image is built hex by hex and the smallest one is kept
+ *
+ * @param board Board to reduce
+ * @param symmetry Symmetries of the board's shape
+ * @return Smallest image of the board (seed 0)
+ */
+Board canonicalBoard(const Board &board, const BoardSymmetry &symmetry)
+{
+    Board best = board;
+    best.seed = 0;
+    for (int s = 1; s < symmetry.count(); s++)
+    {
+        Board image;
+        image.reset(board.size());
+        for (int hex = 0; hex < board.size(); hex++)
+            image.setHex(symmetry.image(s, hex), board.resource(hex), board.number(hex));
+        if (boardLess(image, best))
+            best = image;
+    }
+    return best;
+}
+
+/**
+ * Constructor - allocate the table of seen boards
+ * The table keeps at most half of its slots in use
+ *
+ * @param config BoardConfig with desired generation rules
+ * @param count Number of boards wanted, at most BOARD_BATCH_MAX_COUNT
+ * @param seed Seed of the first board
+ */
+BoardBatch::BoardBatch(const BoardConfig &config, uint32_t count, uint64_t seed)
+    : config(config), count(count < BOARD_BATCH_MAX_COUNT ? count : BOARD_BATCH_MAX_COUNT), seed(seed), attempts(0),
+      producedCount(0), duplicateCount(0), lastHash(0),
+      symmetry(boardLayout(config.isExtension).adjacency, boardLayout(config.isExtension).hexCount)
+{
+    // Sized in 64 bits, so no product can wrap whatever the count
+    maxAttempts = (uint64_t)this->count * BOARD_BATCH_ATTEMPT_FACTOR + BOARD_BATCH_MIN_ATTEMPTS;
+    uint64_t slots = 1;
+    while (slots < 2 * (uint64_t)this->count)
+        slots <<= 1;
+    capacity = slots;
+    seen = new uint32_t[capacity]();
+}
+
+/**
+ * Destructor - free the table of seen boards
+ */
+BoardBatch::~BoardBatch()
+{
+    delete[] seen;
+}
+
+/**
+ * Generate the next distinct board
+ *
+ * @param board Output board, with its seed
+ * @param stats Optional output for the search effort spent on this board
+ * @return False once count boards were produced, or the rule set
+ *         seems to have no more distinct boards or no board at all
+ */
+bool BoardBatch::next(Board &board, GenerationStats *stats)
+{
+    while (producedCount < count && attempts < maxAttempts)
+    {
+        uint64_t boardSeed = seed + (uint64_t)attempts * 0x9E3779B97F4A7C15ULL;
+        attempts++;
+
+        Board candidate = generateBoard(config, boardSeed, stats);
+        if (candidate.empty())
+        {
+            // No board fits these rules at all: further seeds won't help
+            attempts = maxAttempts;
+            break;
+        }
+        uint32_t hash = canonicalBoard(candidate, symmetry).hash();
+        if (!insert(hash))
+        {
+            duplicateCount++;
+            continue;
+        }
+
+        board = candidate;
+        lastHash = hash;
+        producedCount++;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Number of boards handed out so far
+ */
+uint32_t BoardBatch::produced() const
+{
+    return producedCount;
+}
+
+/**
+ * Number of generated boards dropped as duplicates
+ */
+uint32_t BoardBatch::duplicates() const
+{
+    return duplicateCount;
+}
+
+/**
+ * True if the batch stopped before reaching the requested count
+ */
+bool BoardBatch::exhausted() const
+{
+    return producedCount < count && attempts >= maxAttempts;
+}
+
+/**
+ * Hash of the canonical form of the last board handed out
+ */
+uint32_t BoardBatch::canonicalHash() const
+{
+    return lastHash;
+}
+
+/**
+ * Remember a canonical hash (linear probing, 0 marks a free slot)
+ *
+ * @param hash Hash of a canonical board
+ * @return False if the hash was already known
+ */
+bool BoardBatch::insert(uint32_t hash)
+{
+    if (hash == 0)
+        hash = 1;
+    uint32_t slot = hash & (capacity - 1);
+    while (seen[slot] != 0)
+    {
+        if (seen[slot] == hash)
+            return false;
+        slot = (slot + 1) & (capacity - 1);
+    }
+    seen[slot] = hash;
+    return true;
+}
+
+/**
+ * Format a board as one line of newline-delimited JSON
+ *
+ * @param board Board to format
+ * @param index Position of the board in the batch
+ * @param canonical Hash of the board's canonical form
+ * @param balance Balance score of the board
+ * @param buffer Output buffer (BOARD_BATCH_LINE_SIZE bytes are enough)
+ * @param size Size of the output buffer
+ * @return Length of the line, newline included
+ */
+int formatBatchLine(const Board &board, uint32_t index, uint32_t canonical, float balance, char *buffer, size_t size)
+{
+    size_t length = snprintf(buffer, size, "{\"index\":%lu,\"seed\":\"%08lx%08lx\",\"canonical\":\"%08lx\",\"balance\":%d,\"resources\":[",
+                             (unsigned long)index, (unsigned long)(board.seed >> 32), (unsigned long)(board.seed & 0xFFFFFFFF),
+                             (unsigned long)canonical, (int)(balance + 0.5f));
+    for (int hex = 0; hex < board.size() && length < size; hex++)
+        length += snprintf(buffer + length, size - length, hex == 0 ? "%d" : ",%d", board.resource(hex));
+    if (length < size)
+        length += snprintf(buffer + length, size - length, "],\"numbers\":[");
+    for (int hex = 0; hex < board.size() && length < size; hex++)
+        length += snprintf(buffer + length, size - length, hex == 0 ? "%d" : ",%d", board.number(hex));
+    if (length < size)
+        length += snprintf(buffer + length, size - length, "]}\n");
+    return length < size ? (int)length : (int)size - 1;
+}
+
+/**
+ * Format the closing line of a batch
+ *
+ * @param batch Finished batch
+ * @param seconds Wall time spent on the batch
+ * @param buffer Output buffer (BOARD_BATCH_LINE_SIZE bytes are enough)
+ * @param size Size of the output buffer
+ * @return Length of the line, newline included
+ */
+int formatBatchSummary(const BoardBatch &batch, double seconds, char *buffer, size_t size)
+{
+    double rate = seconds > 0 ? batch.produced() / seconds : 0;
+    int length = snprintf(buffer, size, "{\"done\":true,\"boards\":%lu,\"duplicates\":%lu,\"exhausted\":%s,\"seconds\":%.3f,\"boardsPerSecond\":%.1f}\n",
+                          (unsigned long)batch.produced(), (unsigned long)batch.duplicates(),
+                          batch.exhausted() ? "true" : "false", seconds, rate);
+    return length < (int)size ? length : (int)size - 1;
+}
@@ -0,0 +1,149 @@
+/**
+ * BoardBatch.h
+ *
+ * Generation of board packs: many distinct boards for one rule set.
+ *
+ * Two boards count as the same when a rotation or reflection of the
+ * board turns one into the other. Each board is reduced to a canonical
+ * form (the smallest of its images under the board symmetries) and only
+ * the 32-bit hash of that form is remembered, in a table sized once for
+ * the whole batch. Boards are handed out one at a time so callers can
+ * stream them (see formatBatchLine for the newline-delimited JSON used
+ * by the host tool and the /batch endpoint).
+ *
+ * Board i of a batch is generated from seed + i * 0x9E3779B97F4A7C15, so
+ * every board can be regenerated from its own seed and the whole batch
+ * from its first seed. Two distinct boards sharing a hash are rare and
+ * only cost one extra attempt.
+ */
+
+#ifndef BOARDBATCH_H
+#define BOARDBATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "BoardGenerator.h"
+#include "BoardSymmetry.h"
+
+#define BOARD_BATCH_ATTEMPT_FACTOR 4 // Attempts per requested board before a batch gives up
+#define BOARD_BATCH_MIN_ATTEMPTS 64  // Attempts every batch gets, however small
+#define BOARD_BATCH_LINE_SIZE 320    // Buffer large enough for one formatted line
+#define BOARD_BATCH_MAX_COUNT 1048576 // Most boards in one batch (its table of seen boards takes 8 bytes per board)
+
+/**
+ * Canonical form of a board under its symmetries
+ *
+ * @param board Board to reduce
+ * @param symmetry Symmetries of the board's shape
+ * @return Smallest image of the board (seed 0)
+ */
+Board canonicalBoard(const Board &board, const BoardSymmetry &symmetry);
+
+/**
+ * BoardBatch class
+ *
+ * Produces up to a given number of boards, no two of them equal up to
+ * rotation or reflection
+ */
+class BoardBatch
+{
+public:
+    /**
+     * Constructor - allocate the table of seen boards
+     *
+     * @param config BoardConfig with desired generation rules
+     * @param count Number of boards wanted, clamped to BOARD_BATCH_MAX_COUNT
+     * @param seed Seed of the first board
+     */
+    BoardBatch(const BoardConfig &config, uint32_t count, uint64_t seed);
+
+    /**
+     * Destructor - free the table of seen boards
+     */
+    ~BoardBatch();
+
+    BoardBatch(const BoardBatch &) = delete;
+    BoardBatch &operator=(const BoardBatch &) = delete;
+
+    /**
+     * Generate the next distinct board
+     *
+     * @param board Output board, with its seed
+     * @param stats Optional output for the search effort spent on this board
+     * @return False once count boards were produced, or the rule set
+     *         seems to have no more distinct boards or no board at all
+     */
+    bool next(Board &board, GenerationStats *stats = nullptr);
+
+    /**
+     * Number of boards handed out so far
+     */
+    uint32_t produced() const;
+
+    /**
+     * Number of generated boards dropped as duplicates
+     */
+    uint32_t duplicates() const;
+
+    /**
+     * True if the batch stopped before reaching the requested count
+     */
+    bool exhausted() const;
+
+    /**
+     * Hash of the canonical form of the last board handed out
+     */
+    uint32_t canonicalHash() const;
+
+private:
+    BoardConfig config;      // Rules of every board
+    uint32_t count;          // Boards wanted
+    uint64_t seed;           // Seed of the first board
+    uint32_t attempts;       // Boards generated so far, duplicates included
+    uint32_t maxAttempts;    // Attempts before giving up
+    uint32_t producedCount;  // Distinct boards handed out
+    uint32_t duplicateCount; // Boards dropped as duplicates
+    uint32_t lastHash;       // Canonical hash of the last board handed out
+    BoardSymmetry symmetry;  // Symmetries of the board shape
+    uint32_t *seen;          // Open-addressing table of canonical hashes (0 = empty)
+    uint32_t capacity;       // Table slots, a power of two
+
+    /**
+     * Remember a canonical hash
+     *
+     * @param hash Hash of a canonical board
+     * @return False if the hash was already known
+     */
+    bool insert(uint32_t hash);
+};
+
+/**
+ * Format a board as one line of newline-delimited JSON
+ *
+ * {"index":0,"seed":"<16 hex digits>","canonical":"<8 hex digits>",
+ *  "balance":<0-100>,"resources":[...],"numbers":[...]}
+ *
+ * @param board Board to format
+ * @param index Position of the board in the batch
+ * @param canonical Hash of the board's canonical form
+ * @param balance Balance score of the board
+ * @param buffer Output buffer (BOARD_BATCH_LINE_SIZE bytes are enough)
+ * @param size Size of the output buffer
+ * @return Length of the line, newline included
+ */
+int formatBatchLine(const Board &board, uint32_t index, uint32_t canonical, float balance, char *buffer, size_t size);
+
+/**
+ * Format the closing line of a batch
+ *
+ * {"done":true,"boards":N,"duplicates":D,"exhausted":false,"seconds":S,"boardsPerSecond":R}
+ *
+ * @param batch Finished batch
+ * @param seconds Wall time spent on the batch
+ * @param buffer Output buffer (BOARD_BATCH_LINE_SIZE bytes are enough)
+ * @param size Size of the output buffer
+ * @return Length of the line, newline included
+ */
+int formatBatchSummary(const BoardBatch &batch, double seconds, char *buffer, size_t size);
+
+#endif // BOARDBATCH_H
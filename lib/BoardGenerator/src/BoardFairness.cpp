@@ -0,0 +1,213 @@
+#include <stdlib.h>
+#include "BoardFairness.h"
+
+/**
+ * Pips of a token value (ways to roll it with two dice)
+ *
+ * @param number Token value (2-12), 0 for no token
+ * @return Pips, 0 for no token
+ */
+int tokenPips(int number)
+{
+    if (number < 2 || number > 12)
+        return 0;
+    return 6 - abs(7 - number);
+}
+
+/**
+ * Constructor
+ *
+ * @param topology Vertices of the board
+ */
+BoardFairness::BoardFairness(const BoardTopology &topology) : topology(topology), tokenHexes(1)
+{
+    for (int type = 0; type < RESOURCE_TYPES; type++)
+        fairShare[type] = 0;
+    reset();
+}
+
+/**
+ * Set the piece pools the fair shares are taken from
+ *
+ * A resource's fair share is its hex count times the average pips per
+ * token, kept multiplied by the number of token hexes to stay integral.
+ *
+ * @param resourceCounts Number of hexes of each resource type
+ * @param tokenCounts Number of tokens of each value, ordered as TOKEN_VALUES
+ */
+void BoardFairness::setPools(const int *resourceCounts, const int *tokenCounts)
+{
+    int totalPips = 0;
+    for (int i = 0; i < TOKEN_TYPES; i++)
+        totalPips += tokenCounts[i] * tokenPips(TOKEN_VALUES[i]);
+    tokenHexes = topology.hexCount - resourceCounts[RESOURCE_DESERT];
+    for (int type = 0; type < RESOURCE_TYPES; type++)
+        fairShare[type] = (type == RESOURCE_DESERT) ? 0 : totalPips * resourceCounts[type];
+    reset();
+}
+
+/**
+ * Empty every hex
+ */
+void BoardFairness::reset()
+{
+    for (int hex = 0; hex < topology.hexCount; hex++)
+    {
+        resource[hex] = -1;
+        pips[hex] = -1;
+    }
+    for (int vertex = 0; vertex < topology.vertexCount; vertex++)
+        vertexPips[vertex] = 0;
+    for (int type = 0; type < RESOURCE_TYPES; type++)
+        production[type] = 0;
+    excess = 0;
+    hotspotExcess = 0;
+}
+
+/**
+ * Add or take away the production of a hex whose two layers are set
+ * Keeps the running excess over the fair shares in step
+ */
+void BoardFairness::addProduction(int hex, int sign)
+{
+    int type = resource[hex];
+    if (type == RESOURCE_DESERT)
+        return;
+
+    int before = production[type] * tokenHexes - fairShare[type];
+    production[type] += sign * pips[hex];
+    int after = production[type] * tokenHexes - fairShare[type];
+    excess += (after > 0 ? after : 0) - (before > 0 ? before : 0);
+}
+
+/**
+ * Fill one layer of a hex
+ *
+ * @param hex Hex index
+ * @param layer 0 for the resource, 1 for the token
+ * @param value Resource ID, or token index (TOKEN_NONE on deserts)
+ */
+void BoardFairness::place(int hex, int layer, int value)
+{
+    if (layer == 0)
+    {
+        resource[hex] = value;
+    }
+    else
+    {
+        int p = (value == TOKEN_NONE) ? 0 : tokenPips(TOKEN_VALUES[value]);
+        pips[hex] = p;
+        for (int corner = 0; corner < 6; corner++)
+        {
+            uint8_t &total = vertexPips[topology.hexVertices[hex][corner]];
+            int before = total > BOARD_HOTSPOT_PIPS ? total - BOARD_HOTSPOT_PIPS : 0;
+            total += p;
+            int after = total > BOARD_HOTSPOT_PIPS ? total - BOARD_HOTSPOT_PIPS : 0;
+            hotspotExcess += after - before;
+        }
+    }
+
+    if (resource[hex] != -1 && pips[hex] != -1)
+        addProduction(hex, 1);
+}
+
+/**
+ * Empty one layer of a hex again
+ *
+ * @param hex Hex index
+ * @param layer 0 for the resource, 1 for the token
+ */
+void BoardFairness::remove(int hex, int layer)
+{
+    if (resource[hex] != -1 && pips[hex] != -1)
+        addProduction(hex, -1);
+
+    if (layer == 0)
+    {
+        resource[hex] = -1;
+    }
+    else
+    {
+        int p = pips[hex];
+        for (int corner = 0; corner < 6; corner++)
+        {
+            uint8_t &total = vertexPips[topology.hexVertices[hex][corner]];
+            int before = total > BOARD_HOTSPOT_PIPS ? total - BOARD_HOTSPOT_PIPS : 0;
+            total -= p;
+            int after = total > BOARD_HOTSPOT_PIPS ? total - BOARD_HOTSPOT_PIPS : 0;
+            hotspotExcess += after - before;
+        }
+        pips[hex] = -1;
+    }
+}
+
+/**
+ * Balance score of the board so far
+ *
+ * @return Score from 0 to 100, an upper bound for every completion
+ */
+float BoardFairness::balance() const
+{
+    float score = 100.0f - BALANCE_EXCESS_WEIGHT * (float)excess / tokenHexes -
+                  BALANCE_HOTSPOT_WEIGHT * hotspotExcess;
+    return score > 0 ? score : 0;
+}
+
+/**
+ * Number of vertices on the board
+ */
+int BoardFairness::vertexCount() const
+{
+    return topology.vertexCount;
+}
+
+/**
+ * Fill in the metrics of the board so far
+ *
+ * @param score Output metrics
+ */
+void BoardFairness::report(BoardScore &score) const
+{
+    score.balance = balance();
+    score.vertexCount = topology.vertexCount;
+    score.hotspots = 0;
+    score.maxVertexPips = 0;
+    for (int vertex = 0; vertex < topology.vertexCount; vertex++)
+    {
+        score.vertexPips[vertex] = vertexPips[vertex];
+        if (vertexPips[vertex] > BOARD_HOTSPOT_PIPS)
+            score.hotspots++;
+        if (vertexPips[vertex] > score.maxVertexPips)
+            score.maxVertexPips = vertexPips[vertex];
+    }
+    for (int type = 0; type < RESOURCE_TYPES; type++)
+        score.resourcePips[type] = production[type];
+}
+
+/**
+ * Score a finished board
+ *
+ * @param board Board to score
+ * @return Fairness metrics
+ */
+BoardScore scoreBoard(const Board &board)
+{
+    const BoardLayout &layout = boardLayout(board.size() == boardLayout(true).hexCount);
+    BoardFairness fairness(*layout.topology);
+    fairness.setPools(layout.resourceCounts, layout.tokenCounts);
+    for (int hex = 0; hex < board.size(); hex++)
+    {
+        int token = TOKEN_NONE;
+        for (int i = 0; i < TOKEN_TYPES; i++)
+        {
+            if (TOKEN_VALUES[i] == board.number(hex))
+                token = i;
+        }
+        fairness.place(hex, 0, board.resource(hex));
+        fairness.place(hex, 1, token);
+    }
+
+    BoardScore score;
+    fairness.report(score);
+    return score;
+}
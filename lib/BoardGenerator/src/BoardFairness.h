@@ -0,0 +1,147 @@
+/**
+ * BoardFairness.h
+ *
+ * Fairness scoring of Catan boards.
+ *
+ * Every number token is worth its pips, the number of ways two dice roll
+ * it (1 for 2 and 12, up to 5 for 6 and 8). From the pips the scoring
+ * derives:
+ *   - the pip total of every vertex (settlement spot), the sum over the
+ *     up to three hexes touching it;
+ *   - the expected production of each resource, the pips of its hexes;
+ *   - hotspots, vertices above BOARD_HOTSPOT_PIPS;
+ *   - a balance score from 0 to 100.
+ *
+ * The balance score starts at 100 and loses points for production that
+ * a resource gets beyond its fair share (its hex count times the average
+ * pips per hex) and for every pip a hotspot holds above the limit. Both
+ * penalties only grow as hexes are filled in, so the score of a partial
+ * board is an upper bound on the score of every completion: the solver
+ * keeps a tracker up to date while it assigns hexes and prunes as soon
+ * as the bound falls below BoardConfig::minBalance.
+ */
+
+#ifndef BOARDFAIRNESS_H
+#define BOARDFAIRNESS_H
+
+#include <stdint.h>
+#include "BoardGenerator.h"
+#include "BoardRules.h"
+
+#define BOARD_HOTSPOT_PIPS 11    // Vertices with more pips are hotspots
+#define BALANCE_EXCESS_WEIGHT 2  // Points lost per pip of production above a fair share
+#define BALANCE_HOTSPOT_WEIGHT 5 // Points lost per hotspot pip above BOARD_HOTSPOT_PIPS
+
+/**
+ * BoardScore structure
+ *
+ * Fairness metrics of one board.
+ */
+struct BoardScore
+{
+    float balance = 0;                              // Balance score, 0 (worst) to 100 (best)
+    uint8_t vertexCount = 0;                        // Vertices on the board
+    uint8_t vertexPips[TOPOLOGY_MAX_VERTICES] = {}; // Pip total of each vertex, indexed as in BoardTopology
+    uint8_t resourcePips[RESOURCE_TYPES] = {};      // Expected production of each resource, in pips per 36 rolls
+    uint8_t hotspots = 0;                           // Vertices above BOARD_HOTSPOT_PIPS
+    uint8_t maxVertexPips = 0;                      // Best vertex
+};
+
+/**
+ * BoardFairness class
+ *
+ * Incremental fairness tracker. Hexes are filled and emptied one layer
+ * at a time, in any order, and the metrics follow in constant time.
+ */
+class BoardFairness
+{
+public:
+    /**
+     * Constructor
+     *
+     * @param topology Vertices of the board
+     */
+    explicit BoardFairness(const BoardTopology &topology);
+
+    /**
+     * Set the piece pools the fair shares are taken from
+     *
+     * @param resourceCounts Number of hexes of each resource type (RESOURCE_TYPES entries)
+     * @param tokenCounts Number of tokens of each value, ordered as TOKEN_VALUES
+     */
+    void setPools(const int *resourceCounts, const int *tokenCounts);
+
+    /**
+     * Empty every hex
+     */
+    void reset();
+
+    /**
+     * Fill one layer of a hex
+     *
+     * @param hex Hex index
+     * @param layer 0 for the resource, 1 for the token
+     * @param value Resource ID, or token index (TOKEN_NONE on deserts)
+     */
+    void place(int hex, int layer, int value);
+
+    /**
+     * Empty one layer of a hex again
+     *
+     * @param hex Hex index
+     * @param layer 0 for the resource, 1 for the token
+     */
+    void remove(int hex, int layer);
+
+    /**
+     * Balance score of the board so far
+     * An upper bound on the balance of every completion
+     */
+    float balance() const;
+
+    /**
+     * Number of vertices on the board
+     */
+    int vertexCount() const;
+
+    /**
+     * Fill in the metrics of the board so far
+     *
+     * @param score Output metrics
+     */
+    void report(BoardScore &score) const;
+
+private:
+    const BoardTopology &topology;               // Vertices of the board
+    int16_t fairShare[RESOURCE_TYPES];           // Fair production of each resource, times tokenHexes
+    int tokenHexes;                              // Hexes carrying a token
+    int8_t resource[BOARD_MAX_HEXES];            // Resource of each hex (-1 if empty)
+    int8_t pips[BOARD_MAX_HEXES];                // Pips of each hex's token (-1 if empty)
+    uint8_t vertexPips[TOPOLOGY_MAX_VERTICES];   // Pips around each vertex so far
+    uint8_t production[RESOURCE_TYPES];          // Pips of each resource so far
+    int excess;                                  // Production above the fair shares, times tokenHexes
+    int hotspotExcess;                           // Hotspot pips above the limit
+
+    /**
+     * Add or take away the production of a hex whose two layers are set
+     */
+    void addProduction(int hex, int sign);
+};
+
+/**
+ * Pips of a token value (ways to roll it with two dice)
+ *
+ * @param number Token value (2-12), 0 for no token
+ * @return Pips, 0 for no token
+ */
+int tokenPips(int number);
+
+/**
+ * Score a finished board
+ *
+ * @param board Board to score
+ * @return Fairness metrics
+ */
+BoardScore scoreBoard(const Board &board);
+
+#endif // BOARDFAIRNESS_H
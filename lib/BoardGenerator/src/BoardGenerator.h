@@ -9,22 +9,134 @@
 #define BOARDGENERATOR_H
 
 #include <Arduino.h>
+#include <atomic>
 #include <vector>
+#include "BoardRng.h"
+
+#define BOARD_MAX_HEXES 30     // Hexes on the largest board (extension)
+#define BOARD_HEX_BITS 7       // Bits per hex: 3 for the resource, 4 for the token
+#define BOARD_HEXES_PER_WORD 9 // Hexes packed into each 64-bit word
+#define BOARD_WORDS ((BOARD_MAX_HEXES + BOARD_HEXES_PER_WORD - 1) / BOARD_HEXES_PER_WORD)
+
+#define BOARD_BALANCE_ATTEMPTS 4 // Exhausted solves before an unreachable minBalance is dropped
+#define BOARD_MAX_ATTEMPTS 16    // Exhausted solves before generation gives up with an empty board
+
+#define BOARD_SOLVER_STACK_SIZE 12288 // Stack of any ESP32 task that generates boards (solver recursion needs ~10 KB)
+
+#define BOARD_PORTFOLIO_MAX_WORKERS 16                     // Most searches raced by generateBoardPortfolio
+#define BOARD_PORTFOLIO_STACK_SIZE BOARD_SOLVER_STACK_SIZE // Stack of each extra worker on the ESP32
 
 /**
  * Board structure
  *
  * Encapsulates the complete board configuration with
  * resource types and number tokens for each hex.
+ *
+ * Each hex takes 7 bits (resource in the low 3, token value in the high
+ * 4) and nine hexes share a 64-bit word, so a whole board is a fixed
+ * 48-byte value without heap blocks: cheap to copy into pools, histories
+ * and hash sets.
  */
 struct Board
 {
-    std::vector<int> resources; // Resource values for each hex
-                                // 0=sheep, 1=wood, 2=wheat, 3=brick, 4=ore, 5=desert
+    uint64_t cells[BOARD_WORDS] = {}; // Packed hexes, BOARD_HEXES_PER_WORD per word
+    uint8_t hexCount = 0;             // Hexes on the board, 0 while no board is loaded
+    uint64_t seed = 0;                // Seed that regenerates this board with the same BoardConfig
+
+    Board() = default;
+
+    /**
+     * Build a board from one resource and one token vector
+     *
+     * @param resources Resource per hex: 0=sheep, 1=wood, 2=wheat, 3=brick, 4=ore, 5=desert
+     * @param numbers Token value per hex (2-12, 0 on deserts)
+     */
+    Board(const std::vector<int> &resources, const std::vector<int> &numbers);
+
+    /**
+     * Number of hexes on the board
+     */
+    int size() const
+    {
+        return hexCount;
+    }
+
+    /**
+     * Whether no board is loaded
+     */
+    bool empty() const
+    {
+        return hexCount == 0;
+    }
+
+    /**
+     * Resource on a hex (0=sheep, 1=wood, 2=wheat, 3=brick, 4=ore, 5=desert)
+     */
+    int resource(int hex) const
+    {
+        return (cells[hex / BOARD_HEXES_PER_WORD] >> ((hex % BOARD_HEXES_PER_WORD) * BOARD_HEX_BITS)) & 0x7;
+    }
+
+    /**
+     * Token value on a hex (2-12, 0 on deserts)
+     */
+    int number(int hex) const
+    {
+        return (cells[hex / BOARD_HEXES_PER_WORD] >> ((hex % BOARD_HEXES_PER_WORD) * BOARD_HEX_BITS + 3)) & 0xF;
+    }
+
+    /**
+     * Set the resource and token of a hex
+     * Values are masked to their 3 and 4 bits
+     */
+    void setHex(int hex, int resource, int number)
+    {
+        int shift = (hex % BOARD_HEXES_PER_WORD) * BOARD_HEX_BITS;
+        uint64_t bits = (uint64_t)((resource & 0x7) | ((number & 0xF) << 3)) << shift;
+        uint64_t &word = cells[hex / BOARD_HEXES_PER_WORD];
+        word = (word & ~((uint64_t)0x7F << shift)) | bits;
+    }
+
+    /**
+     * Clear the board and give it a number of hexes
+     *
+     * @param count Hex count, at most BOARD_MAX_HEXES
+     */
+    void reset(int count);
 
-    std::vector<int> numbers; // Number tokens for each hex
-                              // Values 2-12 represent token numbers
-                              // Desert hexes have value 0
+    /**
+     * Unpack into one resource and one token vector
+     *
+     * @param resources Output resource per hex
+     * @param numbers Output token value per hex
+     */
+    void toVectors(std::vector<int> &resources, std::vector<int> &numbers) const;
+
+    /**
+     * Hash of the layout (the seed is not included)
+     */
+    uint32_t hash() const;
+
+    /**
+     * Same size, resources and tokens (the seed is not compared)
+     */
+    bool operator==(const Board &other) const;
+
+    bool operator!=(const Board &other) const
+    {
+        return !(*this == other);
+    }
+};
+
+/**
+ * Hash functor for keeping boards in unordered containers
+ */
+struct BoardHash
+{
+    size_t operator()(const Board &board) const
+    {
+        return board.hash();
+    }
 };
 
 /**
@@ -40,17 +152,94 @@ struct BoardConfig
     bool twoTwelveCanTouch = false;    // Whether 2 and 12 tokens can be adjacent
     bool sameNumbersCanTouch = false;  // Whether identical numbers can be adjacent
     bool sameResourceCanTouch = false; // Whether identical resources can be adjacent
+
+    uint16_t numberFailureLimit = 100; // Token dead ends before starting over with a fresh resource layout
+    uint8_t minBalance = 0;            // Lowest balance score (0-100, see BoardFairness.h) a board may have, 0 for any
+};
+
+/**
+ * GenerationStats structure
+ *
+ * Reports how much search work went into a generated board.
+ */
+struct GenerationStats
+{
+    uint32_t nodes = 0;          // Resource and token assignments tried
+    uint32_t numberFailures = 0; // Token dead ends hit
+    uint16_t restarts = 0;       // Times the search started over with a fresh layout
+    float balance = 0;           // Balance score of the board (0-100)
+    bool infeasible = false;     // No board satisfies the rules (the board returned is empty)
 };
 
 /**
  * Generates a complete Catan board configuration
  *
  * Creates a randomized board that respects the specified configuration rules
- * for both resource placement and number token assignment.
+ * for both resource placement and number token assignment. The seed is
+ * drawn from the hardware random number generator and stored in the board.
+ *
+ * @param config BoardConfig with desired generation rules
+ * @param stats Optional output for the search effort spent on this board
+ * @return Board object containing the generated board layout, empty if no
+ *         board was found (see BOARD_MAX_ATTEMPTS and GenerationStats::infeasible)
+ */
+Board generateBoard(const BoardConfig &config, GenerationStats *stats = nullptr);
+
+/**
+ * Generates a reproducible Catan board configuration
+ *
+ * The same seed and BoardConfig always produce the same board, so a
+ * board can be shared and regenerated from its seed.
+ *
+ * @param config BoardConfig with desired generation rules
+ * @param seed 64-bit seed, stored in the returned board
+ * @param stats Optional output for the search effort spent on this board
+ * @return Board object containing the generated board layout, empty if no
+ *         board was found
+ */
+Board generateBoard(const BoardConfig &config, uint64_t seed, GenerationStats *stats = nullptr);
+
+/**
+ * Generates a Catan board configuration from an injected random generator
+ *
+ * @param config BoardConfig with desired generation rules
+ * @param rng Random generator driving every choice of the generator
+ * @param stats Optional output for the search effort spent on this board
+ * @param cancel Optional flag another thread sets to stop the search
+ * @return Board object containing the generated board layout (seed left at 0),
+ *         or an empty board if the search was cancelled or found no board
+ */
+Board generateBoard(const BoardConfig &config, BoardRng &rng, GenerationStats *stats = nullptr,
+                    const std::atomic<bool> *cancel = nullptr);
+
+/**
+ * Generates a Catan board by racing independent searches
+ *
+ * Solve times of strict rule sets have a long tail, so several searches
+ * with different seeds run at once (one per core on the ESP32, on
+ * threads on the host) and the first board found wins; the others are
+ * cancelled. Worker 0 runs on the calling task. The returned board
+ * carries the winner's seed, so generateBoard(config, board.seed)
+ * reproduces it.
+ *
+ * @param config BoardConfig with desired generation rules
+ * @param seed Seed of worker 0; the other workers derive theirs from it
+ * @param workers Number of searches (1 to BOARD_PORTFOLIO_MAX_WORKERS)
+ * @param stats Optional output for the search effort of the winning search
+ * @return Board object containing the generated board layout, empty if no
+ *         search found a board
+ */
+Board generateBoardPortfolio(const BoardConfig &config, uint64_t seed, int workers, GenerationStats *stats = nullptr);
+
+/**
+ * Generates a Catan board by racing independent searches from a fresh random seed
  *
  * @param config BoardConfig with desired generation rules
- * @return Board object containing the generated board layout
+ * @param workers Number of searches (1 to BOARD_PORTFOLIO_MAX_WORKERS)
+ * @param stats Optional output for the search effort of the winning search
+ * @return Board object containing the generated board layout, empty if no
+ *         search found a board
  */
-Board generateBoard(const BoardConfig &config);
+Board generateBoardPortfolio(const BoardConfig &config, int workers, GenerationStats *stats = nullptr);
 
 #endif // BOARDGENERATOR_H
\ No newline at end of file
@@ -0,0 +1,107 @@
+/**
+ * BoardGeometry.h
+ *
+ * Compile-time description of each supported board.
+ *
+ * A geometry trait bundles everything the generator needs to know about
+ * one board: its hex count, neighbour table, vertex/edge topology and
+ * piece pools. The solver is a template over the trait, so every board
+ * size gets its own fixed-size solver whose loop bounds and table
+ * addresses are constants.
+ *
+ * Adding a built-in board means adding its adjacency table, a trait
+ * below, an instantiation line at the end of BoardSolver.cpp and a case
+ * where generateBoard picks the trait. Scenario maps do not need a
+ * rebuild: they are loaded from flash into MapGeometry (BoardMap.h).
+ */
+
+#ifndef BOARDGEOMETRY_H
+#define BOARDGEOMETRY_H
+
+#include "BoardMap.h"
+#include "BoardRules.h"
+#include "BoardTopology.h"
+#include "adjancency.h"
+
+/**
+ * Classic 19-hex board for 3-4 players
+ *
+ * 4 sheep, 4 wood, 4 wheat, 3 brick, 3 ore, 1 desert
+ * Tokens 2, 3, 4, 5, 6, 8, 9, 10, 11, 12: one 2 and 12, two of the others
+ */
+struct ClassicGeometry
+{
+    static constexpr int HEX_COUNT = 19;
+    static constexpr int hexCount() { return HEX_COUNT; }
+    static constexpr const int (*adjacency)[6] = adjacencyListClassic;
+    static constexpr const BoardTopology &topology = CLASSIC_TOPOLOGY;
+    static constexpr int resourceCounts[RESOURCE_TYPES] = {4, 4, 4, 3, 3, 1};
+    static constexpr int tokenCounts[TOKEN_TYPES] = {1, 2, 2, 2, 2, 2, 2, 2, 2, 1};
+};
+
+/**
+ * Extension 30-hex board for 5-6 players
+ *
+ * 6 sheep, 6 wood, 6 wheat, 5 brick, 5 ore, 2 deserts
+ * Tokens 2, 3, 4, 5, 6, 8, 9, 10, 11, 12: two 2s and 12s, three of the others
+ */
+struct ExtensionGeometry
+{
+    static constexpr int HEX_COUNT = 30;
+    static constexpr int hexCount() { return HEX_COUNT; }
+    static constexpr const int (*adjacency)[6] = adjacencyListExtension;
+    static constexpr const BoardTopology &topology = EXTENSION_TOPOLOGY;
+    static constexpr int resourceCounts[RESOURCE_TYPES] = {6, 6, 6, 5, 5, 2};
+    static constexpr int tokenCounts[TOKEN_TYPES] = {2, 3, 3, 3, 3, 3, 3, 3, 3, 2};
+};
+
+/**
+ * Map loaded from flash in place of the classic (Slot 0) or extension (Slot 1) board
+ *
+ * The tables are the arrays of boardMaps[Slot], so their addresses are
+ * still constants; only the hex count is read at runtime. HEX_COUNT is
+ * the largest map the arrays can hold. Pools are checked when the map
+ * is loaded (parseBoardMap).
+ */
+template <int Slot>
+struct MapGeometry
+{
+    static constexpr int HEX_COUNT = BOARD_MAX_HEXES;
+    static int hexCount() { return boardMaps[Slot].hexCount; }
+    static constexpr const int (*adjacency)[6] = boardMaps[Slot].adjacency;
+    static constexpr const BoardTopology &topology = boardMaps[Slot].topology;
+    static constexpr const int *resourceCounts = boardMaps[Slot].resourceCounts;
+    static constexpr const int *tokenCounts = boardMaps[Slot].tokenCounts;
+};
+
+/**
+ * Check the pools of a geometry: one resource hex per hex, one token per non-desert hex
+ */
+template <class Geometry>
+constexpr bool poolsMatch()
+{
+    int resources = 0;
+    int tokens = 0;
+    for (int type = 0; type < RESOURCE_TYPES; type++)
+        resources += Geometry::resourceCounts[type];
+    for (int i = 0; i < TOKEN_TYPES; i++)
+        tokens += Geometry::tokenCounts[i];
+    return resources == Geometry::HEX_COUNT &&
+           tokens == Geometry::HEX_COUNT - Geometry::resourceCounts[RESOURCE_DESERT] &&
+           Geometry::topology.hexCount == Geometry::HEX_COUNT;
+}
+
+static_assert(poolsMatch<ClassicGeometry>(), "Classic pools do not fill the board");
+static_assert(poolsMatch<ExtensionGeometry>(), "Extension pools do not fill the board");
+
+/**
+ * Runtime layout of a geometry, for code that handles any board size
+ */
+template <class Geometry>
+constexpr BoardLayout layoutOf()
+{
+    return {Geometry::HEX_COUNT, Geometry::adjacency, Geometry::resourceCounts, Geometry::tokenCounts,
+            &Geometry::topology};
+}
+
+#endif // BOARDGEOMETRY_H
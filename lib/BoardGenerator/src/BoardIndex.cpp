@@ -0,0 +1,115 @@
+#include <math.h>
+#include <string.h>
+#include "BoardIndex.h"
+#include "BoardFairness.h"
+
+/**
+ * Sort hexes by a key with one counting pass
+ * The number of key values is a template parameter, so every copy has a
+ * size known at compile time
+ *
+ * @tparam KeyCount Number of key values
+ * @param keys Key of each hex
+ * @param hexCount Number of hexes
+ * @param sorted Output hexes sorted by key, board order within a key
+ * @param start Output start of each key's run
+ */
+template <size_t KeyCount>
+static void sortByKey(const uint8_t *keys, int hexCount, uint8_t *sorted, uint8_t (&start)[KeyCount + 1])
+{
+    memset(start, 0, sizeof(start));
+    for (int hex = 0; hex < hexCount; hex++)
+        start[keys[hex] + 1]++;
+    for (size_t key = 0; key < KeyCount; key++)
+        start[key + 1] += start[key];
+
+    uint8_t next[KeyCount];
+    memcpy(next, start, sizeof(next));
+    for (int hex = 0; hex < hexCount; hex++)
+        sorted[next[keys[hex]]++] = hex;
+}
+
+/**
+ * Constructor - index of an empty board
+ */
+BoardIndex::BoardIndex()
+{
+    build(Board());
+}
+
+/**
+ * Rebuild the index for a board
+ * Values out of range are indexed as deserts
+ */
+void BoardIndex::build(const Board &board)
+{
+    hexCount = board.size();
+
+    uint8_t numbers[BOARD_MAX_HEXES] = {};
+    uint8_t resources[BOARD_MAX_HEXES] = {};
+    for (int hex = 0; hex < hexCount; hex++)
+    {
+        numbers[hex] = board.number(hex) < BOARD_NUMBER_VALUES ? board.number(hex) : 0;
+        resources[hex] = board.resource(hex) < RESOURCE_TYPES ? board.resource(hex) : RESOURCE_DESERT;
+    }
+    sortByKey<BOARD_NUMBER_VALUES>(numbers, hexCount, byNumber, numberStart);
+    sortByKey<RESOURCE_TYPES>(resources, hexCount, byResource, resourceStart);
+
+    balanceScore = board.empty() ? 0 : lroundf(scoreBoard(board).balance);
+}
+
+/**
+ * Number of hexes on the indexed board
+ */
+int BoardIndex::size() const
+{
+    return hexCount;
+}
+
+/**
+ * Number of hexes carrying a token value
+ */
+int BoardIndex::countNumber(int number) const
+{
+    if (number < 0 || number >= BOARD_NUMBER_VALUES)
+        return 0;
+    return numberStart[number + 1] - numberStart[number];
+}
+
+/**
+ * Hexes carrying a token value, in board order
+ */
+const uint8_t *BoardIndex::hexesWithNumber(int number) const
+{
+    if (number < 0 || number >= BOARD_NUMBER_VALUES)
+        return byNumber;
+    return byNumber + numberStart[number];
+}
+
+/**
+ * Number of hexes of a resource
+ */
+int BoardIndex::countResource(int resource) const
+{
+    if (resource < 0 || resource >= RESOURCE_TYPES)
+        return 0;
+    return resourceStart[resource + 1] - resourceStart[resource];
+}
+
+/**
+ * Hexes of a resource, in board order
+ */
+const uint8_t *BoardIndex::hexesOfResource(int resource) const
+{
+    if (resource < 0 || resource >= RESOURCE_TYPES)
+        return byResource;
+    return byResource + resourceStart[resource];
+}
+
+/**
+ * Balance score of the indexed board
+ */
+int BoardIndex::balance() const
+{
+    return balanceScore;
+}
@@ -0,0 +1,95 @@
+/**
+ * BoardIndex.h
+ *
+ * Inverted index of a finished board: the hexes carrying each token value
+ * and the hexes of each resource, plus the board's balance score.
+ *
+ * The index is built once whenever the board changes. Lighting the hexes
+ * of a roll, finding the deserts for the robber or counting what a resource
+ * produced then only visits the hexes concerned instead of scanning the
+ * whole board on every roll.
+ *
+ * Both lists are stored as one array of hex indices sorted by key, with
+ * the start of every key's run next to it, so the whole index is about a
+ * hundred bytes and never touches the heap.
+ */
+
+#ifndef BOARDINDEX_H
+#define BOARDINDEX_H
+
+#include <stdint.h>
+#include "BoardGenerator.h"
+#include "BoardRules.h"
+
+#define BOARD_NUMBER_VALUES 13 // Token values indexed: 0 (desert) to 12
+
+/**
+ * BoardIndex class
+ *
+ * Hexes of a board by token value and by resource
+ */
+class BoardIndex
+{
+public:
+    /**
+     * Constructor - index of an empty board
+     */
+    BoardIndex();
+
+    /**
+     * Rebuild the index for a board
+     *
+     * @param board Board to index
+     */
+    void build(const Board &board);
+
+    /**
+     * Number of hexes on the indexed board
+     */
+    int size() const;
+
+    /**
+     * Number of hexes carrying a token value
+     *
+     * @param number Token value (2-12, 0 for the deserts)
+     */
+    int countNumber(int number) const;
+
+    /**
+     * Hexes carrying a token value, in board order
+     *
+     * @param number Token value (2-12, 0 for the deserts)
+     * @return countNumber(number) hex indices
+     */
+    const uint8_t *hexesWithNumber(int number) const;
+
+    /**
+     * Number of hexes of a resource
+     *
+     * @param resource Resource ID (RESOURCE_DESERT for the deserts)
+     */
+    int countResource(int resource) const;
+
+    /**
+     * Hexes of a resource, in board order
+     *
+     * @param resource Resource ID (RESOURCE_DESERT for the deserts)
+     * @return countResource(resource) hex indices
+     */
+    const uint8_t *hexesOfResource(int resource) const;
+
+    /**
+     * Balance score of the indexed board (0-100, 0 without a board)
+     */
+    int balance() const;
+
+private:
+    uint8_t hexCount;                             // Hexes on the indexed board
+    uint8_t byNumber[BOARD_MAX_HEXES];            // Hexes sorted by token value
+    uint8_t numberStart[BOARD_NUMBER_VALUES + 1]; // Start of each value's run in byNumber
+    uint8_t byResource[BOARD_MAX_HEXES];          // Hexes sorted by resource
+    uint8_t resourceStart[RESOURCE_TYPES + 1];    // Start of each resource's run in byResource
+    uint8_t balanceScore;                         // Rounded balance score
+};
+
+#endif // BOARDINDEX_H
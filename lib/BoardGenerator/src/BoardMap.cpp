@@ -0,0 +1,133 @@
+#include "BoardMap.h"
+
+BoardMap boardMaps[2];
+static bool mapLoaded[2] = {false, false};
+
+static const uint8_t MAP_MAGIC[4] = {'C', 'M', 'A', 'P'};
+static const uint8_t MAP_NO_NEIGHBOR = 255;
+
+/**
+ * Parse and check a map file
+ *
+ * The bytes are read once, in file order, straight into the map arrays.
+ * The vertex/edge graph is then derived with the same code that builds
+ * the compiled-in topologies, which also rejects neighbour tables that
+ * are not a hex map.
+ *
+ * @param data File contents
+ * @param size File size in bytes
+ * @param map Output map, partly overwritten even if the file is rejected
+ * @return True if the file describes a valid board
+ */
+bool parseBoardMap(const uint8_t *data, size_t size, BoardMap &map)
+{
+    if (size < BOARD_MAP_HEADER_BYTES)
+        return false;
+    for (int i = 0; i < 4; i++)
+    {
+        if (data[i] != MAP_MAGIC[i])
+            return false;
+    }
+    if (data[4] != BOARD_MAP_VERSION)
+        return false;
+
+    map.hexCount = data[5];
+    map.ledCount = data[6];
+    map.rowCount = data[7];
+    if (map.hexCount < 1 || map.hexCount > BOARD_MAX_HEXES || map.ledCount < map.hexCount)
+        return false;
+    if (map.rowCount < 1 || map.rowCount > BOARD_MAP_MAX_ROWS)
+        return false;
+    size_t expected = BOARD_MAP_HEADER_BYTES + map.rowCount + 7 * map.hexCount + RESOURCE_TYPES + TOKEN_TYPES;
+    if (size != expected)
+        return false;
+
+    const uint8_t *p = data + BOARD_MAP_HEADER_BYTES;
+
+    // Rows of the web page drawing
+    int rowTotal = 0;
+    for (int row = 0; row < map.rowCount; row++)
+    {
+        map.rows[row] = *p++;
+        rowTotal += map.rows[row];
+    }
+    if (rowTotal != map.hexCount)
+        return false;
+
+    // Neighbour table
+    for (int hex = 0; hex < map.hexCount; hex++)
+    {
+        for (int slot = 0; slot < 6; slot++)
+        {
+            uint8_t neighbor = *p++;
+            if (neighbor != MAP_NO_NEIGHBOR && neighbor >= map.hexCount)
+                return false;
+            map.adjacency[hex][slot] = (neighbor == MAP_NO_NEIGHBOR) ? -1 : neighbor;
+        }
+    }
+
+    // LED of each hex, every LED used at most once
+    uint32_t usedLeds[256 / 32] = {};
+    for (int hex = 0; hex < map.hexCount; hex++)
+    {
+        uint8_t led = *p++;
+        if (led >= map.ledCount || (usedLeds[led / 32] & (1u << (led % 32))))
+            return false;
+        usedLeds[led / 32] |= 1u << (led % 32);
+        map.tileToLed[hex] = led;
+    }
+
+    // Pools: one resource per hex, one token per non-desert hex
+    int resources = 0;
+    int tokens = 0;
+    for (int type = 0; type < RESOURCE_TYPES; type++)
+    {
+        map.resourceCounts[type] = *p++;
+        resources += map.resourceCounts[type];
+    }
+    for (int i = 0; i < TOKEN_TYPES; i++)
+    {
+        map.tokenCounts[i] = *p++;
+        tokens += map.tokenCounts[i];
+    }
+    if (resources != map.hexCount || tokens != map.hexCount - map.resourceCounts[RESOURCE_DESERT])
+        return false;
+
+    // Vertices and edges
+    if (findAdjacencyError(map.adjacency, map.hexCount) != -1)
+        return false;
+    map.topology = buildTopology(map.adjacency, map.hexCount);
+    if (!topologyConsistent(map.topology))
+        return false;
+
+    map.layout = {map.hexCount, map.adjacency, map.resourceCounts, map.tokenCounts, &map.topology};
+    return true;
+}
+
+/**
+ * Replace the classic or extension board with a map file
+ * A rejected file leaves the built-in board in use
+ *
+ * @param isExtension True to replace the extension board
+ * @param data File contents
+ * @param size File size in bytes
+ * @return True if the map was valid and is now in use
+ */
+bool installBoardMap(bool isExtension, const uint8_t *data, size_t size)
+{
+    int slot = isExtension ? 1 : 0;
+    mapLoaded[slot] = parseBoardMap(data, size, boardMaps[slot]);
+    return mapLoaded[slot];
+}
+
+/**
+ * Map replacing the classic or extension board
+ *
+ * @param isExtension True for the extension board
+ * @return Loaded map, or nullptr while the built-in board is in use
+ */
+const BoardMap *loadedBoardMap(bool isExtension)
+{
+    int slot = isExtension ? 1 : 0;
+    return mapLoaded[slot] ? &boardMaps[slot] : nullptr;
+}
@@ -0,0 +1,102 @@
+/**
+ * BoardMap.h
+ *
+ * Board shapes loaded at runtime, for scenario maps.
+ *
+ * A map file replaces the built-in classic or extension board: its hex
+ * count, neighbour table, LED of each hex, resource pool and token pool.
+ * The file is parsed in one pass straight into the flat arrays of a
+ * BoardMap, which the solver (through MapGeometry in BoardGeometry.h),
+ * boardLayout() and the LED controller then use in place of the
+ * compiled-in tables. Maps are installed once at boot, before any board
+ * is generated, and are read-only afterwards.
+ *
+ * File format (bytes, no padding):
+ *
+ *   offset      size  content
+ *   0           4     magic "CMAP"
+ *   4           1     format version (BOARD_MAP_VERSION)
+ *   5           1     hex count N (1-BOARD_MAX_HEXES)
+ *   6           1     LED strip length (at least N)
+ *   7           1     row count R (1-BOARD_MAP_MAX_ROWS)
+ *   8           R     hexes in each row, top to bottom, for the web page
+ *   8+R         6N    neighbours of each hex, slots as in adjancency.h, 255 for none
+ *   8+R+6N      N     LED index of each hex
+ *   8+R+7N      6     resource pool: sheep, wood, wheat, brick, ore, desert
+ *   14+R+7N     10    token pool, ordered as TOKEN_VALUES
+ *
+ * tools/compile_map.py builds such a file from a JSON description.
+ * A map must be one piece without holes, and every non-desert hex needs a
+ * token.
+ */
+
+#ifndef BOARDMAP_H
+#define BOARDMAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "BoardGenerator.h"
+#include "BoardRules.h"
+#include "BoardTopology.h"
+
+#define BOARD_MAP_VERSION 1      // Format version written by tools/compile_map.py
+#define BOARD_MAP_MAX_ROWS 12    // Most rows of hexes on the web page
+#define BOARD_MAP_HEADER_BYTES 8 // Magic, version, hex count, LED count, row count
+#define BOARD_MAP_MAX_BYTES (BOARD_MAP_HEADER_BYTES + BOARD_MAP_MAX_ROWS + 7 * BOARD_MAX_HEXES + RESOURCE_TYPES + TOKEN_TYPES)
+
+/**
+ * BoardMap structure
+ *
+ * Everything known about a loaded board, in the layout the solver and
+ * the LED controller read directly.
+ */
+struct BoardMap
+{
+    int hexCount;                          // Hexes on the board
+    uint16_t ledCount;                     // Length of the LED strip
+    uint8_t rowCount;                      // Rows of hexes on the web page
+    uint8_t rows[BOARD_MAP_MAX_ROWS];      // Hexes in each row
+    int adjacency[BOARD_MAX_HEXES][6];     // Neighbour table (-1 for no neighbour)
+    int tileToLed[BOARD_MAX_HEXES];        // LED index of each hex
+    int resourceCounts[RESOURCE_TYPES];    // Hexes of each resource type
+    int tokenCounts[TOKEN_TYPES];          // Tokens of each value, ordered as TOKEN_VALUES
+    BoardTopology topology;                // Vertices and edges
+    BoardLayout layout;                    // The arrays above as returned by boardLayout()
+};
+
+/**
+ * Storage of the loaded maps, [0] replaces the classic board and [1] the extension
+ * Only valid where loadedBoardMap() returns it
+ */
+extern BoardMap boardMaps[2];
+
+/**
+ * Parse and check a map file
+ *
+ * @param data File contents
+ * @param size File size in bytes
+ * @param map Output map, partly overwritten even if the file is rejected
+ * @return True if the file describes a valid board
+ */
+bool parseBoardMap(const uint8_t *data, size_t size, BoardMap &map);
+
+/**
+ * Replace the classic or extension board with a map file
+ * Must be called before any board is generated
+ *
+ * @param isExtension True to replace the extension board
+ * @param data File contents
+ * @param size File size in bytes
+ * @return True if the map was valid and is now in use
+ */
+bool installBoardMap(bool isExtension, const uint8_t *data, size_t size);
+
+/**
+ * Map replacing the classic or extension board
+ *
+ * @param isExtension True for the extension board
+ * @return Loaded map, or nullptr while the built-in board is in use
+ */
+const BoardMap *loadedBoardMap(bool isExtension);
+
+#endif // BOARDMAP_H
@@ -0,0 +1,135 @@
+#include <thread>
+#include "BoardGenerator.h"
+#include "esp_system.h"
+#ifdef ESP_PLATFORM
+#include "esp_pthread.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#endif
+
+/**
+ * PortfolioRace structure
+ *
+ * State shared by the workers of one generateBoardPortfolio call.
+ * Only the worker that flips finished writes the result, and the caller
+ * reads it after joining every worker.
+ */
+struct PortfolioRace
+{
+    std::atomic<bool> finished{false}; // Set by the first worker to find a board or prove there is none
+    Board board;                       // Board of the winner, with its seed
+    GenerationStats stats;             // Search effort of the winner
+};
+
+/**
+ * Seed of a worker
+ * Worker 0 keeps the caller's seed; the others step away from it by the
+ * golden-ratio increment of splitmix64, which Xoshiro128 then expands
+ *
+ * @param seed Seed of the portfolio
+ * @param worker Worker index
+ * @return Seed of that worker
+ */
+static uint64_t workerSeed(uint64_t seed, int worker)
+{
+    return seed + (uint64_t)worker * 0x9E3779B97F4A7C15ULL;
+}
+
+/**
+ * One search of the portfolio
+ * Runs exactly what generateBoard(config, seed) runs, but gives up as
+ * soon as another worker has won. A worker proving that no board exists
+ * ends the race too, without a board.
+ *
+ * @param config BoardConfig with desired generation rules
+ * @param seed Seed of this worker
+ * @param race Shared state of the portfolio
+ */
+static void runWorker(const BoardConfig &config, uint64_t seed, PortfolioRace *race)
+{
+    Xoshiro128 rng(seed);
+    GenerationStats stats;
+    Board board = generateBoard(config, rng, &stats, &race->finished);
+    if (board.empty() && !stats.infeasible)
+        return;
+
+    bool expected = false;
+    if (race->finished.compare_exchange_strong(expected, true))
+    {
+        board.seed = board.empty() ? 0 : seed;
+        race->board = board;
+        race->stats = stats;
+    }
+}
+
+/**
+ * Thread settings for the next extra worker
+ * On the ESP32 each worker gets the solver's stack, the caller's priority
+ * and the next core; host threads keep their defaults
+ *
+ * @param worker Worker index (1 or more)
+ */
+static void configureWorker(int worker)
+{
+#ifdef ESP_PLATFORM
+    esp_pthread_cfg_t cfg = esp_pthread_get_default_config();
+    cfg.stack_size = BOARD_PORTFOLIO_STACK_SIZE;
+    cfg.prio = uxTaskPriorityGet(NULL);
+    cfg.pin_to_core = (xPortGetCoreID() + worker) % portNUM_PROCESSORS;
+    cfg.thread_name = "BoardPortfolio";
+    esp_pthread_set_cfg(&cfg);
+#else
+    (void)worker;
+#endif
+}
+
+/**
+ * Generates a Catan board by racing independent searches
+ *
+ * @param config BoardConfig containing all generation parameters
+ * @param seed Seed of worker 0; the other workers derive theirs from it
+ * @param workers Number of searches (1 to BOARD_PORTFOLIO_MAX_WORKERS)
+ * @param stats Optional statistics about the search effort of the winner
+ * @return Board structure with resources and numbers for each hex, empty if
+ *         no worker found one
+ */
+Board generateBoardPortfolio(const BoardConfig &config, uint64_t seed, int workers, GenerationStats *stats)
+{
+    if (workers < 1)
+        workers = 1;
+    if (workers > BOARD_PORTFOLIO_MAX_WORKERS)
+        workers = BOARD_PORTFOLIO_MAX_WORKERS;
+
+    PortfolioRace race;
+    std::thread threads[BOARD_PORTFOLIO_MAX_WORKERS - 1];
+    for (int worker = 1; worker < workers; worker++)
+    {
+        configureWorker(worker);
+        threads[worker - 1] = std::thread(runWorker, std::cref(config), workerSeed(seed, worker), &race);
+    }
+
+    // The calling task is worker 0
+    runWorker(config, seed, &race);
+    for (int worker = 1; worker < workers; worker++)
+        threads[worker - 1].join();
+
+    if (stats != nullptr)
+        *stats = race.stats;
+    return race.board;
+}
+
+/**
+ * Generates a Catan board by racing independent searches from a fresh random seed
+ *
+ * Uses ESP32's hardware random number generator for the seed.
+ *
+ * @param config BoardConfig containing all generation parameters
+ * @param workers Number of searches (1 to BOARD_PORTFOLIO_MAX_WORKERS)
+ * @param stats Optional statistics about the search effort of the winner
+ * @return Board structure with resources and numbers for each hex
+ */
+Board generateBoardPortfolio(const BoardConfig &config, int workers, GenerationStats *stats)
+{
+    uint64_t seed = ((uint64_t)esp_random() << 32) | esp_random();
+    return generateBoardPortfolio(config, seed, workers, stats);
+}
@@ -0,0 +1,81 @@
+#include "BoardRng.h"
+
+/**
+ * Uniform value in [0, bound) without modulo bias
+ *
+ * Uses Lemire's multiply-and-reject method, which needs a single
+ * multiplication in the common case.
+ *
+ * @param bound Exclusive upper limit (must be > 0)
+ * @return Random value below bound
+ */
+uint32_t BoardRng::below(uint32_t bound)
+{
+    uint64_t product = (uint64_t)next() * bound;
+    uint32_t low = (uint32_t)product;
+    if (low < bound)
+    {
+        uint32_t threshold = (0u - bound) % bound;
+        while (low < threshold)
+        {
+            product = (uint64_t)next() * bound;
+            low = (uint32_t)product;
+        }
+    }
+    return (uint32_t)(product >> 32);
+}
+
+/**
+ * Step of the splitmix64 generator, used to expand the seed
+ *
+ * @param x Generator state, advanced in place
+ * @return Next 64-bit value
+ */
+static uint64_t splitmix64(uint64_t &x)
+{
+    uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * Rotate a 32-bit value left
+ */
+static inline uint32_t rotl(uint32_t x, int k)
+{
+    return (x << k) | (x >> (32 - k));
+}
+
+/**
+ * Constructor - expand the 64-bit seed into the 128-bit state
+ *
+ * @param seed 64-bit seed; equal seeds produce equal sequences
+ */
+Xoshiro128::Xoshiro128(uint64_t seed)
+{
+    uint64_t a = splitmix64(seed);
+    uint64_t b = splitmix64(seed);
+    state[0] = (uint32_t)a;
+    state[1] = (uint32_t)(a >> 32);
+    state[2] = (uint32_t)b;
+    state[3] = (uint32_t)(b >> 32);
+}
+
+/**
+ * Next raw 32-bit value (xoshiro128**)
+ */
+uint32_t Xoshiro128::next()
+{
+    uint32_t result = rotl(state[1] * 5, 7) * 9;
+    uint32_t t = state[1] << 9;
+
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= t;
+    state[3] = rotl(state[3], 11);
+
+    return result;
+}
@@ -0,0 +1,62 @@
+/**
+ * BoardRng.h
+ *
+ * Random number generators used by the board generator.
+ *
+ * BoardRng is the interface the solver draws from, so callers can inject
+ * their own source. Xoshiro128 is the default implementation: 16 bytes
+ * of state, 32-bit operations only (cheap on the ESP32), and fully
+ * determined by a 64-bit seed, which makes every board reproducible.
+ */
+
+#ifndef BOARDRNG_H
+#define BOARDRNG_H
+
+#include <stdint.h>
+
+/**
+ * BoardRng interface
+ *
+ * Source of uniformly distributed 32-bit values
+ */
+class BoardRng
+{
+public:
+    virtual ~BoardRng() {}
+
+    /**
+     * Next raw 32-bit value
+     */
+    virtual uint32_t next() = 0;
+
+    /**
+     * Uniform value in [0, bound) without modulo bias
+     *
+     * @param bound Exclusive upper limit (must be > 0)
+     * @return Random value below bound
+     */
+    uint32_t below(uint32_t bound);
+};
+
+/**
+ * Xoshiro128 class
+ *
+ * xoshiro128** generator seeded through splitmix64
+ */
+class Xoshiro128 : public BoardRng
+{
+public:
+    /**
+     * Constructor
+     *
+     * @param seed 64-bit seed; equal seeds produce equal sequences
+     */
+    explicit Xoshiro128(uint64_t seed);
+
+    uint32_t next() override;
+
+private:
+    uint32_t state[4]; // Generator state
+};
+
+#endif // BOARDRNG_H
@@ -0,0 +1,69 @@
+#include "BoardRules.h"
+#include "BoardGeometry.h"
+#include "BoardMap.h"
+
+// Piece pools and shapes are defined by the geometry traits in BoardGeometry.h
+static constexpr BoardLayout layoutClassic = layoutOf<ClassicGeometry>();
+static constexpr BoardLayout layoutExtension = layoutOf<ExtensionGeometry>();
+
+/**
+ * Shape and piece pools of the classic or extension board
+ * A map loaded in place of the board takes precedence
+ *
+ * @param isExtension True for the 30-hex extension board
+ * @return Board layout
+ */
+const BoardLayout &boardLayout(bool isExtension)
+{
+    const BoardMap *map = loadedBoardMap(isExtension);
+    if (map != nullptr)
+        return map->layout;
+    return isExtension ? layoutExtension : layoutClassic;
+}
+
+/**
+ * Resources allowed next to a resource
+ * Identical resources may be banned from touching (deserts included)
+ *
+ * @param config Adjacency rules
+ * @param type Resource ID
+ * @return Mask of resource IDs
+ */
+uint16_t resourceCompatibility(const BoardConfig &config, int type)
+{
+    return config.sameResourceCanTouch ? RESOURCE_MASK : (RESOURCE_MASK & ~(1 << type));
+}
+
+/**
+ * Number tokens allowed next to a number token
+ *
+ * @param config Adjacency rules
+ * @param token Token index
+ * @return Mask of token indices (TOKEN_NONE excluded)
+ */
+uint16_t tokenCompatibility(const BoardConfig &config, int token)
+{
+    int a = TOKEN_VALUES[token];
+    uint16_t mask = 0;
+    for (int j = 0; j < TOKEN_TYPES; j++)
+    {
+        int b = TOKEN_VALUES[j];
+        bool allowed = true;
+
+        // Eight/Six Rule: a 6 or 8 cannot be adjacent to any 6 or 8
+        if (!config.eightSixCanTouch && (a == 6 || a == 8) && (b == 6 || b == 8))
+            allowed = false;
+
+        // Two/Twelve Rule: a 2 or 12 cannot be adjacent to any 2 or 12
+        if (!config.twoTwelveCanTouch && (a == 2 || a == 12) && (b == 2 || b == 12))
+            allowed = false;
+
+        // Same Numbers Rule: identical tokens cannot be adjacent
+        if (!config.sameNumbersCanTouch && a == b)
+            allowed = false;
+
+        if (allowed)
+            mask |= 1 << j;
+    }
+    return mask;
+}
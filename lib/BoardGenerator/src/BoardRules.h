@@ -0,0 +1,74 @@
+/**
+ * BoardRules.h
+ *
+ * Board sizes, piece pools and adjacency rules shared by the solver
+ * and the host tools.
+ *
+ * Resources are identified by their ID (0=sheep, 1=wood, 2=wheat,
+ * 3=brick, 4=ore, 5=desert) and number tokens by their index in
+ * TOKEN_VALUES. Rule masks have bit i set when value i is allowed.
+ */
+
+#ifndef BOARDRULES_H
+#define BOARDRULES_H
+
+#include <stdint.h>
+#include "BoardGenerator.h"
+#include "BoardTopology.h"
+
+#define RESOURCE_TYPES 6        // sheep, wood, wheat, brick, ore, desert
+#define RESOURCE_DESERT 5       // Resource ID of the desert (no number token)
+#define TOKEN_TYPES 10          // Number tokens 2-6 and 8-12
+#define TOKEN_NONE TOKEN_TYPES  // Token index used for "no token" on deserts
+
+#define RESOURCE_MASK ((1 << RESOURCE_TYPES) - 1) // Every resource type
+#define TOKEN_MASK ((1 << (TOKEN_TYPES + 1)) - 1) // Every token plus "no token"
+
+/**
+ * Token values in the order used by token indices and masks
+ * (bit i of a token mask stands for TOKEN_VALUES[i])
+ */
+static const int TOKEN_VALUES[TOKEN_TYPES] = {2, 3, 4, 5, 6, 8, 9, 10, 11, 12};
+
+/**
+ * BoardLayout structure
+ *
+ * Shape, piece pools and vertex/edge graph of one board size.
+ */
+struct BoardLayout
+{
+    int hexCount;                  // Number of hexes
+    const int (*adjacency)[6];     // Neighbour table (-1 for no neighbour)
+    const int *resourceCounts;     // Hexes of each resource type, RESOURCE_TYPES entries
+    const int *tokenCounts;        // Tokens of each value, ordered as TOKEN_VALUES
+    const BoardTopology *topology; // Vertices and edges
+};
+
+/**
+ * Shape and piece pools of the classic or extension board
+ * (or of the map loaded in its place, see BoardMap.h)
+ *
+ * @param isExtension True for the 30-hex extension board
+ * @return Board layout
+ */
+const BoardLayout &boardLayout(bool isExtension);
+
+/**
+ * Resources allowed next to a resource
+ *
+ * @param config Adjacency rules
+ * @param type Resource ID
+ * @return Mask of resource IDs
+ */
+uint16_t resourceCompatibility(const BoardConfig &config, int type);
+
+/**
+ * Number tokens allowed next to a number token
+ *
+ * @param config Adjacency rules
+ * @param token Token index
+ * @return Mask of token indices (TOKEN_NONE excluded)
+ */
+uint16_t tokenCompatibility(const BoardConfig &config, int token);
+
+#endif // BOARDRULES_H
@@ -0,0 +1,536 @@
+#include "BoardSampler.h"
+#include <algorithm>
+
+#define KEY_POOL_BITS 3   // Pool left of a value (at most 7 pieces)
+#define KEY_MAX_WINDOW 7  // Frontier positions a key can hold per value
+
+/**
+ * Constructor - count every board of a configuration
+ *
+ * @param config Board size and adjacency rules
+ * @param maxStates Give up (ready() is false) once the tables hold this many states
+ */
+BoardSampler::BoardSampler(const BoardConfig &config, uint32_t maxStates)
+    : config(config), layout(boardLayout(config.isExtension)), symmetry(layout.adjacency, layout.hexCount),
+      totalWeight(0), maxStates(maxStates), states(0), tablesReady(true)
+{
+    int hexCount = layout.hexCount;
+    int desertCount = layout.resourceCounts[RESOURCE_DESERT];
+    bool desertsCanTouch = resourceCompatibility(config, RESOURCE_DESERT) & (1 << RESOURCE_DESERT);
+
+    // One desert placement per symmetry orbit (the smallest of its images)
+    placements.reserve(hexCount * hexCount / 2);
+    for (int a = 0; a < hexCount && tablesReady; a++)
+    {
+        for (int b = (desertCount > 1 ? a + 1 : a); b < (desertCount > 1 ? hexCount : a + 1) && tablesReady; b++)
+        {
+            int keys[SYMMETRY_MAX];
+            int key = a * hexCount + b;
+            int orbitSize = 0;
+            bool canonical = true;
+            for (int s = 0; s < symmetry.count() && canonical; s++)
+            {
+                int ia = symmetry.image(s, a);
+                int ib = symmetry.image(s, b);
+                int image = (ia < ib) ? ia * hexCount + ib : ib * hexCount + ia;
+                canonical = image >= key;
+                if (std::find(keys, keys + orbitSize, image) == keys + orbitSize)
+                    keys[orbitSize++] = image;
+            }
+            if (!canonical)
+                continue;
+
+            // Two deserts may be banned from touching
+            bool touching = false;
+            for (int slot = 0; slot < 6 && desertCount > 1; slot++)
+                touching = touching || layout.adjacency[a][slot] == b || layout.adjacency[b][slot] == a;
+            if (touching && !desertsCanTouch)
+                continue;
+
+            placements.emplace_back();
+            Placement &placement = placements.back();
+            placement.deserts[0] = a;
+            placement.deserts[1] = b;
+            placement.orbitSize = orbitSize;
+            placement.weight = 0;
+            placement.layers[1].total = 0;
+
+            for (int layer = 0; layer < 2 && tablesReady; layer++)
+            {
+                LayerTable &table = placement.layers[layer];
+                buildTable(table, layer, placement.deserts);
+                if (layer == 1 && placement.layers[0].total == 0)
+                    break; // No resource layout, so no board either way
+
+                int8_t value[SOLVER_MAX_HEXES];
+                uint8_t pool[TOKEN_TYPES];
+                std::copy(table.pool, table.pool + TOKEN_TYPES, pool);
+                table.total = countFrom(table, 0, value, pool);
+                tablesReady = table.total >= 0;
+            }
+            placement.weight = orbitSize * placement.layers[0].total * placement.layers[1].total;
+            totalWeight += placement.weight;
+        }
+    }
+    if (!tablesReady)
+        totalWeight = 0;
+}
+
+/**
+ * Whether the tables were built within the state limit
+ */
+bool BoardSampler::ready() const
+{
+    return tablesReady;
+}
+
+/**
+ * Number of valid boards (0 if none exists or the tables are not ready)
+ */
+double BoardSampler::boardCount() const
+{
+    return totalWeight;
+}
+
+/**
+ * Number of table entries built so far
+ */
+uint32_t BoardSampler::stateCount() const
+{
+    return states;
+}
+
+/**
+ * Draw one board uniformly among all valid boards
+ *
+ * @param rng Random generator
+ * @param resources Output array of hexCount resource IDs
+ * @param numbers Output array of hexCount token values (0 on deserts)
+ * @return False if the sampler is not ready or no valid board exists
+ */
+bool BoardSampler::sample(BoardRng &rng, int *resources, int *numbers)
+{
+    if (!tablesReady || totalWeight <= 0)
+        return false;
+
+    // Desert orbit, weighted by its number of boards
+    double target = uniform(rng) * totalWeight;
+    size_t chosen = 0;
+    while (chosen + 1 < placements.size() && target >= placements[chosen].weight)
+    {
+        target -= placements[chosen].weight;
+        chosen++;
+    }
+    Placement &placement = placements[chosen];
+
+    int8_t resourceValue[SOLVER_MAX_HEXES];
+    int8_t tokenValue[SOLVER_MAX_HEXES];
+    sampleLayer(placement.layers[0], rng, resourceValue);
+    sampleLayer(placement.layers[1], rng, tokenValue);
+
+    // Lay the representative out, then move it by a random symmetry
+    int representative[2][SOLVER_MAX_HEXES];
+    for (int hex = 0; hex < layout.hexCount; hex++)
+    {
+        representative[0][hex] = RESOURCE_DESERT;
+        representative[1][hex] = 0;
+    }
+    for (int var = 0; var < placement.layers[0].varCount; var++)
+    {
+        representative[0][placement.layers[0].hexOf[var]] = resourceValue[var];
+        representative[1][placement.layers[1].hexOf[var]] = TOKEN_VALUES[tokenValue[var]];
+    }
+
+    int s = rng.below(symmetry.count());
+    for (int hex = 0; hex < layout.hexCount; hex++)
+    {
+        resources[symmetry.image(s, hex)] = representative[0][hex];
+        numbers[symmetry.image(s, hex)] = representative[1][hex];
+    }
+    return true;
+}
+
+/**
+ * Probability that a uniformly drawn board holds a desert on a hex
+ *
+ * @param hex Hex index
+ */
+double BoardSampler::desertProbability(int hex) const
+{
+    if (totalWeight <= 0)
+        return 0;
+
+    int desertCount = layout.resourceCounts[RESOURCE_DESERT];
+    double probability = 0;
+    for (const Placement &placement : placements)
+    {
+        int hits = 0;
+        for (int s = 0; s < symmetry.count(); s++)
+        {
+            for (int d = 0; d < desertCount; d++)
+                hits += symmetry.image(s, placement.deserts[d]) == hex;
+        }
+        probability += placement.weight / totalWeight * hits / symmetry.count();
+    }
+    return probability;
+}
+
+/**
+ * Probability that a uniformly drawn board holds a value on a hex
+ *
+ * For every placement and symmetry, the hex maps back to a hex of the
+ * representative; a copy of its table with that hex fixed to the value
+ * gives the share of layouts holding it.
+ *
+ * @param layer 0 for resources (value = resource ID), 1 for tokens (value = token index, TOKEN_NONE on deserts)
+ * @param hex Hex index
+ * @param value Value to look for
+ */
+double BoardSampler::valueProbability(int layer, int hex, int value)
+{
+    if (totalWeight <= 0)
+        return 0;
+
+    int noValue = (layer == 0) ? RESOURCE_DESERT : TOKEN_NONE;
+    double probability = 0;
+    for (Placement &placement : placements)
+    {
+        LayerTable &table = placement.layers[layer];
+        double share[SOLVER_MAX_HEXES];
+        bool known[SOLVER_MAX_HEXES] = {};
+        double sum = 0;
+
+        for (int s = 0; s < symmetry.count(); s++)
+        {
+            // Representative hex that this symmetry moves onto "hex"
+            int source = 0;
+            while (symmetry.image(s, source) != hex)
+                source++;
+
+            if (!known[source])
+            {
+                int var = 0;
+                while (var < table.varCount && table.hexOf[var] != source)
+                    var++;
+
+                if (var == table.varCount)
+                    share[source] = (value == noValue) ? 1 : 0; // A desert
+                else if (value == noValue || table.total <= 0)
+                    share[source] = 0;
+                else
+                {
+                    // Count again with the hex fixed to the value (a throwaway table)
+                    uint32_t statesBefore = states;
+                    LayerTable *fixed = new LayerTable();
+                    buildTable(*fixed, layer, placement.deserts);
+                    fixed->domain[var] = 1 << value;
+                    buildTable(*fixed, -1, placement.deserts);
+                    int8_t values[SOLVER_MAX_HEXES];
+                    uint8_t pool[TOKEN_TYPES];
+                    std::copy(fixed->pool, fixed->pool + TOKEN_TYPES, pool);
+                    double count = countFrom(*fixed, 0, values, pool);
+                    states = statesBefore;
+                    share[source] = (count < 0) ? 0 : count / table.total;
+                    delete fixed;
+                }
+                known[source] = true;
+            }
+            sum += share[source];
+        }
+        probability += placement.weight / totalWeight * sum / symmetry.count();
+    }
+    return probability;
+}
+
+/**
+ * Set up the tables of one layer for one placement
+ *
+ * With layer -1 only the value classes are recomputed, keeping the
+ * variables and any narrowed domains.
+ *
+ * @param table Table to fill
+ * @param layer 0 for resources, 1 for tokens, -1 to refresh the classes
+ * @param deserts Desert hexes
+ */
+void BoardSampler::buildTable(LayerTable &table, int layer, const int *deserts)
+{
+    if (layer >= 0)
+    {
+        int desertCount = layout.resourceCounts[RESOURCE_DESERT];
+        int varOf[SOLVER_MAX_HEXES];
+
+        table.varCount = 0;
+        for (int hex = 0; hex < layout.hexCount; hex++)
+        {
+            bool desert = false;
+            for (int d = 0; d < desertCount; d++)
+                desert = desert || deserts[d] == hex;
+            varOf[hex] = desert ? -1 : table.varCount;
+            if (!desert)
+                table.hexOf[table.varCount++] = hex;
+        }
+
+        // Earlier neighbours as distances back, taking pairs listed by either side
+        table.window = 0;
+        for (int var = 0; var < table.varCount; var++)
+        {
+            int hex = table.hexOf[var];
+            table.earlierCount[var] = 0;
+            for (int other = 0; other < layout.hexCount; other++)
+            {
+                bool adjacent = false;
+                for (int slot = 0; slot < 6; slot++)
+                    adjacent = adjacent || layout.adjacency[hex][slot] == other || layout.adjacency[other][slot] == hex;
+                if (!adjacent || varOf[other] == -1 || varOf[other] >= var)
+                    continue;
+                int distance = var - varOf[other];
+                table.earlier[var][table.earlierCount[var]++] = distance;
+                table.window = std::max(table.window, distance);
+            }
+        }
+        if (table.window > KEY_MAX_WINDOW)
+            tablesReady = false; // Frontier too wide for the key
+
+        // Frontier positions that still touch a variable from "var" on
+        for (int var = 0; var <= table.varCount; var++)
+        {
+            table.live[var] = 0;
+            for (int later = var; later < table.varCount; later++)
+            {
+                for (int e = 0; e < table.earlierCount[later]; e++)
+                {
+                    int distance = var - (later - table.earlier[later][e]);
+                    if (distance >= 1)
+                        table.live[var] |= 1 << (distance - 1);
+                }
+            }
+        }
+
+        if (layer == 0)
+        {
+            // Deserts are already placed, the other resources are left
+            table.valueCount = RESOURCE_DESERT;
+            for (int type = 0; type < RESOURCE_DESERT; type++)
+            {
+                table.compatible[type] = resourceCompatibility(config, type) & ((1 << RESOURCE_DESERT) - 1);
+                table.pool[type] = layout.resourceCounts[type];
+            }
+        }
+        else
+        {
+            table.valueCount = TOKEN_TYPES;
+            for (int token = 0; token < TOKEN_TYPES; token++)
+            {
+                table.compatible[token] = tokenCompatibility(config, token);
+                table.pool[token] = layout.tokenCounts[token];
+            }
+        }
+        for (int var = 0; var < table.varCount; var++)
+            table.domain[var] = (1 << table.valueCount) - 1;
+        table.memo.assign(table.varCount + 1, std::unordered_map<StateKey, double, StateKeyHash>());
+        table.total = 0;
+    }
+
+    // Values no rule mentions never need their frontier positions
+    uint16_t everyValue = (1 << table.valueCount) - 1;
+    for (int x = 0; x < table.valueCount; x++)
+    {
+        table.unruled[x] = table.compatible[x] == everyValue;
+        for (int y = 0; y < table.valueCount; y++)
+            table.unruled[x] = table.unruled[x] && ((table.compatible[y] >> x) & 1);
+    }
+
+    // Two values are interchangeable if swapping them changes no rule or domain
+    for (int a = 0; a < table.valueCount; a++)
+    {
+        table.valueClass[a] = a;
+        for (int b = 0; b < a; b++)
+        {
+            bool same = true;
+            for (int c = 0; c < table.valueCount && same; c++)
+            {
+                int swapped = (c == a) ? b : (c == b) ? a : c;
+                same = ((table.compatible[a] >> c) & 1) == ((table.compatible[b] >> swapped) & 1);
+            }
+            for (int var = 0; var < table.varCount && same; var++)
+                same = ((table.domain[var] >> a) & 1) == ((table.domain[var] >> b) & 1);
+            if (same)
+            {
+                table.valueClass[a] = table.valueClass[b];
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * Canonical key of the state before assigning a variable
+ *
+ * Every value contributes its pool left and a mask of the frontier
+ * positions holding it, leaving out positions no later hex touches and
+ * values no rule mentions. Inside a class of interchangeable values
+ * these signatures are sorted, so relabelled states share one key.
+ */
+BoardSampler::StateKey BoardSampler::keyOf(const LayerTable &table, int var, const int8_t *value,
+                                           const uint8_t *pool) const
+{
+    uint16_t signature[TOKEN_TYPES];
+    for (int x = 0; x < table.valueCount; x++)
+        signature[x] = pool[x] << KEY_MAX_WINDOW;
+    for (int d = 1; d <= table.window && d <= var; d++)
+    {
+        if (((table.live[var] >> (d - 1)) & 1) && !table.unruled[value[var - d]])
+            signature[value[var - d]] |= 1 << (d - 1);
+    }
+
+    StateKey key = {0, 0};
+    for (int c = 0; c < table.valueCount; c++)
+    {
+        if (table.valueClass[c] != c)
+            continue;
+
+        // Insertion sort, classes hold at most TOKEN_TYPES values
+        uint16_t members[TOKEN_TYPES];
+        int count = 0;
+        for (int x = c; x < table.valueCount; x++)
+        {
+            if (table.valueClass[x] != c)
+                continue;
+            int slot = count++;
+            while (slot > 0 && members[slot - 1] > signature[x])
+            {
+                members[slot] = members[slot - 1];
+                slot--;
+            }
+            members[slot] = signature[x];
+        }
+
+        for (int m = 0; m < count; m++)
+        {
+            const int bits = KEY_POOL_BITS + KEY_MAX_WINDOW;
+            key.high = (key.high << bits) | (key.low >> (64 - bits));
+            key.low = (key.low << bits) | members[m];
+        }
+    }
+    return key;
+}
+
+/**
+ * Values a variable may take given the earlier assignments
+ */
+uint16_t BoardSampler::allowedValues(const LayerTable &table, int var, const int8_t *value,
+                                     const uint8_t *pool) const
+{
+    uint16_t allowed = 0;
+    for (int x = 0; x < table.valueCount; x++)
+    {
+        if (pool[x] > 0)
+            allowed |= 1 << x;
+    }
+    allowed &= table.domain[var];
+    for (int e = 0; e < table.earlierCount[var]; e++)
+        allowed &= table.compatible[value[var - table.earlier[var][e]]];
+    return allowed;
+}
+
+/**
+ * Completions of a partial layout (memoized)
+ *
+ * @param table Layer tables
+ * @param var Next variable to assign
+ * @param value Assigned values
+ * @param pool Pieces left of each value
+ * @return Number of layouts, or -1 once the state limit is hit
+ */
+double BoardSampler::countFrom(LayerTable &table, int var, int8_t *value, uint8_t *pool)
+{
+    if (var == table.varCount)
+        return 1;
+
+    StateKey key = keyOf(table, var, value, pool);
+    auto found = table.memo[var].find(key);
+    if (found != table.memo[var].end())
+        return found->second;
+    if (states >= maxStates)
+        return -1;
+
+    uint16_t allowed = allowedValues(table, var, value, pool);
+    double count = 0;
+    for (int x = 0; x < table.valueCount; x++)
+    {
+        if (!(allowed & (1 << x)))
+            continue;
+        value[var] = x;
+        pool[x]--;
+        double below = countFrom(table, var + 1, value, pool);
+        pool[x]++;
+        if (below < 0)
+            return -1;
+        count += below;
+    }
+
+    table.memo[var][key] = count;
+    states++;
+    return count;
+}
+
+/**
+ * Fill one layer uniformly among its layouts
+ *
+ * Each variable takes a value with probability proportional to the
+ * number of layouts that complete it.
+ *
+ * @param table Counted layer
+ * @param rng Random generator
+ * @param value Output value per variable
+ */
+void BoardSampler::sampleLayer(LayerTable &table, BoardRng &rng, int8_t *value)
+{
+    uint8_t pool[TOKEN_TYPES];
+    std::copy(table.pool, table.pool + TOKEN_TYPES, pool);
+
+    for (int var = 0; var < table.varCount; var++)
+    {
+        uint16_t allowed = allowedValues(table, var, value, pool);
+        double completions[TOKEN_TYPES];
+        double total = 0;
+        int last = -1;
+        for (int x = 0; x < table.valueCount; x++)
+        {
+            completions[x] = 0;
+            if (!(allowed & (1 << x)))
+                continue;
+            value[var] = x;
+            pool[x]--;
+            completions[x] = countFrom(table, var + 1, value, pool);
+            pool[x]++;
+            total += completions[x];
+            if (completions[x] > 0)
+                last = x;
+        }
+
+        double target = uniform(rng) * total;
+        int chosen = last;
+        for (int x = 0; x < last; x++)
+        {
+            if (target < completions[x])
+            {
+                chosen = x;
+                break;
+            }
+            target -= completions[x];
+        }
+        value[var] = chosen;
+        pool[chosen]--;
+    }
+}
+
+/**
+ * Uniform double in [0, 1) from the random generator (53 bits)
+ */
+double BoardSampler::uniform(BoardRng &rng)
+{
+    uint32_t high = rng.next() >> 5;
+    uint32_t low = rng.next() >> 6;
+    return (high * 67108864.0 + low) / 9007199254740992.0;
+}
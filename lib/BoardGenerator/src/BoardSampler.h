@@ -0,0 +1,210 @@
+/**
+ * BoardSampler.h
+ *
+ * Uniform sampler over every valid board of a BoardConfig.
+ *
+ * The randomized solver reaches some boards through more early choices
+ * than others, so it does not draw all valid boards with the same
+ * probability. The sampler counts the boards instead and then walks
+ * down the counts, which makes every valid board equally likely.
+ *
+ * Resources and tokens only meet at the deserts, so for every desert
+ * placement D the number of boards is R(D) * T(D). One placement per
+ * symmetry orbit is counted; a sample picks a placement with probability
+ * proportional to its orbit's share of the boards, fills each layer hex
+ * by hex with probabilities proportional to the completions left, and
+ * finally applies a random board symmetry.
+ *
+ * Each layer is counted by dynamic programming over the hexes in row
+ * order. The state is the pool left plus the values on the last few
+ * hexes (the frontier still touching unfilled hexes), and values that
+ * the rules cannot tell apart are relabelled to a canonical order, which
+ * keeps the tables small: a few thousand states for resources and about
+ * 10^5 for strict classic tokens. Strict extension token rules need tens
+ * of millions of states, far beyond the ESP32's RAM, so the sampler is
+ * meant for host builds; the firmware keeps using the solver.
+ *
+ * Counts are kept as doubles, so probabilities are exact to about 1e-16.
+ */
+
+#ifndef BOARDSAMPLER_H
+#define BOARDSAMPLER_H
+
+#include <stdint.h>
+#include <vector>
+#include <unordered_map>
+#include "BoardGenerator.h"
+#include "BoardRules.h"
+#include "BoardRng.h"
+#include "BoardSolver.h"
+#include "BoardSymmetry.h"
+
+#define SAMPLER_MAX_DESERTS 2              // Deserts on the largest board
+#define SAMPLER_DEFAULT_MAX_STATES 4000000 // Table size limit of one sampler
+
+/**
+ * BoardSampler class
+ *
+ * Draws boards uniformly at random among all valid boards of a config
+ */
+class BoardSampler
+{
+public:
+    /**
+     * Constructor - count every board of a configuration
+     *
+     * @param config Board size and adjacency rules
+     * @param maxStates Give up (ready() is false) once the tables hold this many states
+     */
+    explicit BoardSampler(const BoardConfig &config, uint32_t maxStates = SAMPLER_DEFAULT_MAX_STATES);
+
+    /**
+     * Whether the tables were built within the state limit
+     */
+    bool ready() const;
+
+    /**
+     * Number of valid boards (0 if none exists or the tables are not ready)
+     */
+    double boardCount() const;
+
+    /**
+     * Number of table entries built so far
+     */
+    uint32_t stateCount() const;
+
+    /**
+     * Draw one board uniformly among all valid boards
+     *
+     * @param rng Random generator
+     * @param resources Output array of hexCount resource IDs
+     * @param numbers Output array of hexCount token values (0 on deserts)
+     * @return False if the sampler is not ready or no valid board exists
+     */
+    bool sample(BoardRng &rng, int *resources, int *numbers);
+
+    /**
+     * Probability that a uniformly drawn board holds a desert on a hex
+     *
+     * @param hex Hex index
+     */
+    double desertProbability(int hex) const;
+
+    /**
+     * Probability that a uniformly drawn board holds a value on a hex
+     * Builds extra tables with the hex fixed, so it is meant for tests
+     *
+     * @param layer 0 for resources (value = resource ID), 1 for tokens (value = token index, TOKEN_NONE on deserts)
+     * @param hex Hex index
+     * @param value Value to look for
+     */
+    double valueProbability(int layer, int hex, int value);
+
+private:
+    /**
+     * Table key: per value its pool left (3 bits) and frontier positions
+     * holding it, canonically ordered
+     */
+    struct StateKey
+    {
+        uint64_t high;
+        uint64_t low;
+
+        bool operator==(const StateKey &other) const
+        {
+            return high == other.high && low == other.low;
+        }
+    };
+
+    struct StateKeyHash
+    {
+        size_t operator()(const StateKey &key) const
+        {
+            uint64_t h = key.high * 0x9E3779B97F4A7C15ULL ^ key.low;
+            return (size_t)(h ^ (h >> 29));
+        }
+    };
+
+    /**
+     * Counting tables of one layer for one desert placement
+     */
+    struct LayerTable
+    {
+        int varCount;                                // Non-desert hexes, in index order
+        int hexOf[SOLVER_MAX_HEXES];                 // Hex of each variable
+        int earlier[SOLVER_MAX_HEXES][6];            // Distance back to each earlier neighbour
+        int earlierCount[SOLVER_MAX_HEXES];          // Number of earlier neighbours
+        int window;                                  // Largest distance back to a neighbour
+        uint8_t live[SOLVER_MAX_HEXES + 1];          // Frontier distances still touching a later variable
+        int valueCount;                              // Values a variable can take
+        uint16_t compatible[TOKEN_TYPES];            // Values allowed next to each value
+        uint16_t domain[SOLVER_MAX_HEXES];           // Values allowed on each variable
+        uint8_t pool[TOKEN_TYPES];                   // Pieces of each value
+        uint8_t valueClass[TOKEN_TYPES];             // Values in one class are interchangeable
+        bool unruled[TOKEN_TYPES];                   // Values allowed next to anything
+        std::vector<std::unordered_map<StateKey, double, StateKeyHash>> memo; // Completions per level
+        double total;                                // Layouts of this layer
+    };
+
+    /**
+     * Desert placement counted for one symmetry orbit
+     */
+    struct Placement
+    {
+        int deserts[SAMPLER_MAX_DESERTS]; // Desert hexes
+        int orbitSize;                    // Equivalent placements
+        double weight;                    // Boards with a placement in this orbit
+        LayerTable layers[2];             // Resource and token tables
+    };
+
+    BoardConfig config;                // Board size and adjacency rules
+    const BoardLayout &layout;         // Board shape and pools
+    BoardSymmetry symmetry;            // Symmetries of the board
+    std::vector<Placement> placements; // One placement per orbit
+    double totalWeight;                // Valid boards
+    uint32_t maxStates;                // Table size limit
+    uint32_t states;                   // Table entries built
+    bool tablesReady;                  // Built within the limit?
+
+    /**
+     * Set up the tables of one layer for one placement
+     *
+     * @param table Table to fill
+     * @param layer 0 for resources, 1 for tokens
+     * @param deserts Desert hexes
+     */
+    void buildTable(LayerTable &table, int layer, const int *deserts);
+
+    /**
+     * Canonical key of the state before assigning a variable
+     */
+    StateKey keyOf(const LayerTable &table, int var, const int8_t *value, const uint8_t *pool) const;
+
+    /**
+     * Values a variable may take given the earlier assignments
+     */
+    uint16_t allowedValues(const LayerTable &table, int var, const int8_t *value, const uint8_t *pool) const;
+
+    /**
+     * Completions of a partial layout (memoized)
+     *
+     * @return Number of layouts, or -1 once the state limit is hit
+     */
+    double countFrom(LayerTable &table, int var, int8_t *value, uint8_t *pool);
+
+    /**
+     * Fill one layer uniformly among its layouts
+     *
+     * @param table Counted layer
+     * @param rng Random generator
+     * @param value Output value per variable
+     */
+    void sampleLayer(LayerTable &table, BoardRng &rng, int8_t *value);
+
+    /**
+     * Uniform double in [0, 1) from the random generator
+     */
+    static double uniform(BoardRng &rng);
+};
+
+#endif // BOARDSAMPLER_H
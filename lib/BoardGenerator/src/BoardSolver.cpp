@@ -0,0 +1,413 @@
+#include "BoardSolver.h"
+
+// Return codes of search (non-negative values are backjump targets)
+static const int SEARCH_SOLVED = -1;     // Every variable is assigned
+static const int SEARCH_FAILED = -2;     // The step budget ran out, or the solve was cancelled
+static const int SEARCH_RESTART = -3;    // Too many token dead ends, start over
+static const int SEARCH_INFEASIBLE = -4; // No board exists with these pools and rules
+
+/**
+ * Shuffle a small candidate list in place (Fisher-Yates)
+ *
+ * @param candidates Candidate values
+ * @param count Number of candidates
+ * @param rng Random generator
+ */
+static void shuffleCandidates(int8_t *candidates, int count, BoardRng &rng)
+{
+    for (int i = count - 1; i > 0; i--)
+    {
+        int j = rng.below(i + 1);
+        int8_t tmp = candidates[i];
+        candidates[i] = candidates[j];
+        candidates[j] = tmp;
+    }
+}
+
+/**
+ * Index of the highest set bit
+ *
+ * @param mask Non-zero mask
+ * @return Bit position
+ */
+static int highestBit(uint64_t mask)
+{
+    return 63 - __builtin_clzll(mask);
+}
+
+/**
+ * Constructor - precompute the constraint tables
+ *
+ * @param config Adjacency rules and restart policy to use
+ * @param rng Random generator used to order candidates
+ * @param cancel Optional flag another thread sets to stop the solve
+ */
+template <class Geometry>
+BoardSolver<Geometry>::BoardSolver(const BoardConfig &config, BoardRng &rng, const std::atomic<bool> *cancel)
+    : config(config), rng(rng), cancel(cancel), fairness(Geometry::topology), nodeCount(0), nodeLimit(0), failureCount(0), runFailures(0), restartCount(0)
+{
+    // Resource layer: identical resources may be banned from touching
+    for (int type = 0; type < RESOURCE_TYPES; type++)
+    {
+        compatible[0][type] = resourceCompatibility(config, type);
+
+        // A desert carries no token, every other resource carries one
+        coupled[0][type] = (type == RESOURCE_DESERT) ? (1 << TOKEN_NONE) : (TOKEN_MASK & ~(1 << TOKEN_NONE));
+    }
+
+    // Token layer: deserts can touch anything
+    for (int i = 0; i < TOKEN_TYPES; i++)
+    {
+        compatible[1][i] = tokenCompatibility(config, i) | (1 << TOKEN_NONE);
+        coupled[1][i] = RESOURCE_MASK & ~(1 << RESOURCE_DESERT);
+    }
+    compatible[1][TOKEN_NONE] = TOKEN_MASK;
+    coupled[1][TOKEN_NONE] = 1 << RESOURCE_DESERT;
+}
+
+/**
+ * Number of assignments tried during the last solve
+ */
+template <class Geometry>
+uint32_t BoardSolver<Geometry>::nodes() const
+{
+    return nodeCount;
+}
+
+/**
+ * Number of token dead ends hit during the last solve
+ */
+template <class Geometry>
+uint32_t BoardSolver<Geometry>::numberFailures() const
+{
+    return failureCount;
+}
+
+/**
+ * Number of times the last solve started over with a fresh layout
+ */
+template <class Geometry>
+uint16_t BoardSolver<Geometry>::restarts() const
+{
+    return restartCount;
+}
+
+/**
+ * Balance score of the board found by the last solve
+ */
+template <class Geometry>
+float BoardSolver<Geometry>::balance() const
+{
+    return fairness.balance();
+}
+
+/**
+ * Place resources and number tokens on every hex
+ * The pools come from the geometry
+ *
+ * @param resources Output array of one resource ID per hex
+ * @param numbers Output array of one token values (0 on deserts)
+ * @param maxNodes Step budget of the solve
+ * @return SOLVE_FOUND, SOLVE_EXHAUSTED or SOLVE_INFEASIBLE
+ */
+template <class Geometry>
+SolveResult BoardSolver<Geometry>::solve(int *resources, int *numbers, uint32_t maxNodes)
+{
+    for (int type = 0; type < RESOURCE_TYPES; type++)
+        initialCount[0][type] = Geometry::resourceCounts[type];
+    for (int i = 0; i < TOKEN_TYPES; i++)
+        initialCount[1][i] = Geometry::tokenCounts[i];
+    initialCount[1][TOKEN_NONE] = Geometry::resourceCounts[RESOURCE_DESERT];
+    fairness.setPools(Geometry::resourceCounts, Geometry::tokenCounts);
+
+    nodeCount = 0;
+    nodeLimit = maxNodes;
+    failureCount = 0;
+    restartCount = 0;
+
+    while (true)
+    {
+        reset();
+        int result = search(0);
+        if (result == SEARCH_SOLVED)
+            break;
+        if (result == SEARCH_INFEASIBLE)
+            return SOLVE_INFEASIBLE;
+        if (result != SEARCH_RESTART)
+            return SOLVE_EXHAUSTED;
+
+        // Too many token dead ends on this layout: start over with a fresh one
+        restartCount++;
+    }
+
+    for (int hex = 0; hex < hexCount(); hex++)
+    {
+        int token = value[hexCount() + hex];
+        resources[hex] = value[hex];
+        numbers[hex] = (token == TOKEN_NONE) ? 0 : TOKEN_VALUES[token];
+    }
+    return SOLVE_FOUND;
+}
+
+/**
+ * Reset every variable and pool for a fresh run
+ */
+template <class Geometry>
+void BoardSolver<Geometry>::reset()
+{
+    runFailures = 0;
+    fairness.reset();
+    for (int layer = 0; layer < 2; layer++)
+    {
+        available[layer] = 0;
+        for (int x = 0; x <= TOKEN_TYPES; x++)
+        {
+            remaining[layer][x] = (layer == 0 && x >= RESOURCE_TYPES) ? 0 : initialCount[layer][x];
+            valueLevels[layer][x] = 0;
+            if (remaining[layer][x] > 0)
+                available[layer] |= 1 << x;
+        }
+    }
+    for (int var = 0; var < varCount(); var++)
+    {
+        domain[var] = (var < hexCount()) ? RESOURCE_MASK : TOKEN_MASK;
+        value[var] = -1;
+        prunedBy[var] = 0;
+    }
+}
+
+/**
+ * Layer (0 = resource, 1 = token) of a variable
+ */
+template <class Geometry>
+int BoardSolver<Geometry>::layerOf(int var) const
+{
+    return var < hexCount() ? 0 : 1;
+}
+
+/**
+ * Neighbouring variable in the same layer
+ *
+ * @param var Variable index
+ * @param direction Neighbour slot (0-5)
+ * @return Variable index, or -1 for the board edge
+ */
+template <class Geometry>
+int BoardSolver<Geometry>::neighborOf(int var, int direction) const
+{
+    int offset = var < hexCount() ? 0 : hexCount();
+    int neighbor = Geometry::adjacency[var - offset][direction];
+    return neighbor == -1 ? -1 : neighbor + offset;
+}
+
+/**
+ * Other-layer variable of the same hex
+ */
+template <class Geometry>
+int BoardSolver<Geometry>::partnerOf(int var) const
+{
+    return var < hexCount() ? var + hexCount() : var - hexCount();
+}
+
+/**
+ * Pick the free variable with the fewest candidates
+ *
+ * Ties are broken by the number of free neighbours, so hexes in
+ * the middle of the board are filled before the edges.
+ *
+ * @return Variable index, or -1 if every variable is assigned
+ */
+template <class Geometry>
+int BoardSolver<Geometry>::selectVariable() const
+{
+    int best = -1;
+    int bestSize = TOKEN_TYPES + 2;
+    int bestDegree = -1;
+
+    for (int var = 0; var < varCount(); var++)
+    {
+        if (value[var] != -1)
+            continue;
+
+        int size = __builtin_popcount(domain[var] & available[layerOf(var)]);
+        int degree = 0;
+        for (int j = 0; j < 6; j++)
+        {
+            int neighbor = neighborOf(var, j);
+            if (neighbor != -1 && value[neighbor] == -1)
+                degree++;
+        }
+
+        if (size < bestSize || (size == bestSize && degree > bestDegree))
+        {
+            best = var;
+            bestSize = size;
+            bestDegree = degree;
+        }
+    }
+    return best;
+}
+
+/**
+ * Levels responsible for a variable running out of candidates
+ *
+ * Candidates are lost either because an assignment on a neighbouring or
+ * partner variable pruned them, or because the pool of that value is
+ * already used up.
+ *
+ * @param var Variable index
+ * @return Mask of search levels that pruned or used up its candidates
+ */
+template <class Geometry>
+uint64_t BoardSolver<Geometry>::culpritsOf(int var) const
+{
+    int layer = layerOf(var);
+    uint64_t culprits = prunedBy[var];
+    uint16_t exhausted = domain[var] & ~available[layer];
+    for (int x = 0; x <= TOKEN_TYPES; x++)
+    {
+        if (exhausted & (1 << x))
+            culprits |= valueLevels[layer][x];
+    }
+    return culprits;
+}
+
+/**
+ * Recursive search step with forward checking and conflict-directed backjumping
+ *
+ * Every level records which earlier levels removed candidates from the
+ * variables it touches. When a variable runs dry, the search returns to
+ * the most recent culprit level rather than simply the previous one,
+ * carrying the remaining culprits along in that level's conflict set.
+ * A token dead end may therefore jump straight back into the resource
+ * layout that caused it. A partial board whose balance bound dropped
+ * below config.minBalance is a dead end blamed on every earlier level.
+ *
+ * @param level Search depth (number of variables assigned so far)
+ * @return SEARCH_SOLVED, SEARCH_RESTART, SEARCH_FAILED, SEARCH_INFEASIBLE,
+ *         or the level to jump back to
+ */
+template <class Geometry>
+int BoardSolver<Geometry>::search(int level)
+{
+    int var = selectVariable();
+    if (var == -1)
+        return SEARCH_SOLVED;
+
+    int layer = layerOf(var);
+    uint64_t levelBit = 1ULL << level;
+    conflicts[level] = 0;
+
+    // Collect the candidate values and randomize their order for variety
+    int8_t candidates[TOKEN_TYPES + 1];
+    int count = 0;
+    uint16_t mask = domain[var] & available[layer];
+    for (int x = 0; x <= TOKEN_TYPES; x++)
+    {
+        if (mask & (1 << x))
+            candidates[count++] = x;
+    }
+    shuffleCandidates(candidates, count, rng);
+
+    for (int c = 0; c < count; c++)
+    {
+        int x = candidates[c];
+        uint16_t bit = 1 << x;
+        int touched[7];
+        uint16_t saved[7];
+        int touchedCount = 0;
+
+        if (++nodeCount > nodeLimit)
+            return SEARCH_FAILED; // Step budget exhausted
+        if (cancel != nullptr && (nodeCount & (BOARD_SOLVER_CANCEL_CHECK - 1)) == 0 &&
+            cancel->load(std::memory_order_relaxed))
+            return SEARCH_FAILED; // Another search already found a board
+
+        // Assign the value and take it from the pool
+        value[var] = x;
+        valueLevels[layer][x] |= levelBit;
+        if (--remaining[layer][x] == 0)
+            available[layer] &= ~bit;
+        fairness.place(var % hexCount(), layer, x);
+
+        // Forward checking: prune free neighbours in this layer and the
+        // other layer of the same hex
+        for (int j = 0; j <= 6; j++)
+        {
+            int other = (j < 6) ? neighborOf(var, j) : partnerOf(var);
+            if (other == -1 || value[other] != -1)
+                continue;
+
+            uint16_t allowed = (j < 6) ? compatible[layer][x] : coupled[layer][x];
+            saved[touchedCount] = domain[other];
+            touched[touchedCount++] = other;
+            domain[other] &= allowed;
+            if (domain[other] != saved[touchedCount - 1])
+                prunedBy[other] |= levelBit;
+        }
+
+        // A board that can no longer be balanced enough is a dead end too
+        bool wipeout = false;
+        if (config.minBalance > 0 && fairness.balance() < config.minBalance)
+        {
+            conflicts[level] |= levelBit - 1;
+            wipeout = true;
+            if (++runFailures > config.numberFailureLimit)
+                return SEARCH_RESTART;
+        }
+
+        // Any free variable left without candidates makes this value a dead end
+        for (int other = 0; other < varCount() && !wipeout; other++)
+        {
+            if (value[other] == -1 && (domain[other] & available[layerOf(other)]) == 0)
+            {
+                conflicts[level] |= culpritsOf(other) & ~levelBit;
+                wipeout = true;
+
+                // Count token dead ends; too many means this layout is a poor start
+                if (layerOf(other) == 1)
+                {
+                    failureCount++;
+                    if (++runFailures > config.numberFailureLimit)
+                        return SEARCH_RESTART;
+                }
+                break;
+            }
+        }
+
+        int result = wipeout ? level : search(level + 1);
+
+        if (result < 0)
+            return result; // Solved, failed, infeasible or restarting
+
+        // Undo the assignment before trying the next value or jumping back
+        for (int t = 0; t < touchedCount; t++)
+        {
+            domain[touched[t]] = saved[t];
+            prunedBy[touched[t]] &= ~levelBit;
+        }
+        remaining[layer][x]++;
+        available[layer] |= bit;
+        valueLevels[layer][x] &= ~levelBit;
+        fairness.remove(var % hexCount(), layer);
+        value[var] = -1;
+
+        if (result < level)
+            return result; // A deeper conflict skips over this level
+    }
+
+    // Every candidate failed: jump back to the most recent culprit
+    uint64_t culprits = (conflicts[level] | culpritsOf(var)) & ~levelBit;
+    if (culprits == 0)
+        return SEARCH_INFEASIBLE; // No earlier choice is to blame: no board exists
+
+    int target = highestBit(culprits);
+    conflicts[target] |= culprits & ~(1ULL << target);
+    return target;
+}
+
+// Solvers of the supported boards (one line per geometry in BoardGeometry.h)
+template class BoardSolver<ClassicGeometry>;
+template class BoardSolver<ExtensionGeometry>;
+template class BoardSolver<MapGeometry<0>>;
+template class BoardSolver<MapGeometry<1>>;
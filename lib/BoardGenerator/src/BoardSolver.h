@@ -0,0 +1,200 @@
+/**
+ * BoardSolver.h
+ *
+ * Constraint-propagation engine used by the board generator.
+ *
+ * Resources and number tokens are solved together as one constraint
+ * problem over the hex graph. Every hex contributes two variables, its
+ * resource and its token, each holding its remaining candidates as a
+ * bitmask (6 bits for resources, 11 bits for the ten tokens plus "no
+ * token" on deserts). Assigning a variable prunes the masks of the same
+ * layer on neighbouring hexes and of the other layer on the same hex
+ * (forward checking), and the next variable to fill is always the one
+ * with the fewest candidates left (most-constrained-first). Dead ends
+ * use conflict-directed backjumping. A BoardFairness tracker follows
+ * every assignment, so partial boards that can no longer reach the
+ * configured minimum balance are abandoned early.
+ *
+ * The solver is a template over a geometry trait (BoardGeometry.h), so
+ * each board size gets its own copy with constant loop bounds and tables
+ * and arrays sized exactly for it. Maps loaded from flash (BoardMap.h)
+ * use a trait sized for the largest board whose tables are filled at
+ * boot. All state lives in these arrays, so a solve never touches the
+ * heap.
+ */
+
+#ifndef BOARDSOLVER_H
+#define BOARDSOLVER_H
+
+#include <stdint.h>
+#include <atomic>
+#include "BoardGenerator.h"
+#include "BoardRules.h"
+#include "BoardRng.h"
+#include "BoardFairness.h"
+#include "BoardGeometry.h"
+
+#define SOLVER_MAX_HEXES BOARD_MAX_HEXES         // Largest supported board (extension)
+
+#define BOARD_SOLVER_MAX_NODES 50000 // Default step budget for a single solve
+#define BOARD_SOLVER_CANCEL_CHECK 64 // Assignments between two looks at the cancel flag (power of two)
+
+/**
+ * Outcome of BoardSolver::solve
+ */
+enum SolveResult
+{
+    SOLVE_FOUND = 0,     // A valid board was placed
+    SOLVE_EXHAUSTED = 1, // The step budget ran out, or the solve was cancelled
+    SOLVE_INFEASIBLE = 2 // The search was completed: no board fits the pools, rules and minimum balance
+};
+
+/**
+ * BoardSolver class
+ *
+ * Places resources and number tokens on a hex board while honouring
+ * the adjacency rules of a BoardConfig.
+ *
+ * @tparam Geometry Board geometry trait (ClassicGeometry, ExtensionGeometry, MapGeometry)
+ */
+template <class Geometry>
+class BoardSolver
+{
+public:
+    static constexpr int HEX_COUNT = Geometry::HEX_COUNT; // Most hexes on the board (array sizes)
+    static constexpr int VAR_COUNT = 2 * HEX_COUNT;        // Most variables, resource + token per hex
+
+    static_assert(VAR_COUNT <= 64, "Search levels must fit in a 64-bit level mask");
+    static_assert(HEX_COUNT <= SOLVER_MAX_HEXES, "Board larger than SOLVER_MAX_HEXES");
+
+    /**
+     * Constructor
+     *
+     * @param config Adjacency rules and restart policy to use
+     * @param rng Random generator used to order candidates
+     * @param cancel Optional flag another thread sets to stop the solve
+     */
+    BoardSolver(const BoardConfig &config, BoardRng &rng, const std::atomic<bool> *cancel = nullptr);
+
+    /**
+     * Place resources and number tokens on every hex
+     *
+     * Each run of the search gives up after config.numberFailureLimit
+     * token dead ends and starts over with a fresh random resource layout.
+     * The whole solve fails once maxNodes assignments have been tried,
+     * or soon after the cancel flag is set. A run that backtracks out of
+     * its first level without a restart has tried every layout, which
+     * proves that no board exists.
+     *
+     * @param resources Output array of one resource ID per hex
+     * @param numbers Output array of one token value per hex (0 on deserts)
+     * @param maxNodes Step budget of the solve
+     * @return SOLVE_FOUND, SOLVE_EXHAUSTED or SOLVE_INFEASIBLE
+     */
+    SolveResult solve(int *resources, int *numbers, uint32_t maxNodes = BOARD_SOLVER_MAX_NODES);
+
+    /**
+     * Number of assignments tried during the last solve
+     */
+    uint32_t nodes() const;
+
+    /**
+     * Number of token dead ends hit during the last solve
+     */
+    uint32_t numberFailures() const;
+
+    /**
+     * Number of times the last solve started over with a fresh layout
+     */
+    uint16_t restarts() const;
+
+    /**
+     * Balance score of the board found by the last solve
+     */
+    float balance() const;
+
+private:
+    BoardConfig config;              // Adjacency rules and restart policy
+    BoardRng &rng;                   // Candidate ordering
+    const std::atomic<bool> *cancel; // Stop request from another thread, or nullptr
+    BoardFairness fairness;          // Balance of the partial board
+
+    uint32_t nodeCount;    // Assignments tried in this solve
+    uint32_t nodeLimit;    // Step budget of this solve
+    uint32_t failureCount; // Token dead ends in this solve
+    uint32_t runFailures;  // Token and balance dead ends in the current run
+    uint16_t restartCount; // Runs started over in this solve
+
+    // Variable v < hexCount() is the resource of hex v, otherwise the token of hex v - hexCount()
+    uint16_t compatible[2][TOKEN_TYPES + 1]; // Values allowed next to each value, per layer
+    uint16_t coupled[2][TOKEN_TYPES + 1];    // Values allowed on the same hex's other layer
+    uint8_t initialCount[2][TOKEN_TYPES + 1]; // Pool size of each value, per layer
+
+    uint16_t domain[VAR_COUNT];                 // Candidate mask per variable
+    int8_t value[VAR_COUNT];                    // Assigned value per variable (-1 if free)
+    uint8_t remaining[2][TOKEN_TYPES + 1];      // Pool left of each value, per layer
+    uint16_t available[2];                      // Mask of values with pool left, per layer
+    uint64_t valueLevels[2][TOKEN_TYPES + 1];   // Search levels holding each value, per layer
+    uint64_t prunedBy[VAR_COUNT];               // Levels that removed candidates from each variable
+    uint64_t conflicts[VAR_COUNT];              // Conflict set of each search level
+
+    /**
+     * Hexes on the board (HEX_COUNT, except for maps loaded at runtime)
+     */
+    static int hexCount() { return Geometry::hexCount(); }
+
+    /**
+     * Variables of the search, two per hex
+     */
+    static int varCount() { return 2 * Geometry::hexCount(); }
+
+    /**
+     * Reset every variable and pool for a fresh run
+     */
+    void reset();
+
+    /**
+     * Layer (0 = resource, 1 = token) of a variable
+     */
+    int layerOf(int var) const;
+
+    /**
+     * Neighbouring variable in the same layer
+     *
+     * @param var Variable index
+     * @param direction Neighbour slot (0-5)
+     * @return Variable index, or -1 for the board edge
+     */
+    int neighborOf(int var, int direction) const;
+
+    /**
+     * Other-layer variable of the same hex
+     */
+    int partnerOf(int var) const;
+
+    /**
+     * Pick the free variable with the fewest candidates
+     *
+     * @return Variable index, or -1 if every variable is assigned
+     */
+    int selectVariable() const;
+
+    /**
+     * Levels responsible for a variable running out of candidates
+     *
+     * @param var Variable index
+     * @return Mask of search levels that pruned or used up its candidates
+     */
+    uint64_t culpritsOf(int var) const;
+
+    /**
+     * Recursive search step with conflict-directed backjumping
+     *
+     * @param level Search depth (number of variables assigned so far)
+     * @return SEARCH_SOLVED, SEARCH_RESTART, SEARCH_FAILED, SEARCH_INFEASIBLE,
+     *         or the level to jump back to
+     */
+    int search(int level);
+};
+
+#endif // BOARDSOLVER_H
@@ -0,0 +1,171 @@
+#include "BoardSymmetry.h"
+
+// Axial coordinate offset (q, r) of each neighbour slot:
+// upper-left, upper-right, left, right, lower-left, lower-right
+static const int SLOT_DQ[6] = {0, 1, -1, 1, -1, 0};
+static const int SLOT_DR[6] = {-1, -1, 0, 0, 1, 1};
+
+/**
+ * Apply one of the twelve rotations/reflections of the hex grid
+ *
+ * @param transform 0-5 rotate by transform * 60 degrees, 6-11 also reflect
+ * @param q Axial column, updated in place
+ * @param r Axial row, updated in place
+ */
+static void transformAxial(int transform, int &q, int &r)
+{
+    if (transform >= 6)
+    {
+        // Reflection across the q axis
+        r = -q - r;
+    }
+    for (int i = 0; i < transform % 6; i++)
+    {
+        // Rotation by 60 degrees
+        int rotated = -r;
+        r = q + r;
+        q = rotated;
+    }
+}
+
+/**
+ * Constructor - find every symmetry of a board
+ *
+ * Positions are laid out from hex 0 following only links listed by both
+ * hexes, so a one-sided entry in the table cannot misplace a hex. A
+ * candidate symmetry is kept if it moves every hex onto a hex and every
+ * neighbour pair (listed by either side) onto a neighbour pair.
+ *
+ * @param adjacencyList Neighbour table of the board (-1 for no neighbour)
+ * @param hexCount Number of hexes on the board
+ */
+BoardSymmetry::BoardSymmetry(const int (*adjacencyList)[6], int hexCount)
+    : hexCount(hexCount), symmetryCount(1)
+{
+    for (int hex = 0; hex < hexCount; hex++)
+        map[0][hex] = hex;
+
+    // Lay out axial positions from hex 0
+    int q[SOLVER_MAX_HEXES];
+    int r[SOLVER_MAX_HEXES];
+    bool placed[SOLVER_MAX_HEXES] = {};
+    int queue[SOLVER_MAX_HEXES];
+    int head = 0;
+    int tail = 0;
+    q[0] = 0;
+    r[0] = 0;
+    placed[0] = true;
+    queue[tail++] = 0;
+    while (head < tail)
+    {
+        int hex = queue[head++];
+        for (int slot = 0; slot < 6; slot++)
+        {
+            int other = adjacencyList[hex][slot];
+            if (other == -1 || placed[other] || adjacencyList[other][5 - slot] != hex)
+                continue;
+            q[other] = q[hex] + SLOT_DQ[slot];
+            r[other] = r[hex] + SLOT_DR[slot];
+            placed[other] = true;
+            queue[tail++] = other;
+        }
+    }
+    if (tail != hexCount)
+        return; // Not a connected hex board: only the identity
+
+    // Neighbour pairs, listed by either side
+    uint32_t neighbors[SOLVER_MAX_HEXES] = {};
+    for (int hex = 0; hex < hexCount; hex++)
+    {
+        for (int slot = 0; slot < 6; slot++)
+        {
+            int other = adjacencyList[hex][slot];
+            if (other != -1)
+            {
+                neighbors[hex] |= 1UL << other;
+                neighbors[other] |= 1UL << hex;
+            }
+        }
+    }
+
+    for (int transform = 0; transform < SYMMETRY_MAX; transform++)
+    {
+        int tq[SOLVER_MAX_HEXES];
+        int tr[SOLVER_MAX_HEXES];
+        for (int hex = 0; hex < hexCount; hex++)
+        {
+            tq[hex] = q[hex];
+            tr[hex] = r[hex];
+            transformAxial(transform, tq[hex], tr[hex]);
+        }
+
+        // Try every placement of the transformed board: hex 0 lands on "target"
+        for (int target = 0; target < hexCount; target++)
+        {
+            int dq = q[target] - tq[0];
+            int dr = r[target] - tr[0];
+            int8_t candidate[SOLVER_MAX_HEXES];
+            bool valid = true;
+
+            for (int hex = 0; hex < hexCount && valid; hex++)
+            {
+                candidate[hex] = -1;
+                for (int other = 0; other < hexCount; other++)
+                {
+                    if (q[other] == tq[hex] + dq && r[other] == tr[hex] + dr)
+                    {
+                        candidate[hex] = other;
+                        break;
+                    }
+                }
+                valid = candidate[hex] != -1;
+            }
+
+            // Every neighbour pair has to stay a neighbour pair
+            for (int hex = 0; hex < hexCount && valid; hex++)
+            {
+                for (int other = 0; other < hexCount && valid; other++)
+                {
+                    if ((neighbors[hex] >> other) & 1)
+                        valid = (neighbors[candidate[hex]] >> candidate[other]) & 1;
+                }
+            }
+
+            // Skip permutations already found (the identity is stored first)
+            for (int s = 0; s < symmetryCount && valid; s++)
+            {
+                bool same = true;
+                for (int hex = 0; hex < hexCount && same; hex++)
+                    same = map[s][hex] == candidate[hex];
+                valid = !same;
+            }
+
+            if (valid && symmetryCount < SYMMETRY_MAX)
+            {
+                for (int hex = 0; hex < hexCount; hex++)
+                    map[symmetryCount][hex] = candidate[hex];
+                symmetryCount++;
+            }
+        }
+    }
+}
+
+/**
+ * Number of symmetries, the identity included
+ */
+int BoardSymmetry::count() const
+{
+    return symmetryCount;
+}
+
+/**
+ * Position a hex is moved to by a symmetry
+ *
+ * @param symmetry Symmetry index (0 is the identity)
+ * @param hex Hex index
+ * @return Hex index of the image
+ */
+int BoardSymmetry::image(int symmetry, int hex) const
+{
+    return map[symmetry][hex];
+}
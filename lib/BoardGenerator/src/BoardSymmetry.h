@@ -0,0 +1,58 @@
+/**
+ * BoardSymmetry.h
+ *
+ * Rotations and reflections of a hex board that map the board onto
+ * itself and keep every neighbour pair a neighbour pair.
+ *
+ * Hex positions are recovered from the neighbour table (the six slots
+ * are upper-left, upper-right, left, right, lower-left and lower-right),
+ * then each of the twelve rotations/reflections of the hex grid is tried
+ * at every placement. The classic board has up to 12 symmetries, the
+ * extension board up to 4.
+ */
+
+#ifndef BOARDSYMMETRY_H
+#define BOARDSYMMETRY_H
+
+#include <stdint.h>
+#include "BoardSolver.h"
+
+#define SYMMETRY_MAX 12 // Rotations and reflections of the hex grid
+
+/**
+ * BoardSymmetry class
+ *
+ * Symmetry group of one board, as hex permutations
+ */
+class BoardSymmetry
+{
+public:
+    /**
+     * Constructor - find every symmetry of a board
+     *
+     * @param adjacencyList Neighbour table of the board (-1 for no neighbour)
+     * @param hexCount Number of hexes on the board
+     */
+    BoardSymmetry(const int (*adjacencyList)[6], int hexCount);
+
+    /**
+     * Number of symmetries, the identity included
+     */
+    int count() const;
+
+    /**
+     * Position a hex is moved to by a symmetry
+     *
+     * @param symmetry Symmetry index (0 is the identity)
+     * @param hex Hex index
+     * @return Hex index of the image
+     */
+    int image(int symmetry, int hex) const;
+
+private:
+    int hexCount;                             // Number of hexes on the board
+    int symmetryCount;                        // Number of symmetries found
+    int8_t map[SYMMETRY_MAX][SOLVER_MAX_HEXES]; // Hex permutation of each symmetry
+};
+
+#endif // BOARDSYMMETRY_H
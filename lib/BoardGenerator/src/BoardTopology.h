@@ -0,0 +1,298 @@
+/**
+ * BoardTopology.h
+ *
+ * Vertex and edge graph of the classic and extension boards.
+ *
+ * adjancency.h only lists which hexes touch. Settlement spots (vertices,
+ * where up to three hexes meet) and roads or harbours (edges, the sides
+ * between two vertices) are derived from it here, at compile time, so
+ * every lookup is a plain table read.
+ *
+ * Hex corners are numbered clockwise from the top (0 top, 1 upper right,
+ * 2 lower right, 3 bottom, 4 lower left, 5 upper left) and hex side s
+ * runs from corner s to corner s + 1. Neighbour slots follow the
+ * adjacency tables: 0 upper left, 1 upper right, 2 left, 3 right,
+ * 4 lower left, 5 lower right; the opposite of slot d is 5 - d.
+ *
+ * The same headers also check the adjacency tables themselves: every
+ * link must be listed by both hexes, in opposite slots.
+ */
+
+#ifndef BOARDTOPOLOGY_H
+#define BOARDTOPOLOGY_H
+
+#include <stdint.h>
+#include "adjancency.h"
+
+#define TOPOLOGY_MAX_HEXES 30    // Hexes of the largest board (extension)
+#define TOPOLOGY_MAX_VERTICES 80 // Vertices of the largest board
+#define TOPOLOGY_MAX_EDGES 109   // Edges of the largest board
+
+/**
+ * BoardTopology structure
+ *
+ * Vertices and edges of one board, with every incidence in both directions.
+ * Unused slots hold -1.
+ */
+struct BoardTopology
+{
+    int hexCount = 0;    // Hexes on the board
+    int vertexCount = 0; // Vertices (settlement spots)
+    int edgeCount = 0;   // Edges (road spots)
+
+    int8_t hexVertices[TOPOLOGY_MAX_HEXES][6] = {}; // Vertex at each corner of a hex
+    int8_t hexEdges[TOPOLOGY_MAX_HEXES][6] = {};    // Edge on each side of a hex
+
+    int8_t vertexHexes[TOPOLOGY_MAX_VERTICES][3] = {};     // Hexes meeting at a vertex
+    uint8_t vertexHexCount[TOPOLOGY_MAX_VERTICES] = {};    // Number of them (1-3)
+    int8_t vertexNeighbors[TOPOLOGY_MAX_VERTICES][3] = {}; // Vertices one edge away
+    int8_t vertexEdges[TOPOLOGY_MAX_VERTICES][3] = {};     // Edges ending at a vertex, matching vertexNeighbors
+    uint8_t vertexDegree[TOPOLOGY_MAX_VERTICES] = {};      // Number of them (2-3)
+
+    int8_t edgeVertices[TOPOLOGY_MAX_EDGES][2] = {}; // End points of an edge
+    int8_t edgeHexes[TOPOLOGY_MAX_EDGES][2] = {};    // Hexes on both sides (second is -1 on the coast)
+};
+
+/**
+ * Corners of a hex shared with its neighbours
+ *
+ * Each corner is shared with the neighbours in two slots, where it is the
+ * listed corner of the neighbour: {slot, neighbour's corner}.
+ */
+static constexpr int8_t CORNER_LINKS[6][2][2] = {
+    {{0, 2}, {1, 4}}, // Top: upper left's lower right, upper right's lower left
+    {{1, 3}, {3, 5}}, // Upper right: upper right's bottom, right's upper left
+    {{3, 4}, {5, 0}}, // Lower right: right's lower left, lower right's top
+    {{5, 5}, {4, 1}}, // Bottom: lower right's upper left, lower left's upper right
+    {{4, 0}, {2, 2}}, // Lower left: lower left's top, left's lower right
+    {{2, 1}, {0, 3}}, // Upper left: left's upper right, upper left's bottom
+};
+
+/**
+ * Neighbour slot across each side of a hex (the neighbour sees it as side s + 3)
+ */
+static constexpr int8_t SIDE_SLOTS[6] = {1, 3, 5, 4, 2, 0};
+
+/**
+ * Check that an adjacency table is symmetric
+ *
+ * Every neighbour must be a valid hex that lists the first hex back in
+ * the opposite slot.
+ *
+ * @param adjacencyList Neighbour table (-1 for no neighbour)
+ * @param hexCount Number of hexes
+ * @return Index of the first inconsistent hex, or -1 if the table is consistent
+ */
+constexpr int findAdjacencyError(const int (*adjacencyList)[6], int hexCount)
+{
+    for (int hex = 0; hex < hexCount; hex++)
+    {
+        for (int slot = 0; slot < 6; slot++)
+        {
+            int neighbor = adjacencyList[hex][slot];
+            if (neighbor == -1)
+                continue;
+            if (neighbor < 0 || neighbor >= hexCount || neighbor == hex)
+                return hex;
+            if (adjacencyList[neighbor][5 - slot] != hex)
+                return hex;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Mark a topology that could not be built
+ *
+ * @param topology Partly built topology
+ * @return The same topology, rejected by topologyConsistent
+ */
+constexpr BoardTopology invalidTopology(BoardTopology topology)
+{
+    topology.vertexCount = TOPOLOGY_MAX_VERTICES + 1;
+    return topology;
+}
+
+/**
+ * Build the vertex and edge graph of a board
+ *
+ * Corners and sides are numbered in hex order: each gets the vertex or
+ * edge of the earlier neighbour that shares it, or a new one. A table
+ * that does not describe a hex map may need more vertices, edges or
+ * incidences than the arrays hold; building then stops with vertexCount
+ * above TOPOLOGY_MAX_VERTICES, which topologyConsistent rejects.
+ *
+ * @param adjacencyList Symmetric neighbour table
+ * @param hexCount Number of hexes
+ * @return Topology of the board
+ */
+constexpr BoardTopology buildTopology(const int (*adjacencyList)[6], int hexCount)
+{
+    BoardTopology topology;
+    topology.hexCount = hexCount;
+
+    for (int hex = 0; hex < hexCount; hex++)
+    {
+        for (int i = 0; i < 6; i++)
+        {
+            topology.hexVertices[hex][i] = -1;
+            topology.hexEdges[hex][i] = -1;
+        }
+    }
+    for (int vertex = 0; vertex < TOPOLOGY_MAX_VERTICES; vertex++)
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            topology.vertexHexes[vertex][i] = -1;
+            topology.vertexNeighbors[vertex][i] = -1;
+            topology.vertexEdges[vertex][i] = -1;
+        }
+    }
+    for (int edge = 0; edge < TOPOLOGY_MAX_EDGES; edge++)
+    {
+        topology.edgeVertices[edge][0] = topology.edgeVertices[edge][1] = -1;
+        topology.edgeHexes[edge][0] = topology.edgeHexes[edge][1] = -1;
+    }
+
+    // Vertices: a corner takes the vertex of the neighbour already holding it
+    for (int hex = 0; hex < hexCount; hex++)
+    {
+        for (int corner = 0; corner < 6; corner++)
+        {
+            if (topology.hexVertices[hex][corner] != -1)
+                continue;
+
+            if (topology.vertexCount == TOPOLOGY_MAX_VERTICES)
+                return invalidTopology(topology);
+            int vertex = topology.vertexCount++;
+            topology.hexVertices[hex][corner] = vertex;
+            for (int link = 0; link < 2; link++)
+            {
+                int neighbor = adjacencyList[hex][CORNER_LINKS[corner][link][0]];
+                if (neighbor != -1)
+                    topology.hexVertices[neighbor][CORNER_LINKS[corner][link][1]] = vertex;
+            }
+        }
+        for (int corner = 0; corner < 6; corner++)
+        {
+            int vertex = topology.hexVertices[hex][corner];
+            if (topology.vertexHexCount[vertex] == 3)
+                return invalidTopology(topology);
+            topology.vertexHexes[vertex][topology.vertexHexCount[vertex]++] = hex;
+        }
+    }
+
+    // Edges: a side takes the edge of the neighbour across it
+    for (int hex = 0; hex < hexCount; hex++)
+    {
+        for (int side = 0; side < 6; side++)
+        {
+            if (topology.hexEdges[hex][side] != -1)
+                continue;
+
+            int from = topology.hexVertices[hex][side];
+            int to = topology.hexVertices[hex][(side + 1) % 6];
+            if (topology.edgeCount == TOPOLOGY_MAX_EDGES || topology.vertexDegree[from] == 3 || topology.vertexDegree[to] == 3)
+                return invalidTopology(topology);
+            int edge = topology.edgeCount++;
+            topology.hexEdges[hex][side] = edge;
+            topology.edgeVertices[edge][0] = from;
+            topology.edgeVertices[edge][1] = to;
+            topology.edgeHexes[edge][0] = hex;
+
+            int neighbor = adjacencyList[hex][SIDE_SLOTS[side]];
+            if (neighbor != -1)
+            {
+                topology.hexEdges[neighbor][(side + 3) % 6] = edge;
+                topology.edgeHexes[edge][1] = neighbor;
+            }
+
+            topology.vertexNeighbors[from][topology.vertexDegree[from]] = to;
+            topology.vertexEdges[from][topology.vertexDegree[from]++] = edge;
+            topology.vertexNeighbors[to][topology.vertexDegree[to]] = from;
+            topology.vertexEdges[to][topology.vertexDegree[to]++] = edge;
+        }
+    }
+    return topology;
+}
+
+/**
+ * Check that a topology is a consistent hex map
+ *
+ * Every vertex touches 1-3 hexes and 2-3 edges, every incidence is listed
+ * from both sides, and the counts satisfy Euler's formula for a map of
+ * hexCount hexes (V - E + hexCount = 1).
+ *
+ * @param topology Topology to check
+ * @return True if consistent
+ */
+constexpr bool topologyConsistent(const BoardTopology &topology)
+{
+    if (topology.vertexCount > TOPOLOGY_MAX_VERTICES || topology.edgeCount > TOPOLOGY_MAX_EDGES)
+        return false;
+    if (topology.vertexCount - topology.edgeCount + topology.hexCount != 1)
+        return false;
+
+    for (int vertex = 0; vertex < topology.vertexCount; vertex++)
+    {
+        int hexes = topology.vertexHexCount[vertex];
+        int degree = topology.vertexDegree[vertex];
+        if (hexes < 1 || hexes > 3 || degree < 2 || degree > 3)
+            return false;
+        for (int i = 0; i < hexes; i++)
+        {
+            int hex = topology.vertexHexes[vertex][i];
+            bool listed = false;
+            for (int corner = 0; corner < 6; corner++)
+                listed = listed || topology.hexVertices[hex][corner] == vertex;
+            if (!listed)
+                return false;
+        }
+    }
+
+    for (int edge = 0; edge < topology.edgeCount; edge++)
+    {
+        for (int end = 0; end < 2; end++)
+        {
+            int vertex = topology.edgeVertices[edge][end];
+            int other = topology.edgeVertices[edge][1 - end];
+            bool listed = false;
+            for (int i = 0; i < topology.vertexDegree[vertex]; i++)
+                listed = listed || (topology.vertexEdges[vertex][i] == edge && topology.vertexNeighbors[vertex][i] == other);
+            if (!listed)
+                return false;
+        }
+    }
+    return true;
+}
+
+static_assert(findAdjacencyError(adjacencyListClassic, 19) == -1, "adjacencyListClassic is not symmetric");
+static_assert(findAdjacencyError(adjacencyListExtension, 30) == -1, "adjacencyListExtension is not symmetric");
+
+/**
+ * Topology of the classic 19-hex board
+ */
+inline constexpr BoardTopology CLASSIC_TOPOLOGY = buildTopology(adjacencyListClassic, 19);
+
+/**
+ * Topology of the extension 30-hex board
+ */
+inline constexpr BoardTopology EXTENSION_TOPOLOGY = buildTopology(adjacencyListExtension, 30);
+
+static_assert(CLASSIC_TOPOLOGY.vertexCount == 54 && CLASSIC_TOPOLOGY.edgeCount == 72, "Classic board should have 54 vertices and 72 edges");
+static_assert(EXTENSION_TOPOLOGY.vertexCount == 80 && EXTENSION_TOPOLOGY.edgeCount == 109, "Extension board should have 80 vertices and 109 edges");
+static_assert(topologyConsistent(CLASSIC_TOPOLOGY), "Classic topology is inconsistent");
+static_assert(topologyConsistent(EXTENSION_TOPOLOGY), "Extension topology is inconsistent");
+
+/**
+ * Topology of the classic or extension board
+ *
+ * @param isExtension True for the 30-hex extension board
+ * @return Board topology
+ */
+inline const BoardTopology &boardTopology(bool isExtension)
+{
+    return isExtension ? EXTENSION_TOPOLOGY : CLASSIC_TOPOLOGY;
+}
+
+#endif // BOARDTOPOLOGY_H
@@ -6,6 +6,9 @@
  *
  * Each hex can have up to 6 neighbors (hexagonal grid).
  * The tables use -1 to indicate no neighbor in that direction.
+ *
+ * The tables are constexpr so BoardTopology.h can derive the vertex and
+ * edge graph from them (and check that they are symmetric) at compile time.
  */
 
 #ifndef ADJACENCY_H
@@ -27,7 +30,7 @@
  *   - Row 3: 4 hexes (positions 12-15)
  *   - Row 4: 3 hexes (positions 16-18)
  */
-static const int adjacencyListClassic[19][6] = {
+static constexpr int adjacencyListClassic[19][6] = {
     // Row 0 (3 tiles): indices 0, 1, 2
     /* tile 0 */ {-1, -1, -1, 1, 3, 4},
     /* tile 1 */ {-1, -1, 0, 2, 4, 5},
@@ -44,7 +47,7 @@ static const int adjacencyListClassic[19][6] = {
     /* tile 8 */ {3, 4, 7, 9, 12, 13},
     /* tile 9 */ {4, 5, 8, 10, 13, 14},
     /* tile 10 */ {5, 6, 9, 11, 14, 15},
-    /* tile 11 */ {6, -1, 10, -1, 14, 15},
+    /* tile 11 */ {6, -1, 10, -1, 15, -1},
 
     // Row 3 (4 tiles): indices 12, 13, 14, 15
     /* tile 12 */ {7, 8, -1, 13, -1, 16},
@@ -72,7 +75,7 @@ static const int adjacencyListClassic[19][6] = {
  *   - Row 4: 5 hexes (positions 21-25)
  *   - Row 5: 4 hexes (positions 26-29)
  */
-static const int adjacencyListExtension[30][6] = {
+static constexpr int adjacencyListExtension[30][6] = {
     // Row 0 (4 tiles)
     /* tile 0 */ {-1, -1, -1, 1, 4, 5},
     /* tile 1 */ {-1, -1, 0, 2, 5, 6},
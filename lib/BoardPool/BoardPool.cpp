@@ -0,0 +1,201 @@
+#include "BoardPool.h"
+
+/**
+ * Constructor
+ * The refill task and its lock are only created by begin()
+ */
+BoardPool::BoardPool()
+    : lock(NULL), refillHandle(NULL), generation(0), hitCount(0), missCount(0)
+{
+    head[0] = head[1] = 0;
+    count[0] = count[1] = 0;
+}
+
+/**
+ * Start the background refill task
+ */
+void BoardPool::begin(const BoardConfig &config)
+{
+    if (refillHandle != NULL)
+        return;
+
+    this->config = config;
+    lock = xSemaphoreCreateMutex();
+
+    // Create the refill task on core 1 at idle priority
+    xTaskCreatePinnedToCore(
+        refillTask,               // Task function
+        "BoardPoolTask",          // Name of task
+        BOARD_POOL_STACK_SIZE,    // Stack size (bytes)
+        (void *)this,             // Parameters
+        BOARD_POOL_TASK_PRIORITY, // Priority
+        &refillHandle,            // Task handle
+        BOARD_POOL_TASK_CORE      // Core where the task should run
+    );
+}
+
+/**
+ * Take a ready board out of the pool
+ */
+bool BoardPool::pop(bool isExtension, Board &board)
+{
+    if (lock == NULL)
+    {
+        missCount++;
+        return false;
+    }
+
+    int size = isExtension ? 1 : 0;
+    bool hit = false;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    if (count[size] > 0)
+    {
+        board = ring[size][head[size]];
+        head[size] = (head[size] + 1) % BOARD_POOL_SIZE;
+        count[size]--;
+        hit = true;
+    }
+    xSemaphoreGive(lock);
+
+    if (hit)
+        hitCount++;
+    else
+        missCount++;
+
+    // Wake the refill task so the slot gets filled again
+    xTaskNotifyGive(refillHandle);
+    return hit;
+}
+
+/**
+ * Update the rules of the pooled boards
+ */
+void BoardPool::setConfig(const BoardConfig &config)
+{
+    if (lock == NULL)
+    {
+        this->config = config;
+        return;
+    }
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    bool changed = !sameRules(this->config, config);
+    this->config = config;
+    if (changed)
+    {
+        // Boards made under the old rules may break the new ones
+        for (int size = 0; size < 2; size++)
+        {
+            head[size] = 0;
+            count[size] = 0;
+        }
+        generation++;
+    }
+    xSemaphoreGive(lock);
+
+    if (changed)
+    {
+        Serial.println("Board pool invalidated: rules changed.");
+        xTaskNotifyGive(refillHandle);
+    }
+}
+
+/**
+ * Number of pop() calls served from the pool
+ */
+uint32_t BoardPool::hits() const
+{
+    return hitCount;
+}
+
+/**
+ * Number of pop() calls that found the pool empty
+ */
+uint32_t BoardPool::misses() const
+{
+    return missCount;
+}
+
+/**
+ * Number of ready boards of one size
+ */
+uint8_t BoardPool::available(bool isExtension) const
+{
+    return count[isExtension ? 1 : 0];
+}
+
+/**
+ * Check whether two configurations share the same adjacency rules
+ * The board size is not compared: each size has its own ring.
+ */
+bool BoardPool::sameRules(const BoardConfig &a, const BoardConfig &b)
+{
+    return a.eightSixCanTouch == b.eightSixCanTouch &&
+           a.twoTwelveCanTouch == b.twoTwelveCanTouch &&
+           a.sameNumbersCanTouch == b.sameNumbersCanTouch &&
+           a.sameResourceCanTouch == b.sameResourceCanTouch &&
+           a.minBalance == b.minBalance &&
+           a.numberFailureLimit == b.numberFailureLimit;
+}
+
+/**
+ * Static refill task function
+ *
+ * Picks the ring with the fewest boards (the size being played wins a
+ * tie), generates one board outside the lock and stores it, unless the
+ * rules changed in the meantime. A size for which no board can be found
+ * under the current rules counts as full until the rules change. Sleeps
+ * once both rings are full until a pop or an invalidation wakes it up.
+ */
+void BoardPool::refillTask(void *parameter)
+{
+    BoardPool *pool = (BoardPool *)parameter;
+    bool failed[2] = {false, false}; // Sizes the current rules produce no board for
+    uint32_t failedGeneration = 0;   // Rules generation the failures belong to
+
+    while (true)
+    {
+        // Decide which ring needs a board, under the current rules
+        xSemaphoreTake(pool->lock, portMAX_DELAY);
+        uint32_t generation = pool->generation;
+        if (generation != failedGeneration)
+        {
+            failed[0] = failed[1] = false;
+            failedGeneration = generation;
+        }
+        int current = pool->config.isExtension ? 1 : 0;
+        int fill[2];
+        for (int s = 0; s < 2; s++)
+            fill[s] = failed[s] ? BOARD_POOL_SIZE : pool->count[s];
+        int size = (fill[1 - current] < fill[current]) ? 1 - current : current;
+        bool full = fill[size] >= BOARD_POOL_SIZE;
+        BoardConfig config = pool->config;
+        xSemaphoreGive(pool->lock);
+
+        if (full)
+        {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(BOARD_POOL_IDLE_TIMEOUT_MS));
+            continue;
+        }
+
+        config.isExtension = (size == 1);
+        Board board = generateBoard(config);
+        if (board.empty())
+        {
+            Serial.println("Board pool: no board found under the current rules.");
+            failed[size] = true;
+            continue;
+        }
+
+        // Store the board unless it was made under outdated rules
+        xSemaphoreTake(pool->lock, portMAX_DELAY);
+        if (generation == pool->generation && pool->count[size] < BOARD_POOL_SIZE)
+        {
+            int tail = (pool->head[size] + pool->count[size]) % BOARD_POOL_SIZE;
+            pool->ring[size][tail] = board;
+            pool->count[size]++;
+        }
+        xSemaphoreGive(pool->lock);
+    }
+}
@@ -0,0 +1,110 @@
+/**
+ * BoardPool.h
+ *
+ * This header defines the BoardPool class which keeps a few boards
+ * generated ahead of time, so a shuffle request can be answered without
+ * waiting for the solver.
+ *
+ * It handles:
+ * - A small ring of ready boards for each board size (classic, extension)
+ * - A low-priority FreeRTOS task that refills the rings while the CPU is idle
+ * - Discarding pre-generated boards when the adjacency rules change
+ * - Hit/miss counters
+ */
+
+#ifndef BOARDPOOL_H
+#define BOARDPOOL_H
+
+#include <Arduino.h>
+#include "BoardGenerator.h"
+
+#define BOARD_POOL_SIZE 4                             // Ready boards kept per board size
+#define BOARD_POOL_STACK_SIZE BOARD_SOLVER_STACK_SIZE // Stack size for the refill task
+#define BOARD_POOL_TASK_PRIORITY 0                    // Idle priority, so shuffles and LEDs always come first
+#define BOARD_POOL_TASK_CORE 1                        // Core to run the refill task on
+#define BOARD_POOL_IDLE_TIMEOUT_MS 1000               // Longest sleep of the refill task while the pool is full
+
+/**
+ * BoardPool class
+ *
+ * Ring buffers of pre-generated boards for the current adjacency rules
+ */
+class BoardPool
+{
+public:
+    /**
+     * Constructor
+     */
+    BoardPool();
+
+    /**
+     * Start the background refill task
+     *
+     * @param config Rules the pooled boards have to follow
+     */
+    void begin(const BoardConfig &config);
+
+    /**
+     * Take a ready board out of the pool
+     *
+     * @param isExtension Board size to take (classic or extension)
+     * @param board Output board, only written on a hit
+     * @return True if a board was available (hit), false otherwise (miss)
+     */
+    bool pop(bool isExtension, Board &board);
+
+    /**
+     * Update the rules of the pooled boards
+     * Every pooled board is thrown away if any adjacency rule changed;
+     * switching between classic and extension keeps both rings.
+     *
+     * @param config New board configuration
+     */
+    void setConfig(const BoardConfig &config);
+
+    /**
+     * Number of pop() calls served from the pool
+     */
+    uint32_t hits() const;
+
+    /**
+     * Number of pop() calls that found the pool empty
+     */
+    uint32_t misses() const;
+
+    /**
+     * Number of ready boards of one size
+     *
+     * @param isExtension Board size to count
+     */
+    uint8_t available(bool isExtension) const;
+
+private:
+    SemaphoreHandle_t lock;    // Guards every member below
+    TaskHandle_t refillHandle; // Handle to the FreeRTOS refill task
+
+    BoardConfig config;  // Rules of the pooled boards
+    uint32_t generation; // Bumped on every invalidation, so in-flight boards can be dropped
+
+    Board ring[2][BOARD_POOL_SIZE]; // Ready boards, [0] classic and [1] extension
+    uint8_t head[2];                // Index of the oldest ready board per ring
+    uint8_t count[2];               // Number of ready boards per ring
+
+    volatile uint32_t hitCount;  // Pops served from the pool
+    volatile uint32_t missCount; // Pops that found the pool empty
+
+    /**
+     * Check whether two configurations share the same adjacency rules
+     */
+    static bool sameRules(const BoardConfig &a, const BoardConfig &b);
+
+    /**
+     * Static refill task function
+     * Generates boards for the emptiest ring until both are full
+     *
+     * @param parameter Pointer to the BoardPool instance
+     */
+    static void refillTask(void *parameter);
+};
+
+#endif // BOARDPOOL_H
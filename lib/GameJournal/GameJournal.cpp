@@ -0,0 +1,310 @@
+#include <string.h>
+#include "GameJournal.h"
+
+#define RECORD_HEADER_BYTES 2 // Type and payload length
+#define RECORD_CRC_BYTES 4    // CRC-32 after the payload
+#define SNAPSHOT_PAYLOAD_BYTES (16 + 8 * BOARD_WORDS) // Generation, flags, minBalance, number, seed, hex count, cells
+#define RECORD_FRAMING_BYTES (RECORD_HEADER_BYTES + RECORD_CRC_BYTES)
+#define HISTORY_RECORDS ((ROLL_HISTORY_LENGTH + JOURNAL_ROLLS_PER_RECORD - 1) / JOURNAL_ROLLS_PER_RECORD) // Records carrying a full ring
+#define COMPACTED_MAX_BYTES (ROLL_STATS_BYTES + 4 * ROLL_HISTORY_LENGTH + SNAPSHOT_PAYLOAD_BYTES + \
+                             (HISTORY_RECORDS + 2) * RECORD_FRAMING_BYTES) // Largest freshly compacted journal
+
+static_assert(ROLL_STATS_BYTES + RECORD_FRAMING_BYTES <= JOURNAL_MAX_RECORD, "Statistics must fit one record");
+static_assert(4 * JOURNAL_ROLLS_PER_RECORD + RECORD_FRAMING_BYTES <= JOURNAL_MAX_RECORD, "Rolls must fit one record");
+static_assert(2 * COMPACTED_MAX_BYTES <= JOURNAL_COMPACT_BYTES, "A compacted journal must leave room for new rolls");
+
+/**
+ * Store an unsigned integer in little-endian order
+ */
+static void putLittle(uint8_t *out, uint64_t value, int bytes)
+{
+    for (int i = 0; i < bytes; i++)
+        out[i] = (uint8_t)(value >> (8 * i));
+}
+
+/**
+ * Read an unsigned integer stored in little-endian order
+ */
+static uint64_t getLittle(const uint8_t *in, int bytes)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; i++)
+        value |= (uint64_t)in[i] << (8 * i);
+    return value;
+}
+
+/**
+ * CRC-32 (IEEE 802.3) of a buffer
+ * Bitwise, since records are a few dozen bytes
+ *
+ * @param data Bytes to check
+ * @param length Number of bytes
+ * @return CRC-32
+ */
+uint32_t journalCrc32(const uint8_t *data, size_t length)
+{
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < length; i++)
+    {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+    return ~crc;
+}
+
+/**
+ * Constructor
+ * Nothing is read until load()
+ */
+GameJournal::GameJournal(JournalStorage &storage)
+    : storage(storage), activeFile(-1), generation(0), activeBytes(0), tornTail(false), compactionCount(0)
+{
+}
+
+/**
+ * Frame a record: type, length, payload and CRC
+ */
+size_t GameJournal::frame(uint8_t type, const uint8_t *payload, size_t length, uint8_t *record)
+{
+    record[0] = type;
+    record[1] = (uint8_t)length;
+    memcpy(record + RECORD_HEADER_BYTES, payload, length);
+    uint32_t crc = journalCrc32(record, RECORD_HEADER_BYTES + length);
+    putLittle(record + RECORD_HEADER_BYTES + length, crc, RECORD_CRC_BYTES);
+    return RECORD_HEADER_BYTES + length + RECORD_CRC_BYTES;
+}
+
+/**
+ * Replay one journal file
+ * Statistics and carried rolls come first and only count once the
+ * snapshot after them is read. Stops at the end of the file or at the
+ * first damaged, unknown or misplaced record.
+ */
+size_t GameJournal::replay(const uint8_t *data, size_t size, SavedGame &game, RollHistory &rolls, uint32_t &fileGeneration)
+{
+    size_t offset = 0;
+    size_t committed = 0;
+    bool haveSnapshot = false;
+    rolls.clear();
+    while (offset + RECORD_HEADER_BYTES + RECORD_CRC_BYTES <= size)
+    {
+        uint8_t type = data[offset];
+        size_t length = data[offset + 1];
+        size_t recordBytes = RECORD_HEADER_BYTES + length + RECORD_CRC_BYTES;
+        if (offset + recordBytes > size)
+            break;
+        const uint8_t *payload = data + offset + RECORD_HEADER_BYTES;
+        uint32_t crc = (uint32_t)getLittle(payload + length, RECORD_CRC_BYTES);
+        if (crc != journalCrc32(data + offset, RECORD_HEADER_BYTES + length))
+            break;
+
+        if (type == JOURNAL_RECORD_STATS && length == ROLL_STATS_BYTES && offset == 0)
+        {
+            rolls.decodeStats(payload);
+        }
+        else if (type == JOURNAL_RECORD_HISTORY && length % 4 == 0 && !haveSnapshot)
+        {
+            for (size_t i = 0; i < length; i += 4)
+                rolls.restore(RollEntry::unpack((uint32_t)getLittle(payload + i, 4)));
+        }
+        else if (type == JOURNAL_RECORD_SNAPSHOT && length == SNAPSHOT_PAYLOAD_BYTES && !haveSnapshot)
+        {
+            fileGeneration = (uint32_t)getLittle(payload, 4);
+            uint8_t flags = payload[4];
+            game.config.isExtension = flags & 0x01;
+            game.config.eightSixCanTouch = flags & 0x02;
+            game.config.twoTwelveCanTouch = flags & 0x04;
+            game.config.sameNumbersCanTouch = flags & 0x08;
+            game.config.sameResourceCanTouch = flags & 0x10;
+            game.manualDice = flags & 0x20;
+            game.gameStarted = flags & 0x40;
+            game.config.minBalance = payload[5];
+            game.selectedNumber = payload[6];
+            game.board.seed = getLittle(payload + 7, 8);
+            int hexCount = payload[15] <= BOARD_MAX_HEXES ? payload[15] : 0;
+            game.board.reset(hexCount);
+            for (int word = 0; word < BOARD_WORDS; word++)
+                game.board.cells[word] = getLittle(payload + 16 + 8 * word, 8);
+            haveSnapshot = true;
+        }
+        else if (type == JOURNAL_RECORD_NUMBER && length == 1 && haveSnapshot)
+        {
+            game.selectedNumber = payload[0];
+        }
+        else if (type == JOURNAL_RECORD_ROLLS && length > 0 && length % 4 == 0 && haveSnapshot)
+        {
+            for (size_t i = 0; i < length; i += 4)
+            {
+                RollEntry entry = RollEntry::unpack((uint32_t)getLittle(payload + i, 4));
+                rolls.record(entry);
+                game.selectedNumber = entry.number;
+            }
+        }
+        else
+        {
+            break;
+        }
+        offset += recordBytes;
+        if (haveSnapshot)
+            committed = offset;
+    }
+    return committed;
+}
+
+/**
+ * Replay the newest valid journal
+ * Files are read into one heap buffer, only used at boot
+ */
+bool GameJournal::load(SavedGame &game, RollHistory &rolls)
+{
+    uint8_t *data = new uint8_t[JOURNAL_MAX_BYTES];
+    RollHistory candidateRolls;
+    activeFile = -1;
+    for (int file = 0; file < JOURNAL_FILES; file++)
+    {
+        size_t size = storage.read(file, data, JOURNAL_MAX_BYTES);
+        SavedGame candidate = game;
+        uint32_t fileGeneration = 0;
+        size_t valid = replay(data, size, candidate, candidateRolls, fileGeneration);
+        if (valid == 0 || (activeFile >= 0 && (int32_t)(fileGeneration - generation) <= 0))
+            continue;
+
+        game = candidate;
+        rolls = candidateRolls;
+        activeFile = file;
+        generation = fileGeneration;
+        activeBytes = valid;
+        tornTail = valid < size;
+    }
+    delete[] data;
+    return activeFile >= 0;
+}
+
+/**
+ * Start a new journal from the whole game and its rolls (compaction)
+ * The file is built in one buffer and written at once; its snapshot
+ * record comes last, so a file cut short is never taken for a game.
+ * The new file is complete before the old one is removed.
+ */
+bool GameJournal::saveSnapshot(const SavedGame &game, const RollHistory &history)
+{
+    uint8_t *file = new uint8_t[COMPACTED_MAX_BYTES];
+    size_t length = 0;
+    uint8_t payload[JOURNAL_MAX_RECORD];
+
+    history.encodeStats(payload);
+    length += frame(JOURNAL_RECORD_STATS, payload, ROLL_STATS_BYTES, file + length);
+    for (int i = 0; i < history.size(); i += JOURNAL_ROLLS_PER_RECORD)
+    {
+        int count = history.size() - i < JOURNAL_ROLLS_PER_RECORD ? history.size() - i : JOURNAL_ROLLS_PER_RECORD;
+        for (int j = 0; j < count; j++)
+            putLittle(payload + 4 * j, history.entry(i + j).pack(), 4);
+        length += frame(JOURNAL_RECORD_HISTORY, payload, 4 * count, file + length);
+    }
+
+    uint8_t flags = (game.config.isExtension ? 0x01 : 0) | (game.config.eightSixCanTouch ? 0x02 : 0) |
+                    (game.config.twoTwelveCanTouch ? 0x04 : 0) | (game.config.sameNumbersCanTouch ? 0x08 : 0) |
+                    (game.config.sameResourceCanTouch ? 0x10 : 0) | (game.manualDice ? 0x20 : 0) |
+                    (game.gameStarted ? 0x40 : 0);
+    putLittle(payload, generation + 1, 4);
+    payload[4] = flags;
+    payload[5] = game.config.minBalance;
+    payload[6] = game.selectedNumber;
+    putLittle(payload + 7, game.board.seed, 8);
+    payload[15] = (uint8_t)game.board.size();
+    for (int word = 0; word < BOARD_WORDS; word++)
+        putLittle(payload + 16 + 8 * word, game.board.cells[word], 8);
+    length += frame(JOURNAL_RECORD_SNAPSHOT, payload, SNAPSHOT_PAYLOAD_BYTES, file + length);
+
+    int target = activeFile < 0 ? 0 : (activeFile + 1) % JOURNAL_FILES;
+    bool written = storage.create(target, file, length);
+    delete[] file;
+    if (!written)
+        return false;
+
+    if (activeFile >= 0)
+        storage.remove(activeFile);
+    activeFile = target;
+    generation++;
+    activeBytes = length;
+    tornTail = false;
+    compactionCount++;
+    return true;
+}
+
+/**
+ * Append a record if the active file has room for it
+ */
+bool GameJournal::appendRecord(const uint8_t *record, size_t length)
+{
+    if (activeFile < 0 || tornTail || activeBytes + length > JOURNAL_COMPACT_BYTES)
+        return false;
+
+    if (!storage.append(activeFile, record, length))
+    {
+        // Part of the record may have landed; the next save starts a new journal
+        tornTail = true;
+        return false;
+    }
+    activeBytes += length;
+    return true;
+}
+
+/**
+ * Record new rolls
+ * A compaction takes them from the history, where they are already
+ */
+bool GameJournal::saveRolls(const SavedGame &game, const RollHistory &history, const RollEntry *entries, int count)
+{
+    uint8_t payload[4 * JOURNAL_ROLLS_PER_RECORD];
+    uint8_t record[JOURNAL_MAX_RECORD];
+    bool appended = activeFile >= 0 && !tornTail;
+    for (int i = 0; i < count; i += JOURNAL_ROLLS_PER_RECORD)
+    {
+        int chunk = count - i < JOURNAL_ROLLS_PER_RECORD ? count - i : JOURNAL_ROLLS_PER_RECORD;
+        for (int j = 0; j < chunk; j++)
+            putLittle(payload + 4 * j, entries[i + j].pack(), 4);
+        if (appended)
+            appended = appendRecord(record, frame(JOURNAL_RECORD_ROLLS, payload, 4 * chunk, record));
+    }
+    return appended || saveSnapshot(game, history);
+}
+
+/**
+ * Record a new selected number
+ */
+bool GameJournal::saveNumber(const SavedGame &game, const RollHistory &history)
+{
+    uint8_t record[JOURNAL_MAX_RECORD];
+    size_t length = frame(JOURNAL_RECORD_NUMBER, &game.selectedNumber, 1, record);
+    return appendRecord(record, length) || saveSnapshot(game, history);
+}
+
+/**
+ * Delete every journal file
+ */
+void GameJournal::clear()
+{
+    for (int file = 0; file < JOURNAL_FILES; file++)
+        storage.remove(file);
+    activeFile = -1;
+    activeBytes = 0;
+    tornTail = false;
+}
+
+/**
+ * Bytes in the active journal file
+ */
+size_t GameJournal::size() const
+{
+    return activeFile >= 0 ? activeBytes : 0;
+}
+
+/**
+ * Number of journals started since boot
+ */
+uint32_t GameJournal::compactions() const
+{
+    return compactionCount;
+}
@@ -0,0 +1,226 @@
+/**
+ * GameJournal.h
+ *
+ * This header defines the GameJournal class which persists the game in
+ * progress as an append-only binary journal, so a dice roll costs a few
+ * bytes of flash instead of rewriting the whole game state.
+ *
+ * A journal file starts with the game as a whole: the roll statistics,
+ * the rolls kept by RollHistory and last a snapshot record (board, rules,
+ * game flags), which commits the file. One small record follows per roll,
+ * or per number selected outside a game. Every record is
+ *
+ *   type (1 byte) | payload length (1 byte) | payload | CRC-32 (4 bytes)
+ *
+ * with the CRC over type, length and payload. Replay stops at the first
+ * record that is cut short or fails its CRC, so a write torn by a power
+ * loss only loses that one record.
+ *
+ * Two journal files take turns: once the active one reaches
+ * JOURNAL_COMPACT_BYTES (or a torn tail was found at load), the game with
+ * the next generation number is written to the other file and only then
+ * is the old file removed. At load the valid snapshot with the highest
+ * generation wins, so an interrupted compaction, whose snapshot record
+ * never landed, falls back to the old file.
+ *
+ * The files are reached through JournalStorage, implemented on SPIFFS by
+ * the firmware and on a simulated flash by the host tool in src/journal.
+ */
+
+#ifndef GAMEJOURNAL_H
+#define GAMEJOURNAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "BoardGenerator.h"
+#include "RollHistory.h"
+
+#define JOURNAL_COMPACT_BYTES 4096  // Journal size that triggers a compaction
+#define JOURNAL_MAX_RECORD 64       // Largest record, framing included
+#define JOURNAL_MAX_BYTES (JOURNAL_COMPACT_BYTES + JOURNAL_MAX_RECORD) // Largest journal file
+#define JOURNAL_FILES 2             // Journal files taking turns
+#define JOURNAL_ROLLS_PER_RECORD 14 // Packed rolls in one record
+
+#define JOURNAL_RECORD_SNAPSHOT 'S' // Whole game: generation, rules, flags, board
+#define JOURNAL_RECORD_NUMBER 'N'   // Number selected outside a game
+#define JOURNAL_RECORD_ROLLS 'R'    // New rolls, counted by the statistics
+#define JOURNAL_RECORD_STATS 'T'    // Roll statistics of the whole game
+#define JOURNAL_RECORD_HISTORY 'H'  // Rolls carried over by a compaction, already in the statistics
+
+/**
+ * SavedGame structure
+ *
+ * Everything the journal keeps about the game in progress
+ */
+struct SavedGame
+{
+    Board board;            // Board in play, with its seed
+    BoardConfig config;     // Board size and generation rules
+    bool manualDice;        // Whether numbers are picked by hand
+    bool gameStarted;       // Whether a game is in progress
+    uint8_t selectedNumber; // Last rolled or selected number, 0 for none
+};
+
+/**
+ * JournalStorage class
+ *
+ * Files holding the journal, numbered 0 to JOURNAL_FILES - 1
+ */
+class JournalStorage
+{
+public:
+    virtual ~JournalStorage() = default;
+
+    /**
+     * Read a whole file
+     *
+     * @param file File number
+     * @param buffer Output buffer
+     * @param size Size of the output buffer
+     * @return Bytes read, 0 if the file does not exist
+     */
+    virtual size_t read(int file, uint8_t *buffer, size_t size) = 0;
+
+    /**
+     * Append to a file
+     *
+     * @return True if every byte was written
+     */
+    virtual bool append(int file, const uint8_t *data, size_t length) = 0;
+
+    /**
+     * Replace a file with new contents
+     *
+     * @return True if every byte was written
+     */
+    virtual bool create(int file, const uint8_t *data, size_t length) = 0;
+
+    /**
+     * Delete a file, if it exists
+     */
+    virtual void remove(int file) = 0;
+};
+
+/**
+ * GameJournal class
+ *
+ * Append-only journal of the game in progress
+ */
+class GameJournal
+{
+public:
+    /**
+     * Constructor
+     *
+     * @param storage Files holding the journal
+     */
+    explicit GameJournal(JournalStorage &storage);
+
+    /**
+     * Replay the newest valid journal
+     *
+     * @param game Output game, only written if a journal was found
+     * @param rolls Output rolls of the game, only written if a journal was found
+     * @return True if a valid snapshot was found
+     */
+    bool load(SavedGame &game, RollHistory &rolls);
+
+    /**
+     * Start a new journal from the whole game and its rolls (compaction)
+     * The journal keeps no rolls of its own: the statistics and rolls
+     * written are those of the history passed in
+     *
+     * @param game Game to save
+     * @param history Rolls of the game, not changed during the call
+     * @return True if the new journal was written
+     */
+    bool saveSnapshot(const SavedGame &game, const RollHistory &history);
+
+    /**
+     * Record new rolls
+     * Starts a new journal instead when there is none yet, the active one
+     * is full, or its tail was torn
+     *
+     * @param game Game to save, its selectedNumber being the last roll
+     * @param history Rolls of the game, the new ones already recorded last
+     * @param entries New rolls, oldest first
+     * @param count Number of rolls
+     * @return True if the rolls were written
+     */
+    bool saveRolls(const SavedGame &game, const RollHistory &history, const RollEntry *entries, int count);
+
+    /**
+     * Record a new selected number
+     * Starts a new journal instead when there is none yet, the active one
+     * is full, or its tail was torn
+     *
+     * @param game Game to save, its selectedNumber being the change
+     * @param history Rolls of the game, for a new journal
+     * @return True if the record was written
+     */
+    bool saveNumber(const SavedGame &game, const RollHistory &history);
+
+    /**
+     * Delete every journal file
+     */
+    void clear();
+
+    /**
+     * Bytes in the active journal file
+     */
+    size_t size() const;
+
+    /**
+     * Number of journals started since boot
+     */
+    uint32_t compactions() const;
+
+private:
+    JournalStorage &storage;
+    int activeFile;        // File being appended to, -1 for none
+    uint32_t generation;   // Generation of the active file's snapshot
+    size_t activeBytes;    // Valid bytes in the active file
+    bool tornTail;         // Active file has bytes after its last valid record
+    uint32_t compactionCount;
+
+    /**
+     * Frame a record: type, length, payload and CRC
+     *
+     * @param type Record type
+     * @param payload Record payload
+     * @param length Payload length
+     * @param record Output buffer, JOURNAL_MAX_RECORD bytes
+     * @return Length of the framed record
+     */
+    static size_t frame(uint8_t type, const uint8_t *payload, size_t length, uint8_t *record);
+
+    /**
+     * Append a record if the active file has room for it
+     *
+     * @return False if the record was not written (a compaction is due)
+     */
+    bool appendRecord(const uint8_t *record, size_t length);
+
+    /**
+     * Replay one journal file
+     *
+     * @param data File contents
+     * @param size File size
+     * @param game Output game
+     * @param rolls Output rolls of the game
+     * @param fileGeneration Output generation of the file's snapshot
+     * @return Bytes of valid records, 0 if the file has no valid snapshot
+     */
+    static size_t replay(const uint8_t *data, size_t size, SavedGame &game, RollHistory &rolls, uint32_t &fileGeneration);
+};
+
+/**
+ * CRC-32 (IEEE 802.3) of a buffer
+ *
+ * @param data Bytes to check
+ * @param length Number of bytes
+ * @return CRC-32
+ */
+uint32_t journalCrc32(const uint8_t *data, size_t length);
+
+#endif // GAMEJOURNAL_H
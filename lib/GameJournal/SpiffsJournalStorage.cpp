@@ -0,0 +1,64 @@
+#ifdef ESP_PLATFORM
+
+#include <SPIFFS.h>
+#include "SpiffsJournalStorage.h"
+
+/**
+ * Path of a journal file
+ */
+const char *SpiffsJournalStorage::path(int file)
+{
+    return file == 0 ? "/journal0.bin" : "/journal1.bin";
+}
+
+/**
+ * Read a whole file
+ */
+size_t SpiffsJournalStorage::read(int file, uint8_t *buffer, size_t size)
+{
+    if (!SPIFFS.exists(path(file)))
+        return 0;
+    File handle = SPIFFS.open(path(file), FILE_READ);
+    if (!handle)
+        return 0;
+    size_t length = handle.read(buffer, size);
+    handle.close();
+    return length;
+}
+
+/**
+ * Append to a file
+ */
+bool SpiffsJournalStorage::append(int file, const uint8_t *data, size_t length)
+{
+    File handle = SPIFFS.open(path(file), FILE_APPEND);
+    if (!handle)
+        return false;
+    size_t written = handle.write(data, length);
+    handle.close();
+    return written == length;
+}
+
+/**
+ * Replace a file with new contents
+ */
+bool SpiffsJournalStorage::create(int file, const uint8_t *data, size_t length)
+{
+    File handle = SPIFFS.open(path(file), FILE_WRITE);
+    if (!handle)
+        return false;
+    size_t written = handle.write(data, length);
+    handle.close();
+    return written == length;
+}
+
+/**
+ * Delete a file, if it exists
+ */
+void SpiffsJournalStorage::remove(int file)
+{
+    if (SPIFFS.exists(path(file)))
+        SPIFFS.remove(path(file));
+}
+
+#endif // ESP_PLATFORM
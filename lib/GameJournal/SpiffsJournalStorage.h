@@ -0,0 +1,38 @@
+/**
+ * SpiffsJournalStorage.h
+ *
+ * Journal files of GameJournal kept on the ESP32's SPIFFS partition
+ * (/journal0.bin and /journal1.bin). Only built for the ESP32; the host
+ * tool in src/journal uses a simulated flash instead.
+ */
+
+#ifndef SPIFFSJOURNALSTORAGE_H
+#define SPIFFSJOURNALSTORAGE_H
+
+#ifdef ESP_PLATFORM
+
+#include "GameJournal.h"
+
+/**
+ * SpiffsJournalStorage class
+ *
+ * JournalStorage on SPIFFS files
+ */
+class SpiffsJournalStorage : public JournalStorage
+{
+public:
+    size_t read(int file, uint8_t *buffer, size_t size) override;
+    bool append(int file, const uint8_t *data, size_t length) override;
+    bool create(int file, const uint8_t *data, size_t length) override;
+    void remove(int file) override;
+
+private:
+    /**
+     * Path of a journal file
+     */
+    static const char *path(int file);
+};
+
+#endif // ESP_PLATFORM
+
+#endif // SPIFFSJOURNALSTORAGE_H
@@ -0,0 +1,256 @@
+#include "GameSaver.h"
+
+/**
+ * Constructor
+ * The save task and its locks are only created by begin()
+ */
+GameSaver::GameSaver(GameJournal &journal, RollHistory &history)
+    : journal(journal), lock(NULL), flushed(NULL), saveHandle(NULL), history(history), coalesceMs(0), maxDelayMs(0),
+      pending(0), pendingRollCount(0), writing(false), flushRequested(false), firstChangeMs(0), lastChangeMs(0),
+      changeCount(0), writeCount(0), failureCount(0), writeUs(0)
+{
+}
+
+/**
+ * Start the save task
+ */
+void GameSaver::begin(uint32_t coalesceMs, uint32_t maxDelayMs)
+{
+    if (saveHandle != NULL)
+        return;
+
+    this->maxDelayMs = maxDelayMs;
+    this->coalesceMs = coalesceMs < maxDelayMs ? coalesceMs : maxDelayMs;
+    lock = xSemaphoreCreateMutex();
+    flushed = xSemaphoreCreateBinary();
+
+    // Create the save task on core 0 at idle priority
+    xTaskCreatePinnedToCore(
+        saveTask,                 // Task function
+        "GameSaverTask",          // Name of task
+        GAME_SAVER_STACK_SIZE,    // Stack size (bytes)
+        (void *)this,             // Parameters
+        GAME_SAVER_TASK_PRIORITY, // Priority
+        &saveHandle,              // Task handle
+        GAME_SAVER_TASK_CORE      // Core where the task should run
+    );
+}
+
+/**
+ * Queue a change of the game for writing
+ * Ending the game drops every change and roll queued before it. A
+ * snapshot writes the whole history, so queued rolls are not needed.
+ */
+void GameSaver::markDirty(const SavedGame &game, uint8_t kind)
+{
+    if (lock == NULL)
+        return;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    uint32_t now = millis();
+    if (pending == 0)
+        firstChangeMs = now;
+    lastChangeMs = now;
+    if (kind & GAME_SAVE_CLEAR)
+        pending = kind;
+    else
+        pending |= kind;
+    if (kind & (GAME_SAVE_CLEAR | GAME_SAVE_SNAPSHOT))
+    {
+        pending &= ~GAME_SAVE_ROLLS;
+        pendingRollCount = 0;
+    }
+    if ((kind & GAME_SAVE_CLEAR) && (kind & GAME_SAVE_SNAPSHOT))
+        history.clear();
+    pendingGame = game;
+    xSemaphoreGive(lock);
+
+    changeCount++;
+    xTaskNotifyGive(saveHandle);
+}
+
+/**
+ * Record a roll of the game in progress and queue it for writing
+ * Once a snapshot is due the roll only joins the history, which the
+ * snapshot writes as a whole
+ */
+void GameSaver::markRoll(const SavedGame &game, const RollEntry &entry)
+{
+    if (lock == NULL)
+        return;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    uint32_t now = millis();
+    if (pending == 0)
+        firstChangeMs = now;
+    lastChangeMs = now;
+    history.record(entry);
+    if (!(pending & GAME_SAVE_SNAPSHOT) && pendingRollCount >= GAME_SAVER_MAX_ROLLS)
+    {
+        // The save task fell behind: write the whole history instead
+        pending = (pending & ~GAME_SAVE_ROLLS) | GAME_SAVE_SNAPSHOT;
+        pendingRollCount = 0;
+    }
+    if (!(pending & GAME_SAVE_SNAPSHOT))
+    {
+        pending |= GAME_SAVE_ROLLS;
+        pendingRolls[pendingRollCount++] = entry;
+    }
+    pendingGame = game;
+    xSemaphoreGive(lock);
+
+    changeCount++;
+    xTaskNotifyGive(saveHandle);
+}
+
+/**
+ * Write every queued change now and wait for it
+ */
+bool GameSaver::flush(uint32_t timeoutMs)
+{
+    if (lock == NULL)
+        return true;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    bool idle = pending == 0 && !writing;
+    if (!idle)
+    {
+        flushRequested = true;
+        // Forget a flush signal nobody waited for
+        xSemaphoreTake(flushed, 0);
+    }
+    xSemaphoreGive(lock);
+
+    if (idle)
+        return true;
+    xTaskNotifyGive(saveHandle);
+    return xSemaphoreTake(flushed, pdMS_TO_TICKS(timeoutMs)) == pdTRUE;
+}
+
+/**
+ * Number of changes queued since boot
+ */
+uint32_t GameSaver::changes() const
+{
+    return changeCount;
+}
+
+/**
+ * Number of journal writes since boot
+ */
+uint32_t GameSaver::writes() const
+{
+    return writeCount;
+}
+
+/**
+ * Number of journal writes that failed
+ */
+uint32_t GameSaver::failures() const
+{
+    return failureCount;
+}
+
+/**
+ * Duration of the last journal write, in microseconds
+ */
+uint32_t GameSaver::lastWriteUs() const
+{
+    return writeUs;
+}
+
+/**
+ * Apply queued changes to the journal
+ * A snapshot carries the whole history in the same file write, so a new
+ * game replaces the old journal only once its board and first rolls are
+ * on flash. Otherwise rolls go first; a number selected around them is
+ * written last, as it holds the newest selectedNumber either way.
+ */
+bool GameSaver::write(uint8_t kinds, const SavedGame &game, const RollHistory &rollHistory, const RollEntry *rolls,
+                      int rollCount)
+{
+    if (kinds & GAME_SAVE_SNAPSHOT)
+        return journal.saveSnapshot(game, rollHistory);
+
+    bool ok = true;
+    if (kinds & GAME_SAVE_CLEAR)
+        journal.clear();
+    if (rollCount > 0)
+        ok = journal.saveRolls(game, rollHistory, rolls, rollCount);
+    if (kinds & GAME_SAVE_NUMBER)
+        ok = journal.saveNumber(game, rollHistory) && ok;
+    return ok;
+}
+
+/**
+ * Static save task function
+ *
+ * Sleeps until a change arrives, then until the change is due: the
+ * coalescing window after the newest change, capped by the durability
+ * bound after the oldest one. A flush, or a full record of rolls, makes
+ * it due at once. The game and the history are copied out under the
+ * lock and written outside it, so handlers never wait for the flash.
+ * The history copy lives on the heap for the length of the write only.
+ */
+void GameSaver::saveTask(void *parameter)
+{
+    GameSaver *saver = (GameSaver *)parameter;
+
+    while (true)
+    {
+        xSemaphoreTake(saver->lock, portMAX_DELAY);
+        uint8_t kinds = saver->pending;
+        bool urgent = saver->flushRequested || saver->pendingRollCount >= JOURNAL_ROLLS_PER_RECORD;
+        uint32_t settledAt = saver->lastChangeMs + saver->coalesceMs;
+        uint32_t boundAt = saver->firstChangeMs + saver->maxDelayMs;
+        xSemaphoreGive(saver->lock);
+
+        if (kinds == 0)
+        {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+
+        uint32_t dueAt = (int32_t)(settledAt - boundAt) < 0 ? settledAt : boundAt;
+        int32_t wait = (int32_t)(dueAt - millis());
+        if (!urgent && wait > 0)
+        {
+            // A new change or a flush wakes the task to look again
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait));
+            continue;
+        }
+
+        SavedGame game;
+        RollEntry rolls[GAME_SAVER_MAX_ROLLS];
+        xSemaphoreTake(saver->lock, portMAX_DELAY);
+        kinds = saver->pending;
+        game = saver->pendingGame;
+        RollHistory *rollHistory = new RollHistory(saver->history);
+        int rollCount = saver->pendingRollCount;
+        memcpy(rolls, saver->pendingRolls, rollCount * sizeof(RollEntry));
+        saver->pending = 0;
+        saver->pendingRollCount = 0;
+        saver->writing = true;
+        xSemaphoreGive(saver->lock);
+
+        unsigned long start = micros();
+        bool ok = saver->write(kinds, game, *rollHistory, rolls, rollCount);
+        saver->writeUs = micros() - start;
+        delete rollHistory;
+        saver->writeCount++;
+        if (!ok)
+        {
+            saver->failureCount++;
+            Serial.println("Failed to write game journal");
+        }
+
+        xSemaphoreTake(saver->lock, portMAX_DELAY);
+        saver->writing = false;
+        if (saver->flushRequested && saver->pending == 0)
+        {
+            saver->flushRequested = false;
+            xSemaphoreGive(saver->flushed);
+        }
+        xSemaphoreGive(saver->lock);
+    }
+}
@@ -0,0 +1,157 @@
+/**
+ * GameSaver.h
+ *
+ * This header defines the GameSaver class which takes flash writes of the
+ * game state off the HTTP path.
+ *
+ * It handles:
+ * - Dirty notifications from the handlers, which only copy the game and return
+ * - The roll history of the game, recorded under the same lock as the queue
+ *   so the save task writes the very history the handlers read
+ * - Coalescing a burst of changes (rapid number taps) into one journal write,
+ *   which keeps every roll of the burst
+ * - A low-priority FreeRTOS task doing every GameJournal write
+ * - A bound on how long a change may wait, i.e. what a power loss can undo
+ * - Flushing on demand, for changes that must be on flash before replying
+ *
+ * A change is written once no other change followed it for the coalescing
+ * window, and at the latest the durability bound after the oldest change
+ * not yet written. Only the newest game of a burst reaches the journal.
+ */
+
+#ifndef GAMESAVER_H
+#define GAMESAVER_H
+
+#include <Arduino.h>
+#include "GameJournal.h"
+
+#define GAME_SAVER_STACK_SIZE 4096 // Stack size for the save task (journal writes need a few hundred bytes)
+#define GAME_SAVER_TASK_PRIORITY 0 // Idle priority, below the loop task
+#define GAME_SAVER_TASK_CORE 0     // Core to run the save task on (the board pool refills on core 1)
+
+#define GAME_SAVER_MAX_ROLLS 32 // Rolls waiting for the save task (more start a new journal instead)
+
+#define GAME_SAVE_NUMBER 1   // Number selected outside a game (one journal record)
+#define GAME_SAVE_SNAPSHOT 2 // Board, rules or game flags changed (new journal)
+#define GAME_SAVE_CLEAR 4    // Game ended (journal deleted); with GAME_SAVE_SNAPSHOT, a new game
+#define GAME_SAVE_ROLLS 8    // Rolls queued by markRoll()
+
+/**
+ * GameSaver class
+ *
+ * Deferred, coalesced writer of the game journal
+ */
+class GameSaver
+{
+public:
+    /**
+     * Constructor
+     *
+     * @param journal Journal written by the save task
+     * @param history Rolls of the game, only changed through markRoll() and markDirty()
+     */
+    GameSaver(GameJournal &journal, RollHistory &history);
+
+    /**
+     * Start the save task
+     *
+     * @param coalesceMs Quiet time after a change before it is written
+     * @param maxDelayMs Longest time a change may wait for its write
+     *        (the coalescing window is capped to it)
+     */
+    void begin(uint32_t coalesceMs, uint32_t maxDelayMs);
+
+    /**
+     * Queue a change of the game for writing
+     * A new game (GAME_SAVE_CLEAR | GAME_SAVE_SNAPSHOT) also clears the history
+     *
+     * @param game Game as it is now
+     * @param kind GAME_SAVE_NUMBER, GAME_SAVE_SNAPSHOT and/or GAME_SAVE_CLEAR
+     */
+    void markDirty(const SavedGame &game, uint8_t kind);
+
+    /**
+     * Record a roll of the game in progress and queue it for writing
+     * The roll joins the history at once. Past a full queue the next
+     * write starts a new journal from the history, so no roll is lost.
+     *
+     * @param game Game as it is now, its selectedNumber being the roll
+     * @param entry The roll
+     */
+    void markRoll(const SavedGame &game, const RollEntry &entry);
+
+    /**
+     * Write every queued change now and wait for it
+     *
+     * @param timeoutMs Longest wait for the save task
+     * @return True once nothing is left to write, false on timeout
+     */
+    bool flush(uint32_t timeoutMs);
+
+    /**
+     * Number of changes queued since boot
+     */
+    uint32_t changes() const;
+
+    /**
+     * Number of journal writes since boot
+     */
+    uint32_t writes() const;
+
+    /**
+     * Number of journal writes that failed
+     */
+    uint32_t failures() const;
+
+    /**
+     * Duration of the last journal write, in microseconds
+     */
+    uint32_t lastWriteUs() const;
+
+private:
+    GameJournal &journal;
+    SemaphoreHandle_t lock;    // Guards every member below, except the counters
+    SemaphoreHandle_t flushed; // Given by the save task once a flush is done
+    TaskHandle_t saveHandle;   // Handle to the FreeRTOS save task
+    RollHistory &history;      // Rolls of the game, changed only by the handlers (the loop task)
+
+    uint32_t coalesceMs; // Quiet time before a write
+    uint32_t maxDelayMs; // Durability bound
+
+    SavedGame pendingGame;                        // Newest game not written yet
+    uint8_t pending;                              // GAME_SAVE_* bits not written yet
+    RollEntry pendingRolls[GAME_SAVER_MAX_ROLLS]; // Rolls not written yet, oldest first (none if a snapshot is due)
+    uint8_t pendingRollCount;                     // Rolls in pendingRolls
+    bool writing;                                 // Save task is writing a game taken from pending
+    bool flushRequested;                          // A caller waits in flush()
+    uint32_t firstChangeMs;                       // millis() of the oldest change not written yet
+    uint32_t lastChangeMs;                        // millis() of the newest change
+
+    volatile uint32_t changeCount;  // Changes queued
+    volatile uint32_t writeCount;   // Journal writes
+    volatile uint32_t failureCount; // Journal writes that failed
+    volatile uint32_t writeUs;      // Duration of the last write
+
+    /**
+     * Apply queued changes to the journal
+     *
+     * @param kinds GAME_SAVE_* bits to apply
+     * @param game Newest game
+     * @param rollHistory History as of the newest game
+     * @param rolls Rolls to append, oldest first
+     * @param rollCount Number of rolls
+     * @return True if every write succeeded
+     */
+    bool write(uint8_t kinds, const SavedGame &game, const RollHistory &rollHistory, const RollEntry *rolls,
+               int rollCount);
+
+    /**
+     * Static save task function
+     * Waits for changes, lets bursts settle, then writes
+     *
+     * @param parameter Pointer to the GameSaver instance
+     */
+    static void saveTask(void *parameter);
+};
+
+#endif // GAMESAVER_H
@@ -0,0 +1,174 @@
+#include "GameStateJson.h"
+#include "BoardMap.h"
+
+/**
+ * JsonWriter structure
+ *
+ * Appends JSON text to a fixed buffer. Text that does not fit is
+ * dropped but still counted, so length ends as the full document length.
+ */
+struct JsonWriter
+{
+    char *buffer;  // Output buffer
+    size_t size;   // Size of the output buffer
+    size_t length; // Characters written so far, including dropped ones
+
+    /**
+     * Append one character
+     */
+    void put(char c)
+    {
+        if (length + 1 < size)
+            buffer[length] = c;
+        length++;
+    }
+
+    /**
+     * Append a string as is (no escaping, only used for keys and literals)
+     */
+    void text(const char *value)
+    {
+        while (*value != '\0')
+            put(*value++);
+    }
+
+    /**
+     * Append an integer
+     */
+    void number(long value)
+    {
+        char digits[12];
+        int count = 0;
+        unsigned long magnitude = value < 0 ? 0UL - (unsigned long)value : (unsigned long)value;
+        if (value < 0)
+            put('-');
+        do
+        {
+            digits[count++] = '0' + magnitude % 10;
+            magnitude /= 10;
+        } while (magnitude != 0);
+        while (count > 0)
+            put(digits[--count]);
+    }
+
+    /**
+     * Append true or false
+     */
+    void boolean(bool value)
+    {
+        text(value ? "true" : "false");
+    }
+
+    /**
+     * Start a member: separator (except for the first one), quoted key and colon
+     */
+    void key(const char *name)
+    {
+        if (length > 1)
+            put(',');
+        put('"');
+        text(name);
+        text("\":");
+    }
+
+    /**
+     * Null-terminate the buffer, cutting the text if it did not fit
+     */
+    void finish()
+    {
+        if (size > 0)
+            buffer[length < size ? length : size - 1] = '\0';
+    }
+};
+
+/**
+ * Encode the game state as JSON
+ *
+ * @param state Game state to encode
+ * @param buffer Output buffer, always null-terminated if size > 0
+ * @param size Size of the output buffer
+ * @return Length of the whole document (more than size - 1 if it was cut)
+ */
+size_t writeGameStateJson(const GameState &state, char *buffer, size_t size)
+{
+    const Board &board = *state.board;
+    const BoardConfig &config = *state.config;
+    int hexCount = board.size(); // An empty board sends empty arrays
+    JsonWriter json = {buffer, size, 0};
+
+    json.put('{');
+
+    json.key("resources");
+    json.put('[');
+    for (int i = 0; i < hexCount; i++)
+    {
+        if (i > 0)
+            json.put(',');
+        json.number(board.resource(i));
+    }
+    json.put(']');
+
+    json.key("numbers");
+    json.put('[');
+    for (int i = 0; i < hexCount; i++)
+    {
+        if (i > 0)
+            json.put(',');
+        json.number(board.number(i));
+    }
+    json.put(']');
+
+    json.key("extension");
+    json.boolean(config.isExtension);
+    json.key("gameStarted");
+    json.boolean(state.gameStarted);
+
+    // A loaded map tells the web page how to draw its rows
+    const BoardMap *map = loadedBoardMap(config.isExtension);
+    if (map != nullptr)
+    {
+        json.key("rows");
+        json.put('[');
+        for (int row = 0; row < map->rowCount; row++)
+        {
+            if (row > 0)
+                json.put(',');
+            json.number(map->rows[row]);
+        }
+        json.put(']');
+    }
+
+    json.key("eightSixCanTouch");
+    json.boolean(config.eightSixCanTouch);
+    json.key("twoTwelveCanTouch");
+    json.boolean(config.twoTwelveCanTouch);
+    json.key("sameNumbersCanTouch");
+    json.boolean(config.sameNumbersCanTouch);
+    json.key("sameResourceCanTouch");
+    json.boolean(config.sameResourceCanTouch);
+    json.key("minBalance");
+    json.number(config.minBalance);
+    json.key("manualDice");
+    json.boolean(state.manualDice);
+
+    if (!board.empty())
+    {
+        json.key("balance");
+        json.number(state.balance);
+    }
+
+    json.key("selectedNumber");
+    json.number(state.selectedNumber);
+
+    // 64-bit seeds do not fit JavaScript numbers, so they travel as 16 hex digits
+    static const char hexDigits[] = "0123456789abcdef";
+    json.key("seed");
+    json.put('"');
+    for (int shift = 60; shift >= 0; shift -= 4)
+        json.put(hexDigits[(board.seed >> shift) & 0xF]);
+    json.put('"');
+
+    json.put('}');
+    json.finish();
+    return json.length;
+}
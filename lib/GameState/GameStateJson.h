@@ -0,0 +1,53 @@
+/**
+ * GameStateJson.h
+ *
+ * This header defines the JSON encoder for the game state, the document
+ * returned by /getboard and pushed over /events.
+ *
+ * The document is written field by field straight into a caller-supplied
+ * buffer, with no JsonDocument and no String in between, so building it
+ * never touches the heap. Like snprintf, the encoder always returns the
+ * full length of the document; callers pass a GAME_STATE_JSON_SIZE buffer
+ * and send exactly that many bytes with a known Content-Length.
+ */
+
+#ifndef GAMESTATEJSON_H
+#define GAMESTATEJSON_H
+
+#include <stddef.h>
+#include "BoardGenerator.h"
+
+#define GAME_STATE_JSON_SIZE 768 // Buffer large enough for the largest game state
+
+/**
+ * GameState structure
+ *
+ * Everything the game state document describes
+ */
+struct GameState
+{
+    const Board *board;        // Current board
+    const BoardConfig *config; // Board size and generation rules
+    bool gameStarted;          // Whether a game is in progress
+    bool manualDice;           // Whether numbers are picked by hand
+    int selectedNumber;        // Last rolled or selected number, 0 for none
+    int balance;               // Balance score of the board (see BoardIndex)
+};
+
+/**
+ * Encode the game state as JSON
+ *
+ * Fields, in order: resources and numbers (one entry per hex, empty
+ * without a board), extension, gameStarted, rows (only with a loaded map),
+ * eightSixCanTouch, twoTwelveCanTouch, sameNumbersCanTouch,
+ * sameResourceCanTouch, minBalance, manualDice, balance (only with a
+ * board), selectedNumber, seed.
+ *
+ * @param state Game state to encode
+ * @param buffer Output buffer, always null-terminated if size > 0
+ * @param size Size of the output buffer
+ * @return Length of the whole document (more than size - 1 if it was cut)
+ */
+size_t writeGameStateJson(const GameState &state, char *buffer, size_t size);
+
+#endif // GAMESTATEJSON_H
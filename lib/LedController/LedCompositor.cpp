@@ -0,0 +1,123 @@
+#include <string.h>
+#include "LedCompositor.h"
+
+/**
+ * Constructor - empty strip
+ */
+LedCompositor::LedCompositor() : shownCount(0), skippedCount(0)
+{
+    resize(0);
+}
+
+/**
+ * Set the strip length and clear every layer
+ * A new strip starts dark whatever the LEDs show, so the next frame is
+ * sent whole
+ */
+void LedCompositor::resize(uint16_t count)
+{
+    pixelCount = count < LED_FRAME_MAX_PIXELS ? count : LED_FRAME_MAX_PIXELS;
+    for (uint8_t layer = 0; layer < LED_LAYERS; layer++)
+        clear(layer);
+    frontValid = false;
+    dirty = true;
+}
+
+/**
+ * Set a pixel of a layer
+ */
+void LedCompositor::setPixel(uint8_t layer, uint16_t pixel, uint32_t color)
+{
+    if (layer >= LED_LAYERS || pixel >= pixelCount)
+        return;
+
+    uint32_t bit = 1u << (pixel % 32);
+    uint32_t &mask = opaque[layer][pixel / 32];
+    if ((mask & bit) && layers[layer][pixel] == color)
+        return;
+    mask |= bit;
+    layers[layer][pixel] = color;
+    dirty = true;
+}
+
+/**
+ * Set every pixel of a layer
+ */
+void LedCompositor::fill(uint8_t layer, uint32_t color)
+{
+    for (uint16_t pixel = 0; pixel < pixelCount; pixel++)
+        setPixel(layer, pixel, color);
+}
+
+/**
+ * Make a layer transparent again
+ */
+void LedCompositor::clear(uint8_t layer)
+{
+    if (layer >= LED_LAYERS)
+        return;
+    memset(opaque[layer], 0, sizeof(opaque[layer]));
+    dirty = true;
+}
+
+/**
+ * Composite the layers and send the frame if it changed
+ * Only pixels that differ from the LEDs are copied into the strip, and
+ * show() runs at most once
+ */
+bool LedCompositor::present(Adafruit_NeoPixel &strip)
+{
+    if (!dirty && frontValid)
+    {
+        skippedCount++;
+        return false;
+    }
+    dirty = false;
+
+    bool changed = false;
+    for (uint16_t pixel = 0; pixel < pixelCount; pixel++)
+    {
+        uint32_t color = 0;
+        uint32_t bit = 1u << (pixel % 32);
+        for (int layer = LED_LAYERS - 1; layer >= 0; layer--)
+        {
+            if (opaque[layer][pixel / 32] & bit)
+            {
+                color = layers[layer][pixel];
+                break;
+            }
+        }
+        if (!frontValid || front[pixel] != color)
+        {
+            strip.setPixelColor(pixel, color);
+            front[pixel] = color;
+            changed = true;
+        }
+    }
+    frontValid = true;
+
+    if (!changed)
+    {
+        skippedCount++;
+        return false;
+    }
+    strip.show();
+    shownCount++;
+    return true;
+}
+
+/**
+ * Number of frames sent to the strip
+ */
+uint32_t LedCompositor::framesShown() const
+{
+    return shownCount;
+}
+
+/**
+ * Number of presented frames that matched the LEDs and were not sent
+ */
+uint32_t LedCompositor::framesSkipped() const
+{
+    return skippedCount;
+}
@@ -0,0 +1,105 @@
+/**
+ * LedCompositor.h
+ *
+ * This header defines the LedCompositor class which builds the frames shown
+ * on the LED strip.
+ *
+ * It handles:
+ * - One back buffer per layer: the board display written by the web
+ *   handlers, and the animation overlay written by the animation task
+ * - Compositing: each pixel takes the color of the topmost layer that set
+ *   it, an overlay pixel never set lets the board show through
+ * - Sending only complete frames: the strip is updated once per present()
+ *   and only when the frame differs from the one on the LEDs, with only the
+ *   changed pixels copied into the strip's buffer
+ *
+ * The compositor does no locking; LedController serializes every call.
+ */
+
+#ifndef LEDCOMPOSITOR_H
+#define LEDCOMPOSITOR_H
+
+#include <stdint.h>
+#include <Adafruit_NeoPixel.h>
+
+#define LED_FRAME_MAX_PIXELS 256 // Longest strip (a map's LED count is one byte)
+
+#define LED_LAYER_BOARD 0     // Hexes lit for the selected number, written by the loop task
+#define LED_LAYER_ANIMATION 1 // Overlay of the running animation
+#define LED_LAYERS 2          // Number of layers
+
+/**
+ * LedCompositor class
+ *
+ * Layered back buffers and the last frame sent to the strip
+ */
+class LedCompositor
+{
+public:
+    /**
+     * Constructor - empty strip
+     */
+    LedCompositor();
+
+    /**
+     * Set the strip length and clear every layer
+     * The next present() sends the whole frame
+     *
+     * @param count Number of LEDs (at most LED_FRAME_MAX_PIXELS)
+     */
+    void resize(uint16_t count);
+
+    /**
+     * Set a pixel of a layer
+     *
+     * @param layer LED_LAYER_BOARD or LED_LAYER_ANIMATION
+     * @param pixel LED index
+     * @param color 32-bit color value, 0 for off (still covers the layers below)
+     */
+    void setPixel(uint8_t layer, uint16_t pixel, uint32_t color);
+
+    /**
+     * Set every pixel of a layer
+     *
+     * @param layer LED_LAYER_BOARD or LED_LAYER_ANIMATION
+     * @param color 32-bit color value
+     */
+    void fill(uint8_t layer, uint32_t color);
+
+    /**
+     * Make a layer transparent again
+     *
+     * @param layer LED_LAYER_BOARD or LED_LAYER_ANIMATION
+     */
+    void clear(uint8_t layer);
+
+    /**
+     * Composite the layers and send the frame if it changed
+     *
+     * @param strip Strip to send the frame to
+     * @return True if the strip was updated
+     */
+    bool present(Adafruit_NeoPixel &strip);
+
+    /**
+     * Number of frames sent to the strip
+     */
+    uint32_t framesShown() const;
+
+    /**
+     * Number of presented frames that matched the LEDs and were not sent
+     */
+    uint32_t framesSkipped() const;
+
+private:
+    uint16_t pixelCount;                                           // LEDs on the strip
+    uint32_t layers[LED_LAYERS][LED_FRAME_MAX_PIXELS];             // Back buffer of each layer
+    uint32_t opaque[LED_LAYERS][(LED_FRAME_MAX_PIXELS + 31) / 32]; // Pixels set in each layer, one bit each
+    uint32_t front[LED_FRAME_MAX_PIXELS];                          // Frame on the LEDs
+    bool frontValid;                                               // Whether front matches the LEDs
+    bool dirty;                                                    // A layer changed since the last present()
+    uint32_t shownCount;                                           // Frames sent
+    uint32_t skippedCount;                                         // Frames not sent
+};
+
+#endif // LEDCOMPOSITOR_H
@@ -1,7 +1,6 @@
 #include "LedController.h"
 #include <Arduino.h>
 #include "LedIndex.h"
-#include "adjancency.h"
 
 /**
  * Constructor - initialize controller with pin and LED count
@@ -12,7 +11,7 @@
  */
 LedController::LedController(uint8_t pin, uint16_t numLeds, uint8_t brightness)
     : ledPin(pin), ledCount(numLeds), ledBrightness(brightness), strip(nullptr),
-      animationRunning(false), animationTaskHandle(NULL)
+      layout(ledLayoutFor(numLeds)), frameLock(NULL), animationRunning(false), animationTaskHandle(NULL)
 {
 }
 
@@ -34,18 +33,15 @@ LedController::~LedController()
  * Creates the NeoPixel object and sets initial brightness
  *
  * @param numLeds Number of LEDs to initialize (updates ledCount)
+ * @param boardLayout Tables of a loaded map, or nullptr for the built-in board of that LED count
  */
-void LedController::begin(uint16_t numLeds)
+void LedController::begin(uint16_t numLeds, const LedLayout *boardLayout)
 {
-    // Create a new LED strip instance
-    ledCount = numLeds;
-    if (strip != nullptr)
+    if (frameLock == NULL)
     {
-        delete strip;
+        frameLock = xSemaphoreCreateMutex();
     }
-    strip = new Adafruit_NeoPixel(ledCount, ledPin, NEO_GRB + NEO_KHZ800);
-    strip->begin();
-    strip->setBrightness(ledBrightness);
+    restart(numLeds, boardLayout);
 }
 
 /**
@@ -53,11 +49,14 @@ void LedController::begin(uint16_t numLeds)
  * Used when switching between classic and extension board modes
  *
  * @param numLeds New number of LEDs
+ * @param boardLayout Tables of a loaded map, or nullptr for the built-in board of that LED count
  */
-void LedController::restart(uint16_t numLeds)
+void LedController::restart(uint16_t numLeds, const LedLayout *boardLayout)
 {
-    // Update the LED count and reinitialize the strip
+    // Swap the strip and tables under the frame lock, a running animation may be presenting
+    lockFrame();
     ledCount = numLeds;
+    layout = boardLayout != nullptr ? boardLayout : ledLayoutFor(numLeds);
     if (strip != nullptr)
     {
         delete strip;
@@ -65,44 +64,46 @@ void LedController::restart(uint16_t numLeds)
     strip = new Adafruit_NeoPixel(ledCount, ledPin, NEO_GRB + NEO_KHZ800);
     strip->begin();
     strip->setBrightness(ledBrightness);
+    frame.resize(ledCount);
+    unlockFrame();
 }
 
 /**
- * Turn off all LEDs in the strip
+ * Turn off all LEDs of the board layer
  * Sets all pixels to color 0 (off)
  */
 void LedController::turnOffAllLeds()
 {
-    for (uint16_t i = 0; i < ledCount; i++)
-    {
-        strip->setPixelColor(i, 0);
-    }
+    lockFrame();
+    frame.fill(LED_LAYER_BOARD, 0);
+    unlockFrame();
 }
 
 /**
  * Update the LED display
- * Sends color data to the physical LED strip
+ * Sends the composited frame to the physical LED strip if it changed
  */
 void LedController::update()
 {
+    lockFrame();
     if (strip != nullptr)
     {
-        strip->show();
+        frame.present(*strip);
     }
+    unlockFrame();
 }
 
 /**
- * Set a specific LED to a color
+ * Set a specific LED of the board layer to a color
  *
  * @param pixel LED index
  * @param color 32-bit color value
  */
 void LedController::setPixelColor(uint16_t pixel, uint32_t color)
 {
-    if (strip != nullptr)
-    {
-        strip->setPixelColor(pixel, color);
-    }
+    lockFrame();
+    frame.setPixel(LED_LAYER_BOARD, pixel, color);
+    unlockFrame();
 }
 
 /**
@@ -114,30 +115,32 @@ void LedController::setPixelColor(uint16_t pixel, uint32_t color)
  */
 void LedController::turnTileOn(uint16_t tile, uint32_t color)
 {
-    // Map tile index to LED index using the appropriate lookup table
-    int ledIndex = ledCount == 30 ? tileToLedIndexExtension[tile] : tileToLedIndexClassic[tile];
-
-    if (strip != nullptr)
-    {
-        strip->setPixelColor(ledIndex, color);
-    }
+    // Map tile index to LED index using the current board's lookup table
+    lockFrame();
+    frame.setPixel(LED_LAYER_BOARD, layout->tileToLed[tile], color);
+    unlockFrame();
 }
 
 /**
  * Animation for rolling dice
- * Shows a sequence of random colors in a spiral pattern
+ * Shows a sequence of random colors in a spiral pattern on the animation
+ * layer, which stays until the next stopAnimation()
  */
 void LedController::rollDiceAnimation()
 {
-    // Retrieve the LED count
-    uint16_t count = ledCount;
+    // The overlay belongs to this animation now
+    stopAnimation();
+
+    // Retrieve the hex count (a map may leave some LEDs of the strip unused)
+    const LedLayout *tables = currentLayout();
+    uint16_t count = tables->tileCount;
 
     // LED animation: Turn on LEDs sequentially with random colors
     // For each LED, pick an index based on board mode
     for (int i = count - 1; i >= 0; i--)
     {
         // Use the spiral index mapping for the animation
-        int ledIndex = (count == 30 ? spiralLedIndexExtension[i] : spiralLedIndexClassic[i]);
+        int ledIndex = tables->spiral[i];
 
         // Generate a random color
         uint8_t r = random(0, 256);
@@ -145,7 +148,7 @@ void LedController::rollDiceAnimation()
         uint8_t b = random(0, 256);
         uint32_t color = Color(r, g, b);
 
-        setPixelColor(ledIndex, color);
+        drawOverlay(ledIndex, color);
         update();  // Update the strip to show the new color
         delay(50); // Short delay between steps
     }
@@ -161,11 +164,8 @@ void LedController::rollDiceAnimation()
  */
 uint32_t LedController::Color(uint8_t r, uint8_t g, uint8_t b)
 {
-    if (strip != nullptr)
-    {
-        return strip->Color(r, g, b);
-    }
-    return ((uint32_t)r << 16) | ((uint32_t)g << 8) | (uint32_t)b;
+    // Static on the strip class: the animation task must not touch a strip restart() may delete
+    return Adafruit_NeoPixel::Color(r, g, b);
 }
 
 /**
@@ -178,6 +178,86 @@ Adafruit_NeoPixel *LedController::getStrip()
     return strip;
 }
 
+/**
+ * Number of frames sent to the LED strip
+ */
+uint32_t LedController::framesShown()
+{
+    lockFrame();
+    uint32_t count = frame.framesShown();
+    unlockFrame();
+    return count;
+}
+
+/**
+ * Number of frames that matched the LEDs and were not sent
+ */
+uint32_t LedController::framesSkipped()
+{
+    lockFrame();
+    uint32_t count = frame.framesSkipped();
+    unlockFrame();
+    return count;
+}
+
+/**
+ * Take the frame lock (no-op before begin())
+ */
+void LedController::lockFrame()
+{
+    if (frameLock != NULL)
+    {
+        xSemaphoreTake(frameLock, portMAX_DELAY);
+    }
+}
+
+/**
+ * Release the frame lock
+ */
+void LedController::unlockFrame()
+{
+    if (frameLock != NULL)
+    {
+        xSemaphoreGive(frameLock);
+    }
+}
+
+/**
+ * Tables of the current board, read under the frame lock
+ */
+const LedLayout *LedController::currentLayout()
+{
+    lockFrame();
+    const LedLayout *tables = layout;
+    unlockFrame();
+    return tables;
+}
+
+/**
+ * Set a pixel of the animation layer
+ *
+ * @param pixel LED index
+ * @param color 32-bit color value, 0 hides the board under it
+ */
+void LedController::drawOverlay(uint16_t pixel, uint32_t color)
+{
+    lockFrame();
+    frame.setPixel(LED_LAYER_ANIMATION, pixel, color);
+    unlockFrame();
+}
+
+/**
+ * Set every pixel of the animation layer
+ *
+ * @param color 32-bit color value
+ */
+void LedController::fillOverlay(uint32_t color)
+{
+    lockFrame();
+    frame.fill(LED_LAYER_ANIMATION, color);
+    unlockFrame();
+}
+
 // ----- Animation Functions -----
 
 /**
@@ -186,11 +266,11 @@ Adafruit_NeoPixel *LedController::getStrip()
  * Creates a FreeRTOS task to run the animation in the background
  *
  * @param animationId Type of animation to run (WAITING_ANIMATION, START_GAME_ANIMATION, ROBBER_ANIMATION)
- * @param tiles Array of tile indices (for ROBBER_ANIMATION)
+ * @param tiles Array of tile indices (for ROBBER_ANIMATION), copied
  * @param numTiles Number of tiles in the array
  * @param delayMs Delay between animation steps in milliseconds
  */
-void LedController::startAnimation(uint8_t animationId, uint16_t *tiles, uint8_t numTiles, uint32_t delayMs)
+void LedController::startAnimation(uint8_t animationId, const uint8_t *tiles, uint8_t numTiles, uint32_t delayMs)
 {
     // Do not start if an animation is already running
     if (animationRunning)
@@ -203,7 +283,11 @@ void LedController::startAnimation(uint8_t animationId, uint16_t *tiles, uint8_t
     // Prepare parameters for the animation task
     AnimationParams *params = new AnimationParams;
     params->animationId = animationId;
-    params->tiles = tiles;
+    // Copy the tiles, so callers can pass a buffer they keep using
+    if (numTiles > LED_ANIMATION_MAX_TILES)
+        numTiles = LED_ANIMATION_MAX_TILES;
+    if (numTiles > 0)
+        memcpy(params->tiles, tiles, numTiles);
     params->numTiles = numTiles;
     params->delayMs = delayMs;
     params->instance = this;
@@ -235,6 +319,11 @@ void LedController::stopAnimation()
             vTaskDelay(10 / portTICK_PERIOD_MS);
         }
     }
+
+    // Drop what the last animation left over the board (shown at the next update)
+    lockFrame();
+    frame.clear(LED_LAYER_ANIMATION);
+    unlockFrame();
 }
 
 /**
@@ -256,22 +345,25 @@ void LedController::animationTask(void *pvParameters)
         // Waiting animation: Light LEDs white one at a time; then turn them off in reverse order
         while (instance->animationRunning)
         {
+            // Tables for this pass; restart() may switch boards meanwhile
+            const LedLayout *tables = instance->currentLayout();
+
             // Turn on LEDs sequentially
-            for (uint16_t i = 0; i < instance->ledCount && instance->animationRunning; i++)
+            for (uint16_t i = 0; i < tables->tileCount && instance->animationRunning; i++)
             {
                 // Pick the correct LED index using the spiral pattern
-                int ledIndex = instance->ledCount == 30 ? spiralLedIndexExtension[i] : spiralLedIndexClassic[i];
-                instance->strip->setPixelColor(ledIndex, instance->Color(255, 255, 255));
-                instance->strip->show();
+                int ledIndex = tables->spiral[i];
+                instance->drawOverlay(ledIndex, instance->Color(255, 255, 255));
+                instance->update();
                 vTaskDelay(delayMs / portTICK_PERIOD_MS);
             }
 
             // Turn off LEDs sequentially (reverse order)
-            for (int i = instance->ledCount - 1; i >= 0 && instance->animationRunning; i--)
+            for (int i = tables->tileCount - 1; i >= 0 && instance->animationRunning; i--)
             {
-                int ledIndex = instance->ledCount == 30 ? spiralLedIndexExtension[i] : spiralLedIndexClassic[i];
-                instance->strip->setPixelColor(ledIndex, 0);
-                instance->strip->show();
+                int ledIndex = tables->spiral[i];
+                instance->drawOverlay(ledIndex, 0);
+                instance->update();
                 vTaskDelay(delayMs / portTICK_PERIOD_MS);
             }
         }
@@ -282,27 +374,18 @@ void LedController::animationTask(void *pvParameters)
         for (int j = 0; j < 3 && instance->animationRunning; j++)
         {
             // All on
-            for (uint16_t i = 0; i < instance->ledCount; i++)
-            {
-                instance->strip->setPixelColor(i, instance->Color(255, 255, 255));
-            }
-            instance->strip->show();
+            instance->fillOverlay(instance->Color(255, 255, 255));
+            instance->update();
             vTaskDelay(delayMs / portTICK_PERIOD_MS);
 
             // All off
-            for (uint16_t i = 0; i < instance->ledCount; i++)
-            {
-                instance->strip->setPixelColor(i, 0);
-            }
-            instance->strip->show();
+            instance->fillOverlay(0);
+            instance->update();
             vTaskDelay(delayMs / portTICK_PERIOD_MS);
         }
         // Ensure LEDs are off at the end
-        for (uint16_t i = 0; i < instance->ledCount; i++)
-        {
-            instance->strip->setPixelColor(i, 0);
-        }
-        instance->strip->show();
+        instance->fillOverlay(0);
+        instance->update();
         break;
 
     case ROBBER_ANIMATION:
@@ -315,12 +398,11 @@ void LedController::animationTask(void *pvParameters)
         // Robber Animation: requires 1 or 2 tile indices in params->tiles
         if (params->numTiles > 0)
         {
-            // Determine board mode based on ledCount
-            // Classic: 19 LEDs, Extension: 30 LEDs
-            bool isExtension = (instance->ledCount == 30);
-            int tileCount = isExtension ? 30 : 19;
-            const int *tileToLedIndex = isExtension ? tileToLedIndexExtension : tileToLedIndexClassic;
-            const int(*adjacencyList)[6] = isExtension ? adjacencyListExtension : adjacencyListClassic;
+            // Tables of the board the robber tiles belong to
+            const LedLayout *tables = instance->currentLayout();
+            int tileCount = tables->tileCount;
+            const int *tileToLedIndex = tables->tileToLed;
+            const int(*adjacencyList)[6] = tables->adjacency;
 
             // Processed array for BFS (size 30 covers both modes)
             bool processed[30] = {false};
@@ -345,10 +427,10 @@ void LedController::animationTask(void *pvParameters)
                     Serial.print(tile);
                     Serial.print(" at LED index ");
                     Serial.println(ledIndex);
-                    instance->strip->setPixelColor(ledIndex, instance->Color(255, 0, 0));
+                    instance->drawOverlay(ledIndex, instance->Color(255, 0, 0));
                 }
             }
-            instance->strip->show();
+            instance->update();
             vTaskDelay(delayMs / portTICK_PERIOD_MS);
 
             // Process the BFS level-by-level (each level becomes a "wave")
@@ -378,7 +460,7 @@ void LedController::animationTask(void *pvParameters)
                             Serial.print(neighbor);
                             Serial.print(" at LED index ");
                             Serial.println(ledIndex);
-                            instance->strip->setPixelColor(ledIndex, instance->Color(255, 0, 0));
+                            instance->drawOverlay(ledIndex, instance->Color(255, 0, 0));
                         }
                     }
                 }
@@ -398,7 +480,7 @@ void LedController::animationTask(void *pvParameters)
                         Serial.println(ledIndex);
                     }
                     // Update the strip for the entire wave and delay
-                    instance->strip->show();
+                    instance->update();
                     vTaskDelay(delayMs / portTICK_PERIOD_MS);
                 }
 
@@ -414,7 +496,6 @@ void LedController::animationTask(void *pvParameters)
     }
 
     // Clean up before ending the task
-    delete[] params->tiles;
     instance->animationRunning = false;
     instance->animationTaskHandle = NULL;
     delete params;
@@ -9,6 +9,10 @@
  * - Board visualization
  * - Animations (waiting, start game, robber)
  * - Mapping between tile positions and LED positions
+ *
+ * Nothing writes to the strip directly: the board display and the
+ * animations draw on their own layers of a LedCompositor, under one lock,
+ * and update() sends the composited frame only when it changed.
  */
 
 #ifndef LEDCONTROLLER_H
@@ -16,6 +20,11 @@
 
 #include <Arduino.h>
 #include <Adafruit_NeoPixel.h>
+#include "LedCompositor.h"
+
+#define LED_ANIMATION_MAX_TILES 30 // Tiles an animation can start from (every hex of the largest board)
+
+struct LedLayout;
 
 /**
  * Animation ID constants
@@ -54,30 +63,32 @@ public:
     /**
      * Initialize the LED strip
      * @param numLeds Number of LEDs to initialize
+     * @param layout Tables of a loaded map, or nullptr for the built-in board of that LED count
      */
-    void begin(uint16_t numLeds);
+    void begin(uint16_t numLeds, const LedLayout *layout = nullptr);
 
     /**
      * Reinitialize the LED strip with a new LED count
      * Used when switching between classic and extension boards
      *
      * @param numLeds New number of LEDs
+     * @param layout Tables of a loaded map, or nullptr for the built-in board of that LED count
      */
-    void restart(uint16_t numLeds);
+    void restart(uint16_t numLeds, const LedLayout *layout = nullptr);
 
     /**
-     * Turn off all LEDs on the strip
+     * Turn off all LEDs of the board display
      */
     void turnOffAllLeds();
 
     /**
      * Update the LED strip display
-     * Pushes current colors to the physical LEDs
+     * Pushes the composited frame to the physical LEDs if it changed
      */
     void update();
 
     /**
-     * Set the color of a specific LED
+     * Set the color of a specific LED of the board display
      *
      * @param pixel LED index
      * @param color 32-bit color value (WRGB format)
@@ -85,7 +96,7 @@ public:
     void setPixelColor(uint16_t pixel, uint32_t color);
 
     /**
-     * Turn on a specific tile using its tile index
+     * Turn on a specific tile of the board display using its tile index
      * Maps tile index to the corresponding LED index
      *
      * @param tile Tile index (0-18 for classic, 0-29 for extension)
@@ -109,6 +120,16 @@ public:
      */
     Adafruit_NeoPixel *getStrip();
 
+    /**
+     * Number of frames sent to the LED strip
+     */
+    uint32_t framesShown();
+
+    /**
+     * Number of frames that matched the LEDs and were not sent
+     */
+    uint32_t framesSkipped();
+
     /**
      * Run dice roll animation
      * Shows colorful random patterns when dice are rolled
@@ -121,14 +142,16 @@ public:
      * Start an animation sequence
      *
      * @param animationId Animation type (WAITING_ANIMATION, START_GAME_ANIMATION, ROBBER_ANIMATION)
-     * @param tiles Array of tile indices (used for ROBBER_ANIMATION)
-     * @param numTiles Number of tiles in the array
+     * @param tiles Array of tile indices (used for ROBBER_ANIMATION), copied
+     * @param numTiles Number of tiles in the array (at most LED_ANIMATION_MAX_TILES)
      * @param delayMs Delay between animation steps in milliseconds
      */
-    void startAnimation(uint8_t animationId, uint16_t *tiles = nullptr, uint8_t numTiles = 0, uint32_t delayMs = 500);
+    void startAnimation(uint8_t animationId, const uint8_t *tiles = nullptr, uint8_t numTiles = 0,
+                        uint32_t delayMs = 500);
 
     /**
      * Stop any currently running animation
+     * Also clears what the last animation left over the board
      */
     void stopAnimation();
 
@@ -137,6 +160,11 @@ private:
     uint16_t ledCount;        // Number of LEDs in the strip
     uint8_t ledBrightness;    // Brightness level (0-255)
     Adafruit_NeoPixel *strip; // Pointer to the NeoPixel strip object
+    const LedLayout *layout;  // Tile, spiral and neighbour tables of the current board (under frameLock)
+
+    // Frame composition
+    LedCompositor frame;         // Layers and last frame sent to the strip
+    SemaphoreHandle_t frameLock; // Guards frame and strip between the loop and animation tasks
 
     // Animation control variables
     volatile bool animationRunning;   // Flag indicating if an animation is active
@@ -148,13 +176,44 @@ private:
      */
     struct AnimationParams
     {
-        uint8_t animationId;     // Animation type ID
-        uint16_t *tiles;         // Array of tile indices (for robber animation)
-        uint16_t numTiles;       // Number of tiles provided
-        uint32_t delayMs;        // Animation timing parameter
-        LedController *instance; // Pointer to LedController instance
+        uint8_t animationId;                    // Animation type ID
+        uint8_t tiles[LED_ANIMATION_MAX_TILES]; // Tile indices (for robber animation)
+        uint16_t numTiles;                      // Number of tiles provided
+        uint32_t delayMs;                       // Animation timing parameter
+        LedController *instance;                // Pointer to LedController instance
     };
 
+    /**
+     * Take the frame lock (no-op before begin())
+     */
+    void lockFrame();
+
+    /**
+     * Release the frame lock
+     */
+    void unlockFrame();
+
+    /**
+     * Tables of the current board, read under the frame lock
+     * The tables themselves are never freed, only swapped by restart()
+     */
+    const LedLayout *currentLayout();
+
+    /**
+     * Set a pixel of the animation layer
+     *
+     * @param pixel LED index
+     * @param color 32-bit color value, 0 hides the board under it
+     */
+    void drawOverlay(uint16_t pixel, uint32_t color);
+
+    /**
+     * Set every pixel of the animation layer
+     *
+     * @param color 32-bit color value
+     */
+    void fillOverlay(uint32_t color);
+
     /**
      * Static animation task function
      * Runs the animation in a separate FreeRTOS task
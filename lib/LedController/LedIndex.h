@@ -16,6 +16,9 @@
 #ifndef LEDINDEX_H
 #define LEDINDEX_H
 
+#include <stdint.h>
+#include "adjancency.h"
+
 /**
  * Classic board mapping from tile index to LED index
  *
@@ -91,4 +94,32 @@ static const int spiralLedIndexClassic[19] = {
 static const int spiralLedIndexExtension[30] = {
     0, 1, 2, 3, 4, 14, 15, 25, 26, 27, 28, 29, 21, 20, 9, 8, 7, 6, 5, 13, 16, 24, 23, 22, 19, 10, 11, 12, 17, 18};
 
+/**
+ * LedLayout structure
+ *
+ * Tables of one board size, picked once when the strip is (re)started
+ * so drawing code never has to test the LED count.
+ */
+struct LedLayout
+{
+    uint16_t tileCount;        // Number of hexes (one LED per hex)
+    const int *tileToLed;      // Tile index to LED index
+    const int *spiral;         // LED order of the spiral animations
+    const int (*adjacency)[6]; // Neighbour table of the board
+};
+
+static const LedLayout ledLayoutClassic = {19, tileToLedIndexClassic, spiralLedIndexClassic, adjacencyListClassic};
+static const LedLayout ledLayoutExtension = {30, tileToLedIndexExtension, spiralLedIndexExtension, adjacencyListExtension};
+
+/**
+ * Tables of the board matching a strip length
+ *
+ * @param numLeds Number of LEDs in the strip (30 for the extension board)
+ * @return Layout of the extension board for 30 LEDs, of the classic board otherwise
+ */
+inline const LedLayout *ledLayoutFor(uint16_t numLeds)
+{
+    return numLeds == 30 ? &ledLayoutExtension : &ledLayoutClassic;
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,275 @@
+#include <stdio.h>
+#include <string.h>
+#include "RollHistory.h"
+#include "BoardRules.h"
+
+/**
+ * Pack into 32 bits: seconds (20), number (4), die1 (3), die2 (3), manual (1)
+ * Timestamps past ROLL_SECONDS_MAX stay at the maximum
+ */
+uint32_t RollEntry::pack() const
+{
+    uint32_t time = seconds < ROLL_SECONDS_MAX ? seconds : ROLL_SECONDS_MAX;
+    return time | (uint32_t)(number & 0xF) << 20 | (uint32_t)(die1 & 0x7) << 24 | (uint32_t)(die2 & 0x7) << 27 |
+           (uint32_t)(manual ? 1 : 0) << 30;
+}
+
+/**
+ * Unpack an entry made by pack()
+ */
+RollEntry RollEntry::unpack(uint32_t packed)
+{
+    RollEntry entry;
+    entry.seconds = packed & ROLL_SECONDS_MAX;
+    entry.number = (packed >> 20) & 0xF;
+    entry.die1 = (packed >> 24) & 0x7;
+    entry.die2 = (packed >> 27) & 0x7;
+    entry.manual = (packed >> 30) & 1;
+    return entry;
+}
+
+/**
+ * Constructor - empty history
+ */
+RollHistory::RollHistory()
+{
+    clear();
+}
+
+/**
+ * Forget every roll and statistic
+ */
+void RollHistory::clear()
+{
+    head = 0;
+    length = 0;
+    rollCount = 0;
+    manualCount = 0;
+    doubleCount = 0;
+    memset(counts, 0, sizeof(counts));
+    memset(faces, 0, sizeof(faces));
+    streakNumber = 0;
+    streakLength = 0;
+    longestNumber = 0;
+    longestLength = 0;
+    sinceSeven = 0;
+    longestWithoutSeven = 0;
+}
+
+/**
+ * Add a roll to the ring and the statistics
+ * Each statistic moves by one step, nothing is recounted
+ */
+void RollHistory::record(const RollEntry &entry)
+{
+    restore(entry);
+
+    int number = entry.number <= 12 ? entry.number : 0;
+    rollCount++;
+    counts[number]++;
+    if (entry.manual)
+        manualCount++;
+    else
+    {
+        faces[entry.die1 <= 6 ? entry.die1 : 0]++;
+        faces[entry.die2 <= 6 ? entry.die2 : 0]++;
+        if (entry.die1 == entry.die2)
+            doubleCount++;
+    }
+
+    if (number == streakNumber)
+        streakLength++;
+    else
+    {
+        streakNumber = number;
+        streakLength = 1;
+    }
+    if (streakLength > longestLength)
+    {
+        longestNumber = streakNumber;
+        longestLength = streakLength;
+    }
+
+    sinceSeven = number == 7 ? 0 : sinceSeven + 1;
+    if (sinceSeven > longestWithoutSeven)
+        longestWithoutSeven = sinceSeven;
+}
+
+/**
+ * Add a roll to the ring only
+ * The oldest roll makes room once the ring is full
+ */
+void RollHistory::restore(const RollEntry &entry)
+{
+    if (length < ROLL_HISTORY_LENGTH)
+    {
+        ring[(head + length) % ROLL_HISTORY_LENGTH] = entry.pack();
+        length++;
+    }
+    else
+    {
+        ring[head] = entry.pack();
+        head = (head + 1) % ROLL_HISTORY_LENGTH;
+    }
+}
+
+/**
+ * Rolls of the whole game
+ */
+uint32_t RollHistory::rolls() const
+{
+    return rollCount;
+}
+
+/**
+ * Rolls kept in the ring
+ */
+int RollHistory::size() const
+{
+    return length;
+}
+
+/**
+ * Roll of the ring, oldest first
+ */
+RollEntry RollHistory::entry(int i) const
+{
+    return RollEntry::unpack(ring[(head + i) % ROLL_HISTORY_LENGTH]);
+}
+
+/**
+ * Game-wide index of the oldest roll in the ring
+ */
+uint32_t RollHistory::firstIndex() const
+{
+    return rollCount > length ? rollCount - length : 0;
+}
+
+/**
+ * Timestamp of the newest roll, 0 if there is none
+ */
+uint32_t RollHistory::lastSeconds() const
+{
+    return length > 0 ? entry(length - 1).seconds : 0;
+}
+
+/**
+ * Times a number was rolled or selected
+ */
+uint16_t RollHistory::count(int number) const
+{
+    return number >= 0 && number <= 12 ? counts[number] : 0;
+}
+
+/**
+ * Encode the statistics: 26 little-endian 16-bit values
+ * Order: rolls, manual, doubles, histogram 2-12, faces 1-6, current
+ * streak, longest streak, rolls since seven, longest without seven
+ */
+void RollHistory::encodeStats(uint8_t *out) const
+{
+    uint16_t values[ROLL_STATS_BYTES / 2] = {rollCount, manualCount, doubleCount};
+    int n = 3;
+    for (int number = 2; number <= 12; number++)
+        values[n++] = counts[number];
+    for (int face = 1; face <= 6; face++)
+        values[n++] = faces[face];
+    values[n++] = streakNumber;
+    values[n++] = streakLength;
+    values[n++] = longestNumber;
+    values[n++] = longestLength;
+    values[n++] = sinceSeven;
+    values[n++] = longestWithoutSeven;
+    for (int i = 0; i < n; i++)
+    {
+        out[2 * i] = values[i] & 0xFF;
+        out[2 * i + 1] = values[i] >> 8;
+    }
+}
+
+/**
+ * Replace the statistics with ones made by encodeStats()
+ */
+void RollHistory::decodeStats(const uint8_t *in)
+{
+    uint16_t values[ROLL_STATS_BYTES / 2];
+    for (int i = 0; i < ROLL_STATS_BYTES / 2; i++)
+        values[i] = in[2 * i] | in[2 * i + 1] << 8;
+
+    int n = 0;
+    rollCount = values[n++];
+    manualCount = values[n++];
+    doubleCount = values[n++];
+    memset(counts, 0, sizeof(counts));
+    memset(faces, 0, sizeof(faces));
+    for (int number = 2; number <= 12; number++)
+        counts[number] = values[n++];
+    for (int face = 1; face <= 6; face++)
+        faces[face] = values[n++];
+    streakNumber = values[n++];
+    streakLength = values[n++];
+    longestNumber = values[n++];
+    longestLength = values[n++];
+    sinceSeven = values[n++];
+    longestWithoutSeven = values[n++];
+}
+
+/**
+ * Format the statistics of a game as JSON
+ * Production is the histogram joined with the board index
+ */
+size_t formatRollStats(const RollHistory &history, const BoardIndex &index, uint32_t first, char *buffer, size_t size)
+{
+    size_t length = snprintf(buffer, size, "{\"rolls\":%u,\"manual\":%u,\"doubles\":%u,\"histogram\":[",
+                             history.rollCount, history.manualCount, history.doubleCount);
+    for (int number = 2; number <= 12 && length < size; number++)
+        length += snprintf(buffer + length, size - length, number == 2 ? "%u" : ",%u", history.counts[number]);
+    if (length < size)
+        length += snprintf(buffer + length, size - length, "],\"faces\":[");
+    for (int face = 1; face <= 6 && length < size; face++)
+        length += snprintf(buffer + length, size - length, face == 1 ? "%u" : ",%u", history.faces[face]);
+
+    // Hexes of the rolled numbers produce, the others stay at zero
+    uint16_t produced[BOARD_MAX_HEXES] = {};
+    for (int number = 2; number <= 12; number++)
+    {
+        if (history.counts[number] == 0)
+            continue;
+        const uint8_t *hexes = index.hexesWithNumber(number);
+        for (int i = 0; i < index.countNumber(number); i++)
+            produced[hexes[i]] = history.counts[number];
+    }
+
+    if (length < size)
+        length += snprintf(buffer + length, size - length, "],\"production\":[");
+    for (int hex = 0; hex < index.size() && length < size; hex++)
+        length += snprintf(buffer + length, size - length, hex == 0 ? "%u" : ",%u", produced[hex]);
+    if (length < size)
+        length += snprintf(buffer + length, size - length, "],\"resources\":[");
+    for (int resource = 0; resource < RESOURCE_DESERT && length < size; resource++)
+    {
+        uint32_t total = 0;
+        const uint8_t *hexes = index.hexesOfResource(resource);
+        for (int i = 0; i < index.countResource(resource); i++)
+            total += produced[hexes[i]];
+        length += snprintf(buffer + length, size - length, resource == 0 ? "%lu" : ",%lu", (unsigned long)total);
+    }
+
+    if (length < size)
+        length += snprintf(buffer + length, size - length,
+                           "],\"streak\":{\"number\":%u,\"length\":%u},\"longestStreak\":{\"number\":%u,\"length\":%u},"
+                           "\"rollsSinceSeven\":%u,\"longestWithoutSeven\":%u,\"first\":%lu,\"entries\":[",
+                           history.streakNumber, history.streakLength, history.longestNumber, history.longestLength,
+                           history.sinceSeven, history.longestWithoutSeven, (unsigned long)first);
+    return length < size ? length : size - 1;
+}
+
+/**
+ * Format one roll as a JSON array: [seconds,number,die1,die2,manual]
+ */
+size_t formatRollEntry(const RollEntry &entry, bool first, char *buffer, size_t size)
+{
+    int length = snprintf(buffer, size, "%s[%lu,%u,%u,%u,%s]", first ? "" : ",", (unsigned long)entry.seconds,
+                          entry.number, entry.die1, entry.die2, entry.manual ? "true" : "false");
+    return length < (int)size ? length : size - 1;
+}
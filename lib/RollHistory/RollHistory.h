@@ -0,0 +1,192 @@
+/**
+ * RollHistory.h
+ *
+ * This header defines the RollHistory class which remembers the rolls of
+ * the game in progress and keeps its dice statistics.
+ *
+ * It handles:
+ * - A ring of the last ROLL_HISTORY_LENGTH rolls, 4 bytes each
+ * - Statistics over every roll of the game, updated as each roll comes in:
+ *   number histogram, die faces, doubles, streaks and the longest run
+ *   without a seven
+ * - Compact encodings of rolls and statistics for the game journal
+ * - JSON for the /history endpoint, joined with the board index to count what
+ *   each hex and resource produced
+ *
+ * Memory stays the same however long the game runs: rolls older than the
+ * ring are dropped, but the statistics still count them.
+ */
+
+#ifndef ROLLHISTORY_H
+#define ROLLHISTORY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "BoardIndex.h"
+
+#define ROLL_HISTORY_LENGTH 256     // Rolls kept in the ring (4 bytes each)
+#define ROLL_STATS_BYTES 52         // Encoded statistics, see encodeStats()
+#define ROLL_SECONDS_MAX 0xFFFFF    // Largest timestamp of a roll (about 12 days of play)
+#define ROLL_HISTORY_STATS_SIZE 640 // Buffer large enough for formatRollStats()
+#define ROLL_HISTORY_ENTRY_SIZE 48  // Buffer large enough for one formatRollEntry()
+
+/**
+ * RollEntry structure
+ *
+ * One roll: when it happened, the number, and the dice that made it
+ */
+struct RollEntry
+{
+    uint32_t seconds; // Seconds of play since the game started
+    uint8_t number;   // Rolled or selected number (2-12)
+    uint8_t die1;     // First die (1-6), 0 if the number was picked by hand
+    uint8_t die2;     // Second die (1-6), 0 if the number was picked by hand
+    bool manual;      // Picked by hand instead of rolled
+
+    /**
+     * Pack into 32 bits: seconds (20), number (4), die1 (3), die2 (3), manual (1)
+     */
+    uint32_t pack() const;
+
+    /**
+     * Unpack an entry made by pack()
+     */
+    static RollEntry unpack(uint32_t packed);
+};
+
+/**
+ * RollHistory class
+ *
+ * Ring of recent rolls plus running statistics of the whole game
+ */
+class RollHistory
+{
+public:
+    /**
+     * Constructor - empty history
+     */
+    RollHistory();
+
+    /**
+     * Forget every roll and statistic
+     */
+    void clear();
+
+    /**
+     * Add a roll to the ring and the statistics
+     *
+     * @param entry New roll
+     */
+    void record(const RollEntry &entry);
+
+    /**
+     * Add a roll to the ring only, for rolls the restored statistics
+     * already count
+     *
+     * @param entry Roll read back from the journal
+     */
+    void restore(const RollEntry &entry);
+
+    /**
+     * Rolls of the whole game
+     */
+    uint32_t rolls() const;
+
+    /**
+     * Rolls kept in the ring
+     */
+    int size() const;
+
+    /**
+     * Roll of the ring, oldest first
+     *
+     * @param i Position in the ring (0 to size() - 1)
+     */
+    RollEntry entry(int i) const;
+
+    /**
+     * Game-wide index of the oldest roll in the ring
+     */
+    uint32_t firstIndex() const;
+
+    /**
+     * Timestamp of the newest roll, 0 if there is none
+     */
+    uint32_t lastSeconds() const;
+
+    /**
+     * Times a number was rolled or selected
+     *
+     * @param number Number (2-12)
+     */
+    uint16_t count(int number) const;
+
+    /**
+     * Encode the statistics: 26 little-endian 16-bit values
+     *
+     * @param out Output buffer, ROLL_STATS_BYTES bytes
+     */
+    void encodeStats(uint8_t *out) const;
+
+    /**
+     * Replace the statistics with ones made by encodeStats()
+     * The ring is left untouched
+     *
+     * @param in Encoded statistics, ROLL_STATS_BYTES bytes
+     */
+    void decodeStats(const uint8_t *in);
+
+private:
+    uint32_t ring[ROLL_HISTORY_LENGTH]; // Packed rolls, oldest at head
+    uint16_t head;                      // Position of the oldest roll
+    uint16_t length;                    // Rolls in the ring
+
+    uint16_t rollCount;           // Rolls of the game
+    uint16_t manualCount;         // Rolls picked by hand
+    uint16_t doubleCount;         // Rolls with two equal dice
+    uint16_t counts[13];          // Rolls per number, by number
+    uint16_t faces[7];            // Die faces seen, by face (two per roll)
+    uint16_t streakNumber;        // Number of the current streak
+    uint16_t streakLength;        // Rolls in a row of that number
+    uint16_t longestNumber;       // Number of the longest streak
+    uint16_t longestLength;       // Rolls in the longest streak
+    uint16_t sinceSeven;          // Rolls since the last seven
+    uint16_t longestWithoutSeven; // Longest run of rolls without a seven
+
+    friend size_t formatRollStats(const RollHistory &history, const BoardIndex &index, uint32_t first, char *buffer, size_t size);
+};
+
+/**
+ * Format the statistics of a game as JSON
+ *
+ * {"rolls":N,"manual":M,"doubles":D,"histogram":[<2..12>],"faces":[<1..6>],
+ *  "production":[<per hex>],"resources":[<per resource>],
+ *  "streak":{"number":n,"length":l},"longestStreak":{"number":n,"length":l},
+ *  "rollsSinceSeven":s,"longestWithoutSeven":w,"first":<first>,"entries":[
+ *
+ * The caller appends the entries (formatRollEntry) and closes with "]}".
+ * A hex produces each time its number is rolled; the robber is not
+ * followed. "resources" sums the hexes of each resource, desert excluded.
+ * Only the hexes of numbers rolled so far are visited.
+ *
+ * @param history Rolls of the game
+ * @param index Index of the board in play
+ * @param first Game-wide index of the first entry the caller appends
+ * @param buffer Output buffer (ROLL_HISTORY_STATS_SIZE bytes are enough)
+ * @param size Size of the output buffer
+ * @return Length of the text
+ */
+size_t formatRollStats(const RollHistory &history, const BoardIndex &index, uint32_t first, char *buffer, size_t size);
+
+/**
+ * Format one roll as a JSON array: [seconds,number,die1,die2,manual]
+ *
+ * @param entry Roll to format
+ * @param first Whether no entry precedes it (no leading comma)
+ * @param buffer Output buffer (ROLL_HISTORY_ENTRY_SIZE bytes are enough)
+ * @param size Size of the output buffer
+ * @return Length of the text
+ */
+size_t formatRollEntry(const RollEntry &entry, bool first, char *buffer, size_t size);
+
+#endif // ROLLHISTORY_H
@@ -0,0 +1,159 @@
+#include "StatePush.h"
+
+/**
+ * Constructor
+ */
+StatePush::StatePush()
+    : lastKeepAlive(0), broadcastCount(0), lastLatency(0), maxLatency(0)
+{
+    for (int slot = 0; slot < STATE_PUSH_MAX_CLIENTS; slot++)
+        active[slot] = false;
+}
+
+/**
+ * Turn a request's connection into an event stream
+ */
+bool StatePush::subscribe(WiFiClient &client, uint32_t id, const char *event, const char *data, size_t length)
+{
+    // Reuse the slot of a stream that went away
+    keepAlive();
+
+    int slot = 0;
+    while (slot < STATE_PUSH_MAX_CLIENTS && active[slot])
+        slot++;
+    if (slot == STATE_PUSH_MAX_CLIENTS)
+        return false;
+
+    // The web server sent nothing yet; answer the request here and keep
+    // our own copy of the connection once the server lets go of it
+    int headerLength = snprintf(buffer, sizeof(buffer),
+                                "HTTP/1.1 200 OK\r\n"
+                                "Content-Type: text/event-stream\r\n"
+                                "Cache-Control: no-cache\r\n"
+                                "Connection: keep-alive\r\n\r\n"
+                                "retry: %d\n\n",
+                                STATE_PUSH_RETRY_MS);
+    client.setNoDelay(true);
+    clients[slot] = client;
+    active[slot] = true;
+    write(slot, headerLength);
+    if (!active[slot])
+        return false;
+
+    size_t eventLength = format(id, event, data, length);
+    if (eventLength > 0)
+        write(slot, eventLength);
+    return active[slot];
+}
+
+/**
+ * Send one event to every subscriber
+ */
+void StatePush::broadcast(uint32_t id, const char *event, const char *data, size_t length, unsigned long changedAt)
+{
+    size_t eventLength = format(id, event, data, length);
+    if (eventLength == 0)
+    {
+        Serial.println("State event too large for STATE_PUSH_EVENT_SIZE");
+        return;
+    }
+
+    for (int slot = 0; slot < STATE_PUSH_MAX_CLIENTS; slot++)
+    {
+        if (active[slot])
+            write(slot, eventLength);
+    }
+
+    broadcastCount++;
+    lastLatency = micros() - changedAt;
+    if (lastLatency > maxLatency)
+        maxLatency = lastLatency;
+}
+
+/**
+ * Send keep-alive comments when due and drop closed connections
+ */
+void StatePush::keepAlive()
+{
+    bool due = millis() - lastKeepAlive >= STATE_PUSH_KEEPALIVE_MS;
+    if (due)
+    {
+        lastKeepAlive = millis();
+        memcpy(buffer, ":\n\n", 3);
+    }
+
+    for (int slot = 0; slot < STATE_PUSH_MAX_CLIENTS; slot++)
+    {
+        if (!active[slot])
+            continue;
+        if (!clients[slot].connected())
+        {
+            clients[slot].stop();
+            active[slot] = false;
+        }
+        else if (due)
+        {
+            write(slot, 3);
+        }
+    }
+}
+
+/**
+ * Number of open event streams
+ */
+int StatePush::subscribers() const
+{
+    int count = 0;
+    for (int slot = 0; slot < STATE_PUSH_MAX_CLIENTS; slot++)
+        count += active[slot] ? 1 : 0;
+    return count;
+}
+
+/**
+ * Number of events broadcast so far
+ */
+uint32_t StatePush::broadcasts() const
+{
+    return broadcastCount;
+}
+
+/**
+ * Time from the last change to its event being written to every subscriber (µs)
+ */
+uint32_t StatePush::lastLatencyUs() const
+{
+    return lastLatency;
+}
+
+/**
+ * Longest broadcast latency seen so far (µs)
+ */
+uint32_t StatePush::maxLatencyUs() const
+{
+    return maxLatency;
+}
+
+/**
+ * Format an event into the buffer
+ */
+size_t StatePush::format(uint32_t id, const char *event, const char *data, size_t length)
+{
+    int header = snprintf(buffer, sizeof(buffer), "id: %lu\nevent: %s\ndata: ", (unsigned long)id, event);
+    if (header < 0 || header + length + 2 > sizeof(buffer))
+        return 0;
+    memcpy(buffer + header, data, length);
+    memcpy(buffer + header + length, "\n\n", 2);
+    return header + length + 2;
+}
+
+/**
+ * Write the buffer to one subscriber, dropping it if the write fails
+ */
+void StatePush::write(int slot, size_t length)
+{
+    if (clients[slot].write((const uint8_t *)buffer, length) != length)
+    {
+        clients[slot].stop();
+        active[slot] = false;
+    }
+}
@@ -0,0 +1,125 @@
+/**
+ * StatePush.h
+ *
+ * This header defines the StatePush class which pushes game state
+ * changes to every open web page over Server-Sent Events (SSE).
+ *
+ * It handles:
+ * - Taking over the connection of a /events request and keeping it open
+ * - Writing one event to every subscriber, dropping the ones that left
+ * - Keep-alive comments, so idle connections are noticed and not timed out
+ * - Subscriber count and broadcast latency
+ *
+ * Each event carries the state version as its id, an event name and one
+ * line of JSON:
+ *
+ *   id: 42
+ *   event: number
+ *   data: {"selectedNumber":8}
+ *
+ * The web server only works on one request at a time, so all methods
+ * are meant to be called from the loop task.
+ */
+
+#ifndef STATEPUSH_H
+#define STATEPUSH_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+#define STATE_PUSH_MAX_CLIENTS 8         // Open pages served at once (each holds one socket)
+#define STATE_PUSH_EVENT_SIZE 1024       // Buffer for one formatted event, data included
+#define STATE_PUSH_KEEPALIVE_MS 15000    // Time between keep-alive comments
+#define STATE_PUSH_RETRY_MS 2000         // Reconnection delay suggested to the browser
+
+/**
+ * StatePush class
+ *
+ * Server-Sent Events broadcaster for game state changes
+ */
+class StatePush
+{
+public:
+    /**
+     * Constructor
+     */
+    StatePush();
+
+    /**
+     * Turn a request's connection into an event stream
+     * Writes the response headers and a first event, then keeps the
+     * connection for later broadcasts
+     *
+     * @param client Connection of the /events request
+     * @param id State version of the first event
+     * @param event Name of the first event
+     * @param data JSON of the first event
+     * @param length Length of the JSON
+     * @return True if subscribed, false if every slot is taken
+     */
+    bool subscribe(WiFiClient &client, uint32_t id, const char *event, const char *data, size_t length);
+
+    /**
+     * Send one event to every subscriber
+     *
+     * @param id State version the event brings the page to
+     * @param event Event name
+     * @param data JSON of the event, on one line
+     * @param length Length of the JSON
+     * @param changedAt micros() when the change happened, for the latency
+     */
+    void broadcast(uint32_t id, const char *event, const char *data, size_t length, unsigned long changedAt);
+
+    /**
+     * Send keep-alive comments when due and drop closed connections
+     * Called from loop()
+     */
+    void keepAlive();
+
+    /**
+     * Number of open event streams
+     */
+    int subscribers() const;
+
+    /**
+     * Number of events broadcast so far
+     */
+    uint32_t broadcasts() const;
+
+    /**
+     * Time from the last change to its event being written to every subscriber (µs)
+     */
+    uint32_t lastLatencyUs() const;
+
+    /**
+     * Longest broadcast latency seen so far (µs)
+     */
+    uint32_t maxLatencyUs() const;
+
+private:
+    WiFiClient clients[STATE_PUSH_MAX_CLIENTS]; // Open event streams
+    bool active[STATE_PUSH_MAX_CLIENTS];        // Which slots hold a stream
+    char buffer[STATE_PUSH_EVENT_SIZE];         // Event being written
+
+    unsigned long lastKeepAlive; // millis() of the last keep-alive round
+    uint32_t broadcastCount;     // Events broadcast
+    uint32_t lastLatency;        // Latency of the last broadcast (µs)
+    uint32_t maxLatency;         // Longest broadcast latency (µs)
+
+    /**
+     * Format an event into the buffer
+     *
+     * @return Length of the event, 0 if it does not fit
+     */
+    size_t format(uint32_t id, const char *event, const char *data, size_t length);
+
+    /**
+     * Write the buffer to one subscriber, dropping it if the write fails
+     *
+     * @param slot Subscriber slot
+     * @param length Bytes to write
+     */
+    void write(int slot, size_t length);
+};
+
+#endif // STATEPUSH_H
@@ -0,0 +1,109 @@
+/**
+ * BoardBatchTool.cpp
+ *
+ * Host tool that writes a pack of distinct boards, for tournaments that
+ * want every table on a different board. Built by the native-batch
+ * PlatformIO environment:
+ *
+ *   pio run -e native-batch
+ *   .pio/build/native-batch/program [--count N] [--config N] [--seed HEX]
+ *                                   [--min-balance N] [--output FILE]
+ *
+ * Boards come from BoardBatch, so no two of them are rotations or
+ * reflections of each other. Each board is one line of JSON (see
+ * formatBatchLine) and a last {"done":true,...} line reports the pack
+ * size, the duplicates dropped and the boards generated per second. The
+ * seed of each board regenerates it on the table with the same settings.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "BoardBatch.h"
+#include "esp_system.h"
+
+#define DEFAULT_COUNT 100 // Boards in a pack unless --count is given
+
+int main(int argc, char **argv)
+{
+    uint64_t count = DEFAULT_COUNT;
+    int combination = 0;
+    int minBalance = 0;
+    bool seeded = false;
+    uint64_t seed = 0;
+    const char *outputPath = nullptr;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--count") == 0 && i + 1 < argc)
+            count = strtoull(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "--config") == 0 && i + 1 < argc)
+            combination = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            seed = strtoull(argv[++i], nullptr, 16);
+            seeded = true;
+        }
+        else if (strcmp(argv[i], "--min-balance") == 0 && i + 1 < argc)
+            minBalance = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+            outputPath = argv[++i];
+        else
+        {
+            printf("Usage: %s [--count N] [--config N] [--seed HEX] [--min-balance N] [--output FILE]\n"
+                   "  --config N  rule combination as in the benchmark: bit 0 extension,\n"
+                   "              bits 1-4 6&8 / 2&12 / same numbers / same resources can touch\n",
+                   argv[0]);
+            return 1;
+        }
+    }
+    if (count < 1 || count > BOARD_BATCH_MAX_COUNT)
+    {
+        printf("--count must be between 1 and %d\n", BOARD_BATCH_MAX_COUNT);
+        return 1;
+    }
+    if (!seeded)
+        seed = ((uint64_t)esp_random() << 32) | esp_random();
+
+    BoardConfig config;
+    config.isExtension = combination & 1;
+    config.eightSixCanTouch = combination & 2;
+    config.twoTwelveCanTouch = combination & 4;
+    config.sameNumbersCanTouch = combination & 8;
+    config.sameResourceCanTouch = combination & 16;
+    config.minBalance = minBalance;
+
+    FILE *output = stdout;
+    if (outputPath != nullptr)
+    {
+        output = fopen(outputPath, "w");
+        if (output == nullptr)
+        {
+            printf("Cannot open %s\n", outputPath);
+            return 1;
+        }
+    }
+
+    BoardBatch batch(config, (uint32_t)count, seed);
+    Board board;
+    GenerationStats stats;
+    char line[BOARD_BATCH_LINE_SIZE];
+    auto start = std::chrono::steady_clock::now();
+    while (batch.next(board, &stats))
+    {
+        int length = formatBatchLine(board, batch.produced() - 1, batch.canonicalHash(), stats.balance, line, sizeof(line));
+        fwrite(line, 1, length, output);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    int length = formatBatchSummary(batch, seconds, line, sizeof(line));
+    fwrite(line, 1, length, output);
+    if (output != stdout)
+    {
+        fclose(output);
+        // Keep the summary on the terminal when the pack goes to a file
+        fwrite(line, 1, length, stdout);
+    }
+    return batch.exhausted() ? 2 : 0;
+}
@@ -0,0 +1,876 @@
+/**
+ * BoardBenchmark.cpp
+ *
+ * Host benchmark for the board generator, built by the native
+ * PlatformIO environment:
+ *
+ *   pio run -e native && .pio/build/native/program [--boards N] [--histogram] [--min-balance N]
+ *                                                  [--workers N] [--scaling] [--uniformity]
+ *                                                  [--json] [--legacy] [--classic-map FILE] [--extension-map FILE]
+ *
+ * For every BoardConfig rule combination on both board sizes it reports
+ * throughput (boards/sec), p50/p99/max generation latency, peak heap used
+ * while generating, the average search effort and the average balance
+ * score per board. With --histogram it also prints a log2 latency
+ * histogram per combination; --min-balance sets BoardConfig::minBalance.
+ * --workers N races N searches per board (generateBoardPortfolio).
+ *
+ * With --scaling it instead generates boards for the strictest rules on
+ * both sizes with 1, 2, 4, ... workers, up to --workers or the number of
+ * CPU cores, and reports the speedup over a single search.
+ *
+ * With --legacy it instead times the resource placement the generator
+ * started from (generateResources: a std::function recursion collecting
+ * neighbours in a std::unordered_set) against the solver, on both board
+ * sizes with only the resource rule on, and prints both rates next to
+ * each other. The solver places the number tokens as well, so the
+ * comparison favours the old code. Map files are ignored here.
+ *
+ * With --uniformity it instead checks, for every classic rule combination,
+ * that BoardSampler draws boards uniformly: a chi-square test compares the
+ * observed desert positions, resources on hex 0 and tokens on the centre
+ * hex with their exact probabilities. The solver is measured the same way
+ * for comparison. The exit code is non-zero if the sampler fails a test.
+ *
+ * With --json it instead times the game state document served by
+ * /getboard: the JSON encoder of the firmware (GameStateJson.h) against
+ * the former path, an ArduinoJson JsonDocument serialized into a growing
+ * string (std::string standing in for Arduino's String). It reports
+ * microseconds, heap allocations and heap bytes per document, and checks
+ * that both produce the same text.
+ *
+ * --classic-map and --extension-map load a map file (BoardMap.h) in place
+ * of that board, as the firmware does at boot, and report the load time.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <string>
+#include <functional>
+#include <random>
+#include <unordered_set>
+#include <ArduinoJson.h>
+#include "adjancency.h"
+#include "BoardGenerator.h"
+#include "BoardMap.h"
+#include "BoardSampler.h"
+#include "BoardFairness.h"
+#include "GameStateJson.h"
+
+#define DEFAULT_BOARDS 2000  // Boards generated per combination
+#define WARMUP_BOARDS 50     // Boards generated before timing starts
+#define HISTOGRAM_BUCKETS 24 // log2(us) buckets, 1 us to ~8 s
+#define UNIFORMITY_BOARDS 20000   // Boards drawn per generator in --uniformity
+#define UNIFORMITY_P_LIMIT 0.001  // Smallest p-value a uniform generator may show
+#define CENTRE_HEX 9              // Centre hex of the classic board
+#define SCALING_BOARDS 500        // Boards per worker count in --scaling
+#define JSON_CALLS 20000          // Documents encoded per path in --json
+#define LEGACY_SEED 0x5EED        // Seed of the legacy placement's std::mt19937 in --legacy
+
+// ----- Heap tracking -----
+// Every allocation carries a small header with its size, so the
+// benchmark can follow the live heap and its peak.
+
+static std::atomic<size_t> heapCurrent(0); // Bytes currently allocated (portfolio threads allocate too)
+static std::atomic<size_t> heapPeak(0);    // Highest heapCurrent since the last reset
+static std::atomic<size_t> heapAllocated(0);   // Bytes requested since start
+static std::atomic<size_t> heapAllocations(0); // Allocations since start
+
+static const size_t HEAP_HEADER = alignof(std::max_align_t);
+
+void *operator new(size_t size)
+{
+    unsigned char *block = static_cast<unsigned char *>(malloc(size + HEAP_HEADER));
+    if (block == nullptr)
+        throw std::bad_alloc();
+    memcpy(block, &size, sizeof(size));
+    heapAllocated += size;
+    heapAllocations++;
+    size_t current = heapCurrent += size;
+    size_t peak = heapPeak;
+    while (current > peak && !heapPeak.compare_exchange_weak(peak, current))
+    {
+    }
+    return block + HEAP_HEADER;
+}
+
+void operator delete(void *ptr) noexcept
+{
+    if (ptr == nullptr)
+        return;
+    unsigned char *block = static_cast<unsigned char *>(ptr) - HEAP_HEADER;
+    size_t size;
+    memcpy(&size, block, sizeof(size));
+    heapCurrent -= size;
+    free(block);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    operator delete(ptr);
+}
+
+// ----- Benchmark -----
+
+/**
+ * Results of one rule combination
+ */
+struct BenchResult
+{
+    double boardsPerSecond;
+    double p50Us;
+    double p99Us;
+    double maxUs;
+    size_t peakHeap;
+    double nodesPerBoard;
+    double restartsPerBoard;
+    double balancePerBoard;
+    uint32_t failedBoards; // Timed runs that gave up without a board
+    uint32_t histogram[HISTOGRAM_BUCKETS];
+};
+
+/**
+ * Build a readable name for a configuration
+ *
+ * @param config Board configuration
+ * @param name Output buffer
+ * @param size Size of the output buffer
+ */
+static void configName(const BoardConfig &config, char *name, size_t size)
+{
+    snprintf(name, size, "%s/86:%d/2-12:%d/num:%d/res:%d",
+             config.isExtension ? "extension" : "classic",
+             config.eightSixCanTouch, config.twoTwelveCanTouch,
+             config.sameNumbersCanTouch, config.sameResourceCanTouch);
+}
+
+/**
+ * Generate boards for one configuration and collect statistics
+ *
+ * @param config Board configuration
+ * @param boards Number of timed boards
+ * @param workers Searches raced per board (1 for plain generateBoard)
+ * @return Collected results
+ */
+static BenchResult runConfig(const BoardConfig &config, int boards, int workers)
+{
+    BenchResult result = {};
+    std::vector<double> latencies;
+    latencies.reserve(boards);
+
+    for (int i = 0; i < WARMUP_BOARDS; i++)
+        generateBoardPortfolio(config, workers);
+
+    uint64_t totalNodes = 0;
+    uint64_t totalRestarts = 0;
+    double totalBalance = 0;
+    size_t heapBase = heapCurrent;
+    heapPeak = heapBase;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < boards; i++)
+    {
+        GenerationStats stats;
+        auto t0 = std::chrono::steady_clock::now();
+        Board board;
+        if (workers > 1)
+            board = generateBoardPortfolio(config, workers, &stats);
+        else
+            board = generateBoard(config, &stats);
+        auto t1 = std::chrono::steady_clock::now();
+        if (board.empty())
+            result.failedBoards++;
+
+        double us = std::chrono::duration<double, std::micro>(t1 - t0).count();
+        latencies.push_back(us);
+        totalNodes += stats.nodes;
+        totalRestarts += stats.restarts;
+        totalBalance += stats.balance;
+
+        int bucket = 0;
+        while (bucket < HISTOGRAM_BUCKETS - 1 && us >= (double)(1UL << (bucket + 1)))
+            bucket++;
+        result.histogram[bucket]++;
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    std::sort(latencies.begin(), latencies.end());
+    double seconds = std::chrono::duration<double>(end - start).count();
+    result.boardsPerSecond = boards / seconds;
+    result.p50Us = latencies[boards / 2];
+    result.p99Us = latencies[(boards * 99) / 100];
+    result.maxUs = latencies.back();
+    result.peakHeap = heapPeak - heapBase;
+    result.nodesPerBoard = (double)totalNodes / boards;
+    result.restartsPerBoard = (double)totalRestarts / boards;
+    result.balancePerBoard = totalBalance / boards;
+    return result;
+}
+
+/**
+ * Print a log2 latency histogram
+ *
+ * @param result Results holding the histogram
+ * @param boards Number of timed boards
+ */
+static void printHistogram(const BenchResult &result, int boards)
+{
+    for (int bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++)
+    {
+        if (result.histogram[bucket] == 0)
+            continue;
+        int width = (int)(60.0 * result.histogram[bucket] / boards + 0.5);
+        printf("    [%8lu us, %8lu us) %7u ", 1UL << bucket, 1UL << (bucket + 1), result.histogram[bucket]);
+        for (int i = 0; i < width; i++)
+            putchar('#');
+        putchar('\n');
+    }
+}
+
+// ----- Uniformity -----
+
+/**
+ * Regularized upper incomplete gamma function Q(a, x)
+ * Series below a + 1, continued fraction above (Numerical Recipes)
+ */
+static double gammaQ(double a, double x)
+{
+    if (x <= 0)
+        return 1;
+    double logPrefix = -x + a * log(x) - lgamma(a);
+    if (x < a + 1)
+    {
+        double term = 1 / a;
+        double sum = term;
+        for (int n = 1; n < 500; n++)
+        {
+            term *= x / (a + n);
+            sum += term;
+            if (fabs(term) < fabs(sum) * 1e-15)
+                break;
+        }
+        return 1 - sum * exp(logPrefix);
+    }
+
+    double b = x + 1 - a;
+    double c = 1e300;
+    double d = 1 / b;
+    double h = d;
+    for (int i = 1; i < 500; i++)
+    {
+        double an = -i * (i - a);
+        b += 2;
+        d = an * d + b;
+        d = (fabs(d) < 1e-300) ? 1e-300 : d;
+        c = b + an / c;
+        c = (fabs(c) < 1e-300) ? 1e-300 : c;
+        d = 1 / d;
+        double delta = d * c;
+        h *= delta;
+        if (fabs(delta - 1) < 1e-15)
+            break;
+    }
+    return exp(logPrefix) * h;
+}
+
+/**
+ * Chi-square goodness of fit of observed counts against probabilities
+ *
+ * @param observed Observed count per cell
+ * @param expected Probability per cell
+ * @param cells Number of cells
+ * @param samples Total number of observations
+ * @return p-value (0 if a cell of probability 0 was observed)
+ */
+static double chiSquareP(const uint32_t *observed, const double *expected, int cells, int samples)
+{
+    double chi = 0;
+    int freedom = -1;
+    for (int i = 0; i < cells; i++)
+    {
+        double e = expected[i] * samples;
+        if (e <= 0)
+        {
+            if (observed[i] > 0)
+                return 0;
+            continue;
+        }
+        chi += (observed[i] - e) * (observed[i] - e) / e;
+        freedom++;
+    }
+    return freedom > 0 ? gammaQ(freedom / 2.0, chi / 2.0) : 1;
+}
+
+/**
+ * Observed statistics of one generator
+ */
+struct UniformityCounts
+{
+    uint32_t desert[SOLVER_MAX_HEXES];           // Boards with a desert on each hex
+    uint32_t firstResource[RESOURCE_TYPES];      // Resource on hex 0
+    uint32_t centreToken[TOKEN_TYPES + 1];       // Token index on the centre hex (TOKEN_NONE on a desert)
+};
+
+/**
+ * Record one board in the statistics
+ */
+static void countBoard(UniformityCounts &counts, const int *resources, const int *numbers, int hexCount)
+{
+    for (int hex = 0; hex < hexCount; hex++)
+    {
+        if (resources[hex] == RESOURCE_DESERT)
+            counts.desert[hex]++;
+    }
+    counts.firstResource[resources[0]]++;
+
+    int token = TOKEN_NONE;
+    for (int i = 0; i < TOKEN_TYPES; i++)
+    {
+        if (TOKEN_VALUES[i] == numbers[CENTRE_HEX])
+            token = i;
+    }
+    counts.centreToken[token]++;
+}
+
+/**
+ * Check the sampler (and the solver, for comparison) on every classic rule combination
+ *
+ * @param boards Boards drawn per generator and combination
+ * @return True if the sampler passed every test
+ */
+static bool runUniformity(int boards)
+{
+    printf("%-40s %10s %10s %12s %12s %12s %12s %12s %12s\n", "Uniformity (p-values)", "boards(M)",
+           "build(ms)", "desert", "hex0 res", "centre tok", "solver des", "solver res", "solver tok");
+    printf("%.*s\n", 140, "------------------------------------------------------------"
+                          "------------------------------------------------------------"
+                          "------------------------------------------------------------");
+
+    bool passed = true;
+    for (int combination = 0; combination < 32; combination += 2)
+    {
+        BoardConfig config;
+        config.eightSixCanTouch = combination & 2;
+        config.twoTwelveCanTouch = combination & 4;
+        config.sameNumbersCanTouch = combination & 8;
+        config.sameResourceCanTouch = combination & 16;
+
+        char name[64];
+        configName(config, name, sizeof(name));
+
+        auto start = std::chrono::steady_clock::now();
+        BoardSampler sampler(config);
+        double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (!sampler.ready())
+        {
+            printf("%-40s sampler tables exceed the state limit\n", name);
+            continue;
+        }
+
+        // Exact probabilities
+        double desert[SOLVER_MAX_HEXES];
+        double firstResource[RESOURCE_TYPES];
+        double centreToken[TOKEN_TYPES + 1];
+        for (int hex = 0; hex < 19; hex++)
+            desert[hex] = sampler.desertProbability(hex);
+        for (int type = 0; type < RESOURCE_TYPES; type++)
+            firstResource[type] = sampler.valueProbability(0, 0, type);
+        for (int token = 0; token <= TOKEN_TYPES; token++)
+            centreToken[token] = sampler.valueProbability(1, CENTRE_HEX, token);
+
+        // Draw from both generators
+        UniformityCounts sampled = {};
+        UniformityCounts solved = {};
+        Xoshiro128 rng(combination + 1);
+        for (int i = 0; i < boards; i++)
+        {
+            int resources[SOLVER_MAX_HEXES];
+            int numbers[SOLVER_MAX_HEXES];
+            sampler.sample(rng, resources, numbers);
+            countBoard(sampled, resources, numbers, 19);
+
+            Board board = generateBoard(config, rng);
+            for (int hex = 0; hex < board.size(); hex++)
+            {
+                resources[hex] = board.resource(hex);
+                numbers[hex] = board.number(hex);
+            }
+            countBoard(solved, resources, numbers, 19);
+        }
+
+        double p[6] = {
+            chiSquareP(sampled.desert, desert, 19, boards),
+            chiSquareP(sampled.firstResource, firstResource, RESOURCE_TYPES, boards),
+            chiSquareP(sampled.centreToken, centreToken, TOKEN_TYPES + 1, boards),
+            chiSquareP(solved.desert, desert, 19, boards),
+            chiSquareP(solved.firstResource, firstResource, RESOURCE_TYPES, boards),
+            chiSquareP(solved.centreToken, centreToken, TOKEN_TYPES + 1, boards),
+        };
+        bool ok = p[0] > UNIFORMITY_P_LIMIT && p[1] > UNIFORMITY_P_LIMIT && p[2] > UNIFORMITY_P_LIMIT;
+        passed = passed && ok;
+
+        printf("%-40s %10.3g %10.0f %12.4f %12.4f %12.4f %12.2e %12.2e %12.2e %s\n", name,
+               sampler.boardCount() / 1e6, buildMs, p[0], p[1], p[2], p[3], p[4], p[5], ok ? "" : "FAIL");
+    }
+    printf("Sampler %s (p > %g on every test)\n", passed ? "uniform" : "NOT uniform", UNIFORMITY_P_LIMIT);
+    return passed;
+}
+
+/**
+ * Measure how the portfolio scales with its number of workers
+ *
+ * Uses the strictest rules (nothing may touch), where solve times have
+ * the longest tail, and compares each worker count with a single search.
+ *
+ * @param boards Number of timed boards per worker count
+ * @param maxWorkers Largest worker count to measure
+ * @param minBalance Lowest balance score of the boards
+ */
+static void runScaling(int boards, int maxWorkers, int minBalance)
+{
+    printf("%-40s %8s %10s %10s %10s %10s %10s\n",
+           "Scaling", "workers", "boards/s", "p50(us)", "p99(us)", "max(us)", "speedup");
+    printf("%.*s\n", 104, "------------------------------------------------------------"
+                          "------------------------------------------------------------");
+
+    for (int size = 0; size < 2; size++)
+    {
+        BoardConfig config;
+        config.isExtension = (size == 1);
+        config.minBalance = minBalance;
+        char name[64];
+        configName(config, name, sizeof(name));
+
+        double single = 0;
+        for (int workers = 1; workers <= maxWorkers; workers *= 2)
+        {
+            BenchResult result = runConfig(config, boards, workers);
+            if (workers == 1)
+                single = result.boardsPerSecond;
+            printf("%-40s %8d %10.0f %10.1f %10.1f %10.1f %9.2fx\n", name, workers, result.boardsPerSecond,
+                   result.p50Us, result.p99Us, result.maxUs, result.boardsPerSecond / single);
+        }
+    }
+}
+
+// ----- Legacy resource placement -----
+
+/**
+ * Resource placement of the original generator, kept as the baseline
+ * Same search as the firmware ran before the bitmask solver, with
+ * esp_random() replaced by the caller's generator and the logging removed
+ *
+ * @param isExtension True for 30-hex extension board, false for 19-hex classic
+ * @param rng Random generator
+ * @return Vector of resource IDs for each hex position, empty on failure
+ */
+static std::vector<int> legacyGenerateResources(bool isExtension, std::mt19937 &rng)
+{
+    int totalHexes = isExtension ? 30 : 19;
+    std::vector<int> resourceCounts = isExtension ? std::vector<int>{6, 6, 6, 5, 5, 2}
+                                                  : std::vector<int>{4, 4, 4, 3, 3, 1};
+    std::vector<int> board(totalHexes, -1);
+    const int(*adjacencyList)[6] = isExtension ? adjacencyListExtension : adjacencyListClassic;
+
+    // Recursive lambda for backtracking tile assignment
+    std::function<bool(int, std::vector<int> &)> assignTile = [&](int index, std::vector<int> &counts) -> bool
+    {
+        if (index == totalHexes)
+            return true;
+
+        // Determine which resource types are disallowed because of assigned neighbors
+        std::unordered_set<int> disallowed;
+        for (int j = 0; j < 6; j++)
+        {
+            int neighbor = adjacencyList[index][j];
+            if (neighbor != -1 && board[neighbor] != -1)
+                disallowed.insert(board[neighbor]);
+        }
+
+        // Build a list of candidate resource types (available and not disallowed)
+        std::vector<int> candidates;
+        for (int type = 0; type < static_cast<int>(counts.size()); type++)
+        {
+            if (counts[type] > 0 && disallowed.find(type) == disallowed.end())
+                candidates.push_back(type);
+        }
+        std::shuffle(candidates.begin(), candidates.end(), rng);
+
+        for (int candidate : candidates)
+        {
+            board[index] = candidate;
+            counts[candidate]--;
+            if (assignTile(index + 1, counts))
+                return true;
+            board[index] = -1;
+            counts[candidate]++;
+        }
+        return false;
+    };
+
+    if (assignTile(0, resourceCounts))
+        return board;
+    return std::vector<int>();
+}
+
+/**
+ * Time the legacy resource placement on one board size
+ *
+ * @param isExtension Board size
+ * @param boards Number of timed placements
+ * @return Collected results (rate, latencies, peak heap and failures only)
+ */
+static BenchResult runLegacyConfig(bool isExtension, int boards)
+{
+    BenchResult result = {};
+    std::vector<double> latencies;
+    latencies.reserve(boards);
+    std::mt19937 rng(LEGACY_SEED);
+
+    for (int i = 0; i < WARMUP_BOARDS; i++)
+        legacyGenerateResources(isExtension, rng);
+
+    size_t heapBase = heapCurrent;
+    heapPeak = heapBase;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < boards; i++)
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        bool placed = !legacyGenerateResources(isExtension, rng).empty();
+        auto t1 = std::chrono::steady_clock::now();
+        if (!placed)
+            result.failedBoards++;
+        latencies.push_back(std::chrono::duration<double, std::micro>(t1 - t0).count());
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    std::sort(latencies.begin(), latencies.end());
+    result.boardsPerSecond = boards / std::chrono::duration<double>(end - start).count();
+    result.p50Us = latencies[boards / 2];
+    result.p99Us = latencies[(boards * 99) / 100];
+    result.maxUs = latencies.back();
+    result.peakHeap = heapPeak - heapBase;
+    return result;
+}
+
+/**
+ * Compare the legacy resource placement with the solver on both sizes
+ *
+ * @param boards Number of timed boards per generator and size
+ */
+static void runLegacy(int boards)
+{
+    printf("%-40s %10s %10s %9s %10s %10s %10s %10s\n", "Legacy", "legacy/s", "solver/s", "speedup",
+           "p99 old", "p99 new", "heap old", "heap new");
+    printf("%.*s\n", 116, "------------------------------------------------------------"
+                          "------------------------------------------------------------");
+
+    for (int size = 0; size < 2; size++)
+    {
+        // Only the resource rule, which is all generateResources enforced
+        BoardConfig config;
+        config.isExtension = (size == 1);
+        config.eightSixCanTouch = true;
+        config.twoTwelveCanTouch = true;
+        config.sameNumbersCanTouch = true;
+        config.sameResourceCanTouch = false;
+        char name[64];
+        configName(config, name, sizeof(name));
+
+        BenchResult legacy = runLegacyConfig(config.isExtension, boards);
+        BenchResult solver = runConfig(config, boards, 1);
+        printf("%-40s %10.0f %10.0f %8.1fx %10.1f %10.1f %10zu %10zu\n", name, legacy.boardsPerSecond,
+               solver.boardsPerSecond, solver.boardsPerSecond / legacy.boardsPerSecond, legacy.p99Us, solver.p99Us,
+               legacy.peakHeap, solver.peakHeap);
+        if (legacy.failedBoards > 0)
+            printf("    %u of %d legacy runs placed no resources\n", legacy.failedBoards, boards);
+    }
+}
+
+// ----- Game state JSON -----
+
+/**
+ * ArduinoJson allocator feeding the benchmark's allocation counters
+ */
+class CountingAllocator : public ArduinoJson::Allocator
+{
+public:
+    void *allocate(size_t size) override
+    {
+        heapAllocated += size;
+        heapAllocations++;
+        return malloc(size);
+    }
+
+    void deallocate(void *pointer) override
+    {
+        free(pointer);
+    }
+
+    void *reallocate(void *pointer, size_t size) override
+    {
+        heapAllocated += size;
+        heapAllocations++;
+        return realloc(pointer, size);
+    }
+};
+
+static CountingAllocator countingAllocator;
+
+/**
+ * Game state document built the way the firmware did before GameStateJson.h
+ *
+ * @param state Game state to encode
+ * @param output Output string, replaced
+ */
+static void legacyStateJson(const GameState &state, std::string &output)
+{
+    const Board &board = *state.board;
+    const BoardConfig &config = *state.config;
+    JsonDocument doc(&countingAllocator);
+    int ledNumber = board.size();
+
+    JsonArray resources = doc["resources"].to<JsonArray>();
+    for (int i = 0; i < ledNumber; i++)
+        resources.add(board.resource(i));
+    JsonArray numbers = doc["numbers"].to<JsonArray>();
+    for (int i = 0; i < ledNumber; i++)
+        numbers.add(board.number(i));
+
+    doc["extension"] = config.isExtension;
+    doc["gameStarted"] = state.gameStarted;
+    const BoardMap *map = loadedBoardMap(config.isExtension);
+    if (map != nullptr)
+    {
+        JsonArray rows = doc["rows"].to<JsonArray>();
+        for (int row = 0; row < map->rowCount; row++)
+            rows.add(map->rows[row]);
+    }
+    doc["eightSixCanTouch"] = config.eightSixCanTouch;
+    doc["twoTwelveCanTouch"] = config.twoTwelveCanTouch;
+    doc["sameNumbersCanTouch"] = config.sameNumbersCanTouch;
+    doc["sameResourceCanTouch"] = config.sameResourceCanTouch;
+    doc["minBalance"] = config.minBalance;
+    doc["manualDice"] = state.manualDice;
+    if (!board.empty())
+        doc["balance"] = roundf(scoreBoard(board).balance);
+    doc["selectedNumber"] = state.selectedNumber;
+
+    char seed[17];
+    snprintf(seed, sizeof(seed), "%08lx%08lx", (unsigned long)(board.seed >> 32), (unsigned long)(board.seed & 0xFFFFFFFF));
+    doc["seed"] = seed;
+
+    output.clear();
+    output.shrink_to_fit(); // Arduino's String starts empty for every response
+    serializeJson(doc, output);
+}
+
+/**
+ * Time both game state encoders on one board size
+ *
+ * @param isExtension Board size
+ * @param calls Documents encoded per path
+ * @return True if both encoders produced the same document
+ */
+static bool runJsonSize(bool isExtension, int calls)
+{
+    BoardConfig config;
+    config.isExtension = isExtension;
+    Board board = generateBoard(config, (uint64_t)0x5EED);
+    GameState state = {&board, &config, true, false, 8, (int)lroundf(scoreBoard(board).balance)};
+
+    std::string legacy;
+    legacyStateJson(state, legacy);
+    char buffer[GAME_STATE_JSON_SIZE];
+    size_t length = writeGameStateJson(state, buffer, sizeof(buffer));
+    bool same = legacy == std::string(buffer, length);
+
+    const char *names[2] = {"ArduinoJson + String", "GameStateJson"};
+    for (int path = 0; path < 2; path++)
+    {
+        size_t allocatedBefore = heapAllocated;
+        size_t allocationsBefore = heapAllocations;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < calls; i++)
+        {
+            if (path == 0)
+                legacyStateJson(state, legacy);
+            else
+                length = writeGameStateJson(state, buffer, sizeof(buffer));
+        }
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+        char name[64];
+        snprintf(name, sizeof(name), "%s/%s", isExtension ? "extension" : "classic", names[path]);
+        printf("%-40s %10.2f %10.1f %10.1f %10zu\n", name, us / calls,
+               (double)(heapAllocations - allocationsBefore) / calls,
+               (double)(heapAllocated - allocatedBefore) / calls, path == 0 ? legacy.size() : length);
+    }
+    if (!same)
+        printf("Documents differ:\n  %s\n  %s\n", legacy.c_str(), buffer);
+    return same;
+}
+
+/**
+ * Compare the game state encoders on both board sizes
+ *
+ * @param calls Documents encoded per path and size
+ * @return True if both encoders agree on both sizes
+ */
+static bool runJson(int calls)
+{
+    printf("%-40s %10s %10s %10s %10s\n", "Game state JSON", "us/call", "allocs", "heap(B)", "bytes");
+    printf("%.*s\n", 84, "------------------------------------------------------------"
+                         "------------------------------------------------------------");
+    bool classic = runJsonSize(false, calls);
+    bool extension = runJsonSize(true, calls);
+    return classic && extension;
+}
+
+/**
+ * Load a map file in place of the classic or extension board
+ *
+ * @param path Map file
+ * @param isExtension True to replace the extension board
+ * @return True if the map is valid and installed
+ */
+static bool loadMap(const char *path, bool isExtension)
+{
+    uint8_t data[BOARD_MAP_MAX_BYTES + 1];
+    FILE *file = fopen(path, "rb");
+    if (file == nullptr)
+    {
+        printf("Cannot open %s\n", path);
+        return false;
+    }
+    size_t size = fread(data, 1, sizeof(data), file);
+    fclose(file);
+
+    auto start = std::chrono::steady_clock::now();
+    bool loaded = installBoardMap(isExtension, data, size);
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    if (!loaded)
+    {
+        printf("%s is not a valid board map\n", path);
+        return false;
+    }
+
+    const BoardMap *map = loadedBoardMap(isExtension);
+    printf("%s map %s: %d hexes, %d vertices, %d edges, loaded in %.1f us\n", isExtension ? "Extension" : "Classic",
+           path, map->hexCount, map->topology.vertexCount, map->topology.edgeCount, us);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    int boards = DEFAULT_BOARDS;
+    bool boardsSet = false;
+    bool histogram = false;
+    bool uniformity = false;
+    bool scaling = false;
+    bool json = false;
+    bool legacy = false;
+    int workers = 1;
+    int minBalance = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--boards") == 0 && i + 1 < argc)
+        {
+            boards = atoi(argv[++i]);
+            boardsSet = true;
+        }
+        else if (strcmp(argv[i], "--histogram") == 0)
+            histogram = true;
+        else if (strcmp(argv[i], "--uniformity") == 0)
+            uniformity = true;
+        else if (strcmp(argv[i], "--min-balance") == 0 && i + 1 < argc)
+            minBalance = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc)
+            workers = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--scaling") == 0)
+            scaling = true;
+        else if (strcmp(argv[i], "--json") == 0)
+            json = true;
+        else if (strcmp(argv[i], "--legacy") == 0)
+            legacy = true;
+        else if (strcmp(argv[i], "--classic-map") == 0 && i + 1 < argc)
+        {
+            if (!loadMap(argv[++i], false))
+                return 1;
+        }
+        else if (strcmp(argv[i], "--extension-map") == 0 && i + 1 < argc)
+        {
+            if (!loadMap(argv[++i], true))
+                return 1;
+        }
+        else
+        {
+            printf("Usage: %s [--boards N] [--histogram] [--min-balance N] [--workers N] [--scaling] [--uniformity] "
+                   "[--json] [--legacy] [--classic-map FILE] [--extension-map FILE]\n",
+                   argv[0]);
+            return 1;
+        }
+    }
+    if (boards < 1)
+        boards = 1;
+    if (workers < 1)
+        workers = 1;
+    if (workers > BOARD_PORTFOLIO_MAX_WORKERS)
+        workers = BOARD_PORTFOLIO_MAX_WORKERS;
+    if (uniformity)
+        return runUniformity(boardsSet ? boards : UNIFORMITY_BOARDS) ? 0 : 1;
+    if (json)
+        return runJson(boardsSet ? boards : JSON_CALLS) ? 0 : 1;
+    if (legacy)
+    {
+        runLegacy(boards);
+        return 0;
+    }
+    if (scaling)
+    {
+        int maxWorkers = workers > 1 ? workers : (int)std::thread::hardware_concurrency();
+        runScaling(boardsSet ? boards : SCALING_BOARDS, std::max(maxWorkers, 1), minBalance);
+        return 0;
+    }
+
+    printf("%-40s %10s %10s %10s %10s %10s %10s %10s %10s\n",
+           "Benchmark", "boards/s", "p50(us)", "p99(us)", "max(us)", "heap(B)", "nodes", "restarts", "balance");
+    printf("%.*s\n", 127, "------------------------------------------------------------"
+                          "------------------------------------------------------------"
+                          "------------------------------------------------------------");
+
+    // Bit 0 selects the board size, bits 1-4 the adjacency rules
+    for (int combination = 0; combination < 32; combination++)
+    {
+        BoardConfig config;
+        config.isExtension = combination & 1;
+        config.eightSixCanTouch = combination & 2;
+        config.twoTwelveCanTouch = combination & 4;
+        config.sameNumbersCanTouch = combination & 8;
+        config.sameResourceCanTouch = combination & 16;
+        config.minBalance = minBalance;
+
+        char name[64];
+        configName(config, name, sizeof(name));
+        BenchResult result = runConfig(config, boards, workers);
+
+        printf("%-40s %10.0f %10.1f %10.1f %10.1f %10zu %10.1f %10.2f %10.1f\n",
+               name, result.boardsPerSecond, result.p50Us, result.p99Us, result.maxUs,
+               result.peakHeap, result.nodesPerBoard, result.restartsPerBoard, result.balancePerBoard);
+        if (result.failedBoards > 0)
+            printf("    %u of %d runs found no board under these rules\n", result.failedBoards, boards);
+        if (histogram)
+            printHistogram(result, boards);
+    }
+    return 0;
+}
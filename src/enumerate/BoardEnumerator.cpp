@@ -0,0 +1,616 @@
+/**
+ * BoardEnumerator.cpp
+ *
+ * Host tool that counts every valid board of a BoardConfig, built by the
+ * native-enumerate PlatformIO environment:
+ *
+ *   pio run -e native-enumerate
+ *   .pio/build/native-enumerate/program [--config N] [--layer resources|tokens|both]
+ *                                       [--threads N] [--max-seconds S] [--output FILE]
+ *
+ * The two layers of a board only meet at the deserts: a desert carries
+ * no token, every other hex carries one. For each placement D of the
+ * deserts the tool therefore counts the resource layouts R(D) and token
+ * layouts T(D) separately, and the number of complete boards is the sum
+ * of R(D) * T(D). Desert placements that are rotations/reflections of
+ * each other have the same counts, so only one placement per symmetry
+ * orbit is enumerated and its counts are weighted by the orbit size.
+ *
+ * Each count is a depth-first enumeration in hex order, split into
+ * subtrees (all valid assignments of the first few hexes) that worker
+ * threads take from a shared queue. With --output, every layout of one
+ * layer found for the enumerated desert placements is written to a
+ * binary stream (see writeHeader); the remaining layouts are images of
+ * these under the board symmetries.
+ *
+ * Unconstrained rule sets have far too many layouts to enumerate; use
+ * --max-seconds to stop early, in which case the counts are lower bounds.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "BoardGenerator.h"
+#include "BoardRules.h"
+#include "BoardSolver.h"
+#include "BoardSymmetry.h"
+
+#define MAX_DESERTS 2               // Deserts on the largest board
+#define SUBTREES_PER_THREAD 64      // Work items queued per worker thread
+#define OUTPUT_BUFFER_SIZE 65536    // Bytes buffered per thread before writing the stream
+#define STREAM_MAGIC "CBE1"         // First bytes of the binary stream
+#define STREAM_NO_VALUE 0x0F        // Nibble of a hex outside the streamed layer (token on a desert)
+#define LAYER_RESOURCES 0
+#define LAYER_TOKENS 1
+
+typedef unsigned __int128 uint128_t;
+
+// ----- Counting problems -----
+
+/**
+ * One layer of the board for one desert placement
+ *
+ * The variables are the non-desert hexes in index order. Each variable
+ * only checks the neighbours that come before it.
+ */
+struct LayerProblem
+{
+    int layer;                                 // LAYER_RESOURCES or LAYER_TOKENS
+    int placement;                             // Index of the desert placement
+    int varCount;                              // Hexes to fill
+    int hexOf[SOLVER_MAX_HEXES];               // Hex of each variable
+    int earlier[SOLVER_MAX_HEXES][6];          // Earlier neighbouring variables
+    int earlierCount[SOLVER_MAX_HEXES];        // Number of earlier neighbours
+    int valueCount;                            // Values a variable can take
+    uint16_t compatible[TOKEN_TYPES];          // Values allowed next to each value
+    uint8_t pool[TOKEN_TYPES];                 // Pieces of each value
+    std::atomic<uint64_t> count;               // Layouts found
+};
+
+/**
+ * Desert placement enumerated for one symmetry orbit
+ */
+struct Placement
+{
+    int deserts[MAX_DESERTS]; // Desert hexes, ascending
+    int orbitSize;            // Placements equivalent to this one
+    bool valid;               // False if the deserts break the resource rule
+    int problems[2];          // Problem index of each layer, or -1
+};
+
+/**
+ * Subtree of one problem: the first "depth" variables are fixed
+ */
+struct WorkItem
+{
+    int problem;
+    int depth;
+    int8_t prefix[SOLVER_MAX_HEXES];
+};
+
+/**
+ * Per-thread stream buffer
+ */
+struct StreamWriter
+{
+    FILE *file;
+    std::mutex *lock;
+    std::vector<uint8_t> buffer;
+    int hexCount;
+
+    void flush()
+    {
+        if (file == nullptr || buffer.empty())
+            return;
+        std::lock_guard<std::mutex> guard(*lock);
+        fwrite(buffer.data(), 1, buffer.size(), file);
+        buffer.clear();
+    }
+};
+
+static std::atomic<bool> stopRequested(false); // Set once the time limit is hit
+static std::atomic<uint64_t> totalNodes(0);    // Assignments tried by all threads
+static std::vector<Placement> placements;      // Enumerated desert placements
+
+/**
+ * Build the counting problem of one layer for one desert placement
+ *
+ * @param problem Problem to fill
+ * @param layout Board shape and pools
+ * @param config Adjacency rules
+ * @param layer LAYER_RESOURCES or LAYER_TOKENS
+ * @param placement Index of the desert placement
+ */
+static void buildProblem(LayerProblem &problem, const BoardLayout &layout, const BoardConfig &config,
+                         int layer, int placement)
+{
+    const Placement &deserts = placements[placement];
+    int desertCount = layout.resourceCounts[RESOURCE_DESERT];
+    int varOf[SOLVER_MAX_HEXES];
+
+    problem.layer = layer;
+    problem.placement = placement;
+    problem.varCount = 0;
+    problem.count = 0;
+    for (int hex = 0; hex < layout.hexCount; hex++)
+    {
+        bool desert = false;
+        for (int d = 0; d < desertCount; d++)
+            desert = desert || deserts.deserts[d] == hex;
+        varOf[hex] = desert ? -1 : problem.varCount;
+        if (!desert)
+            problem.hexOf[problem.varCount++] = hex;
+    }
+
+    // Earlier neighbours, taking pairs listed by either side
+    for (int var = 0; var < problem.varCount; var++)
+        problem.earlierCount[var] = 0;
+    for (int hex = 0; hex < layout.hexCount; hex++)
+    {
+        for (int slot = 0; slot < 6; slot++)
+        {
+            int other = layout.adjacency[hex][slot];
+            if (other == -1 || varOf[hex] == -1 || varOf[other] == -1)
+                continue;
+            int late = varOf[hex] > varOf[other] ? varOf[hex] : varOf[other];
+            int early = varOf[hex] > varOf[other] ? varOf[other] : varOf[hex];
+            bool known = false;
+            for (int e = 0; e < problem.earlierCount[late]; e++)
+                known = known || problem.earlier[late][e] == early;
+            if (!known)
+                problem.earlier[late][problem.earlierCount[late]++] = early;
+        }
+    }
+
+    if (layer == LAYER_RESOURCES)
+    {
+        // Deserts are already placed, the other resources are left
+        problem.valueCount = RESOURCE_DESERT;
+        for (int type = 0; type < RESOURCE_DESERT; type++)
+        {
+            problem.compatible[type] = resourceCompatibility(config, type) & ((1 << RESOURCE_DESERT) - 1);
+            problem.pool[type] = layout.resourceCounts[type];
+        }
+    }
+    else
+    {
+        problem.valueCount = TOKEN_TYPES;
+        for (int token = 0; token < TOKEN_TYPES; token++)
+        {
+            problem.compatible[token] = tokenCompatibility(config, token);
+            problem.pool[token] = layout.tokenCounts[token];
+        }
+    }
+}
+
+/**
+ * Values a variable may take given the earlier assignments
+ */
+static uint16_t allowedValues(const LayerProblem &problem, int var, const int8_t *value, const uint8_t *pool)
+{
+    uint16_t allowed = 0;
+    for (int x = 0; x < problem.valueCount; x++)
+    {
+        if (pool[x] > 0)
+            allowed |= 1 << x;
+    }
+    for (int e = 0; e < problem.earlierCount[var]; e++)
+        allowed &= problem.compatible[value[problem.earlier[var][e]]];
+    return allowed;
+}
+
+/**
+ * Append one complete layout to the stream
+ * Two hexes per byte, low nibble first
+ */
+static void writeLayout(const LayerProblem &problem, const int8_t *value, StreamWriter &writer)
+{
+    uint8_t nibbles[SOLVER_MAX_HEXES];
+    int noValue = (problem.layer == LAYER_RESOURCES) ? RESOURCE_DESERT : STREAM_NO_VALUE;
+    for (int hex = 0; hex < writer.hexCount; hex++)
+        nibbles[hex] = noValue;
+    for (int var = 0; var < problem.varCount; var++)
+        nibbles[problem.hexOf[var]] = value[var];
+
+    for (int hex = 0; hex < writer.hexCount; hex += 2)
+    {
+        uint8_t high = (hex + 1 < writer.hexCount) ? nibbles[hex + 1] : 0;
+        writer.buffer.push_back(nibbles[hex] | (high << 4));
+    }
+    if (writer.buffer.size() >= OUTPUT_BUFFER_SIZE)
+        writer.flush();
+}
+
+/**
+ * Count the layouts below an assignment of the first "var" variables
+ *
+ * @param problem Layer problem
+ * @param var Next variable to assign
+ * @param value Assigned values
+ * @param pool Pieces left of each value
+ * @param writer Stream to write layouts to, or nullptr to only count
+ * @param nodes Assignments tried (updated)
+ * @return Number of complete layouts
+ */
+static uint64_t countFrom(const LayerProblem &problem, int var, int8_t *value, uint8_t *pool,
+                          StreamWriter *writer, uint64_t &nodes)
+{
+    if (var == problem.varCount)
+    {
+        if (writer != nullptr)
+            writeLayout(problem, value, *writer);
+        return 1;
+    }
+    if (stopRequested.load(std::memory_order_relaxed))
+        return 0;
+
+    uint16_t allowed = allowedValues(problem, var, value, pool);
+
+    // The last hex takes the one piece left, if it fits
+    if (var == problem.varCount - 1 && writer == nullptr)
+    {
+        nodes++;
+        return allowed != 0 ? 1 : 0;
+    }
+
+    uint64_t count = 0;
+    for (int x = 0; x < problem.valueCount; x++)
+    {
+        if (!(allowed & (1 << x)))
+            continue;
+        nodes++;
+        value[var] = x;
+        pool[x]--;
+        count += countFrom(problem, var + 1, value, pool, writer, nodes);
+        pool[x]++;
+    }
+    return count;
+}
+
+/**
+ * Collect every valid assignment of the first "depth" variables
+ *
+ * @param problem Layer problem
+ * @param problemIndex Index of the problem
+ * @param depth Number of variables to fix
+ * @param var Next variable to assign
+ * @param value Assigned values
+ * @param pool Pieces left of each value
+ * @param items Output work items
+ */
+static void splitSubtrees(const LayerProblem &problem, int problemIndex, int depth, int var, int8_t *value,
+                          uint8_t *pool, std::vector<WorkItem> &items)
+{
+    if (var == depth)
+    {
+        WorkItem item;
+        item.problem = problemIndex;
+        item.depth = depth;
+        memcpy(item.prefix, value, depth);
+        items.push_back(item);
+        return;
+    }
+
+    uint16_t allowed = allowedValues(problem, var, value, pool);
+    for (int x = 0; x < problem.valueCount; x++)
+    {
+        if (!(allowed & (1 << x)))
+            continue;
+        value[var] = x;
+        pool[x]--;
+        splitSubtrees(problem, problemIndex, depth, var + 1, value, pool, items);
+        pool[x]++;
+    }
+}
+
+// ----- Desert placements -----
+
+/**
+ * Find one desert placement per symmetry orbit
+ *
+ * A placement is kept if it is the smallest of its images (as a sorted
+ * hex list); its orbit size is the number of distinct images.
+ *
+ * @param layout Board shape and pools
+ * @param config Adjacency rules
+ * @param symmetry Symmetries of the board
+ */
+static void findPlacements(const BoardLayout &layout, const BoardConfig &config, const BoardSymmetry &symmetry)
+{
+    int desertCount = layout.resourceCounts[RESOURCE_DESERT];
+    int hexCount = layout.hexCount;
+    uint16_t desertRule = resourceCompatibility(config, RESOURCE_DESERT);
+
+    for (int a = 0; a < hexCount; a++)
+    {
+        for (int b = (desertCount > 1 ? a + 1 : a); b < (desertCount > 1 ? hexCount : a + 1); b++)
+        {
+            int keys[SYMMETRY_MAX];
+            int key = a * hexCount + b;
+            bool canonical = true;
+            int orbitSize = 0;
+
+            for (int s = 0; s < symmetry.count() && canonical; s++)
+            {
+                int ia = symmetry.image(s, a);
+                int ib = symmetry.image(s, b);
+                int image = (ia < ib) ? ia * hexCount + ib : ib * hexCount + ia;
+                canonical = image >= key;
+
+                bool seen = false;
+                for (int k = 0; k < orbitSize; k++)
+                    seen = seen || keys[k] == image;
+                if (!seen)
+                    keys[orbitSize++] = image;
+            }
+            if (!canonical)
+                continue;
+
+            Placement placement;
+            placement.deserts[0] = a;
+            placement.deserts[1] = b;
+            placement.orbitSize = orbitSize;
+            placement.problems[0] = placement.problems[1] = -1;
+
+            // Two deserts may be banned from touching
+            placement.valid = true;
+            if (desertCount > 1 && !(desertRule & (1 << RESOURCE_DESERT)))
+            {
+                for (int slot = 0; slot < 6; slot++)
+                {
+                    if (layout.adjacency[a][slot] == b || layout.adjacency[b][slot] == a)
+                        placement.valid = false;
+                }
+            }
+            placements.push_back(placement);
+        }
+    }
+}
+
+// ----- Output -----
+
+/**
+ * Print an unsigned 128-bit integer
+ */
+static void printCount(uint128_t value, int width)
+{
+    char digits[48];
+    int length = 0;
+    do
+    {
+        digits[length++] = '0' + (int)(value % 10);
+        value /= 10;
+    } while (value != 0);
+
+    for (int i = length; i < width; i++)
+        putchar(' ');
+    while (length > 0)
+        putchar(digits[--length]);
+}
+
+/**
+ * Write the stream header
+ *
+ * 4 bytes magic "CBE1", then hex count, layer (0 resources, 1 tokens),
+ * number of board symmetries and a reserved zero byte. Each following
+ * record is one layout, two hexes per byte (low nibble first): resource
+ * IDs, or token indices into TOKEN_VALUES with 0xF on deserts.
+ */
+static void writeHeader(FILE *file, int hexCount, int layer, int symmetries)
+{
+    uint8_t header[8];
+    memcpy(header, STREAM_MAGIC, 4);
+    header[4] = hexCount;
+    header[5] = layer;
+    header[6] = symmetries;
+    header[7] = 0;
+    fwrite(header, 1, sizeof(header), file);
+}
+
+// ----- Main -----
+
+int main(int argc, char **argv)
+{
+    int combination = 0;
+    int layers = 3; // Bit 0 resources, bit 1 tokens
+    int threadCount = (int)std::thread::hardware_concurrency();
+    double maxSeconds = 0;
+    const char *outputPath = nullptr;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--config") == 0 && i + 1 < argc)
+            combination = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--layer") == 0 && i + 1 < argc)
+        {
+            i++;
+            layers = (strcmp(argv[i], "resources") == 0) ? 1 : (strcmp(argv[i], "tokens") == 0) ? 2 : 3;
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            threadCount = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--max-seconds") == 0 && i + 1 < argc)
+            maxSeconds = atof(argv[++i]);
+        else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+            outputPath = argv[++i];
+        else
+        {
+            printf("Usage: %s [--config N] [--layer resources|tokens|both] [--threads N]\n"
+                   "          [--max-seconds S] [--output FILE]\n"
+                   "  --config N  rule combination as in the benchmark: bit 0 extension,\n"
+                   "              bits 1-4 6&8 / 2&12 / same numbers / same resources can touch\n",
+                   argv[0]);
+            return 1;
+        }
+    }
+    if (threadCount < 1)
+        threadCount = 1;
+    if (outputPath != nullptr && layers == 3)
+    {
+        printf("--output needs a single --layer (resources or tokens)\n");
+        return 1;
+    }
+
+    BoardConfig config;
+    config.isExtension = combination & 1;
+    config.eightSixCanTouch = combination & 2;
+    config.twoTwelveCanTouch = combination & 4;
+    config.sameNumbersCanTouch = combination & 8;
+    config.sameResourceCanTouch = combination & 16;
+
+    const BoardLayout &layout = boardLayout(config.isExtension);
+    BoardSymmetry symmetry(layout.adjacency, layout.hexCount);
+    findPlacements(layout, config, symmetry);
+
+    printf("Board: %s, 86:%d 2-12:%d num:%d res:%d\n", config.isExtension ? "extension" : "classic",
+           config.eightSixCanTouch, config.twoTwelveCanTouch, config.sameNumbersCanTouch,
+           config.sameResourceCanTouch);
+    printf("Symmetries: %d, desert placements enumerated: %zu\n", symmetry.count(), placements.size());
+
+    // One problem per layer and valid desert placement
+    std::vector<LayerProblem> problems(placements.size() * 2);
+    int problemCount = 0;
+    for (size_t p = 0; p < placements.size(); p++)
+    {
+        if (!placements[p].valid)
+            continue;
+        for (int layer = 0; layer < 2; layer++)
+        {
+            if (!(layers & (1 << layer)))
+                continue;
+            buildProblem(problems[problemCount], layout, config, layer, p);
+            placements[p].problems[layer] = problemCount++;
+        }
+    }
+
+    // Split every problem into subtrees until there is enough work to share
+    std::vector<WorkItem> items;
+    int depth = 0;
+    while (true)
+    {
+        items.clear();
+        for (int p = 0; p < problemCount; p++)
+        {
+            int8_t value[SOLVER_MAX_HEXES];
+            uint8_t pool[TOKEN_TYPES];
+            memcpy(pool, problems[p].pool, sizeof(pool));
+            int problemDepth = depth < problems[p].varCount ? depth : problems[p].varCount;
+            splitSubtrees(problems[p], p, problemDepth, 0, value, pool, items);
+        }
+        if (items.size() >= (size_t)threadCount * SUBTREES_PER_THREAD || depth >= layout.hexCount - 2)
+            break;
+        depth++;
+    }
+
+    FILE *output = nullptr;
+    std::mutex outputLock;
+    if (outputPath != nullptr)
+    {
+        output = fopen(outputPath, "wb");
+        if (output == nullptr)
+        {
+            printf("Cannot open %s\n", outputPath);
+            return 1;
+        }
+        writeHeader(output, layout.hexCount, layers == 1 ? LAYER_RESOURCES : LAYER_TOKENS, symmetry.count());
+    }
+
+    // Worker threads take subtrees from a shared queue
+    std::atomic<size_t> nextItem(0);
+    auto start = std::chrono::steady_clock::now();
+    auto worker = [&]()
+    {
+        StreamWriter writer = {output, &outputLock, {}, layout.hexCount};
+        uint64_t nodes = 0;
+        while (true)
+        {
+            size_t index = nextItem.fetch_add(1);
+            if (index >= items.size() || stopRequested.load())
+                break;
+
+            const WorkItem &item = items[index];
+            LayerProblem &problem = problems[item.problem];
+            int8_t value[SOLVER_MAX_HEXES];
+            uint8_t pool[TOKEN_TYPES];
+            memcpy(pool, problem.pool, sizeof(pool));
+            for (int var = 0; var < item.depth; var++)
+            {
+                value[var] = item.prefix[var];
+                pool[item.prefix[var]]--;
+            }
+            problem.count += countFrom(problem, item.depth, value, pool, output ? &writer : nullptr, nodes);
+
+            if (maxSeconds > 0 &&
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() > maxSeconds)
+                stopRequested = true;
+        }
+        writer.flush();
+        totalNodes += nodes;
+    };
+
+    // The time limit is also checked by a watchdog, since one subtree may run for long
+    std::atomic<bool> finished(false);
+    std::thread watchdog([&]()
+                         {
+        while (!finished.load() && maxSeconds > 0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            if (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() > maxSeconds)
+                stopRequested = true;
+        } });
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; t++)
+        threads.emplace_back(worker);
+    for (std::thread &thread : threads)
+        thread.join();
+    finished = true;
+    watchdog.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (output != nullptr)
+        fclose(output);
+
+    // Report counts per desert placement
+    printf("\n%-10s %6s %24s %24s %40s\n", "Deserts", "orbit", "resource layouts", "token layouts", "boards");
+    uint128_t totalResources = 0;
+    uint128_t totalBoards = 0;
+    for (const Placement &placement : placements)
+    {
+        char name[16];
+        if (layout.resourceCounts[RESOURCE_DESERT] > 1)
+            snprintf(name, sizeof(name), "%d,%d", placement.deserts[0], placement.deserts[1]);
+        else
+            snprintf(name, sizeof(name), "%d", placement.deserts[0]);
+
+        uint64_t resources = placement.problems[0] >= 0 ? problems[placement.problems[0]].count.load() : 0;
+        uint64_t tokens = placement.problems[1] >= 0 ? problems[placement.problems[1]].count.load() : 0;
+        uint128_t boards = (uint128_t)resources * tokens * placement.orbitSize;
+        totalResources += (uint128_t)resources * placement.orbitSize;
+        totalBoards += boards;
+
+        printf("%-10s %6d ", name, placement.orbitSize);
+        printCount(resources, 24);
+        putchar(' ');
+        printCount(tokens, 24);
+        putchar(' ');
+        printCount(boards, 40);
+        putchar('\n');
+    }
+
+    printf("\nResource layouts: ");
+    printCount(totalResources, 0);
+    printf("\nBoards:           ");
+    printCount((layers == 3) ? totalBoards : 0, 0);
+    if (layers != 3)
+        printf(" (needs both layers)");
+    printf("\n\nTime: %.3f s, %d threads, %zu subtrees at depth %d, %llu nodes (%.1f M nodes/s)\n",
+           seconds, threadCount, items.size(), depth, (unsigned long long)totalNodes.load(),
+           totalNodes.load() / seconds / 1e6);
+    if (stopRequested)
+        printf("Time limit reached: counts are lower bounds.\n");
+    return 0;
+}
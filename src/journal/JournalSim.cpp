@@ -0,0 +1,447 @@
+/**
+ * JournalSim.cpp
+ *
+ * Host tool exercising GameJournal on a simulated flash. Built by the
+ * native-journal PlatformIO environment:
+ *
+ *   pio run -e native-journal
+ *   .pio/build/native-journal/program [--saves N] [--seed HEX]
+ *
+ * It plays a game of N saves, each one roll or now and then a burst of
+ * three, with every seventh number picked by hand. The first run
+ * measures the bytes and 256-byte flash pages programmed per save, next
+ * to rewriting the whole game state JSON on every save as older firmware
+ * did. The second part cuts the power at every byte of the same game:
+ * after each cut the journal is loaded again and must hold the game and
+ * roll history of the last save that completed, and must keep working
+ * for the saves that follow. The last part does the same across the start
+ * of a new game whose first rolls are saved in the same batch, written as
+ * GameSaver writes it: the files must hold either the whole old game or
+ * the new board with its rolls, never the old board with the new rolls.
+ *
+ * Exits with 1 if any cut point loses or corrupts the game.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "BoardIndex.h"
+#include "GameJournal.h"
+#include "GameStateJson.h"
+
+#define DEFAULT_SAVES 800    // Saves per game unless --saves is given (enough for two compactions)
+#define FLASH_PAGE_BYTES 256 // Program page of the SPIFFS partition
+#define RECOVERY_ROLLS 3     // Rolls played after each power cut
+#define OLD_GAME_SAVES 40    // Saves of the game played before a new one starts
+#define NEW_GAME_ROLLS 3     // Rolls saved in the same batch as a new game
+
+/**
+ * SimFlash class
+ *
+ * In-memory journal files that count what is programmed and can lose
+ * power after a given number of bytes
+ */
+class SimFlash : public JournalStorage
+{
+public:
+    uint64_t bytesWritten = 0;    // Bytes programmed
+    uint64_t pagesProgrammed = 0; // Flash pages touched by those bytes
+    long budget = -1;             // Bytes left before the power cut, -1 for none
+    bool powerLost = false;       // Set once the budget ran out
+
+    size_t read(int file, uint8_t *buffer, size_t size) override
+    {
+        if (!exists[file])
+            return 0;
+        size_t length = files[file].size() < size ? files[file].size() : size;
+        if (length > 0)
+            memcpy(buffer, files[file].data(), length);
+        return length;
+    }
+
+    bool append(int file, const uint8_t *data, size_t length) override
+    {
+        if (powerLost)
+            return false;
+        exists[file] = true;
+        return program(files[file], data, length);
+    }
+
+    bool create(int file, const uint8_t *data, size_t length) override
+    {
+        if (powerLost)
+            return false;
+        files[file].clear();
+        exists[file] = true;
+        return program(files[file], data, length);
+    }
+
+    void remove(int file) override
+    {
+        if (powerLost)
+            return;
+        files[file].clear();
+        exists[file] = false;
+    }
+
+    /**
+     * Restore power for the next boot
+     */
+    void reboot()
+    {
+        powerLost = false;
+        budget = -1;
+    }
+
+private:
+    std::vector<uint8_t> files[JOURNAL_FILES];
+    bool exists[JOURNAL_FILES] = {};
+
+    /**
+     * Write bytes at the end of a file, up to the power budget
+     */
+    bool program(std::vector<uint8_t> &file, const uint8_t *data, size_t length)
+    {
+        size_t writable = length;
+        if (budget >= 0 && (long)length > budget)
+        {
+            writable = budget;
+            powerLost = true;
+        }
+        if (writable > 0)
+        {
+            size_t first = file.size() / FLASH_PAGE_BYTES;
+            size_t last = (file.size() + writable - 1) / FLASH_PAGE_BYTES;
+            pagesProgrammed += last - first + 1;
+        }
+        file.insert(file.end(), data, data + writable);
+        bytesWritten += writable;
+        if (budget >= 0)
+            budget -= writable;
+        return writable == length;
+    }
+};
+
+/**
+ * Check that two saved games match
+ */
+static bool sameGame(const SavedGame &a, const SavedGame &b)
+{
+    return a.board.size() == b.board.size() && memcmp(a.board.cells, b.board.cells, sizeof(a.board.cells)) == 0 &&
+           a.board.seed == b.board.seed && a.config.isExtension == b.config.isExtension &&
+           a.config.eightSixCanTouch == b.config.eightSixCanTouch &&
+           a.config.twoTwelveCanTouch == b.config.twoTwelveCanTouch &&
+           a.config.sameNumbersCanTouch == b.config.sameNumbersCanTouch &&
+           a.config.sameResourceCanTouch == b.config.sameResourceCanTouch &&
+           a.config.minBalance == b.config.minBalance && a.manualDice == b.manualDice &&
+           a.gameStarted == b.gameStarted && a.selectedNumber == b.selectedNumber;
+}
+
+/**
+ * Check that two roll histories match, statistics included
+ */
+static bool sameRolls(const RollHistory &a, const RollHistory &b)
+{
+    uint8_t statsA[ROLL_STATS_BYTES], statsB[ROLL_STATS_BYTES];
+    a.encodeStats(statsA);
+    b.encodeStats(statsB);
+    if (a.rolls() != b.rolls() || a.size() != b.size() || memcmp(statsA, statsB, sizeof(statsA)) != 0)
+        return false;
+    for (int i = 0; i < a.size(); i++)
+    {
+        if (a.entry(i).pack() != b.entry(i).pack())
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Roll number i of the game (repeatable); every seventh is picked by hand
+ */
+static RollEntry rollAt(uint32_t seed, int i)
+{
+    uint32_t x = seed ^ (uint32_t)i * 0x9E3779B9u;
+    x ^= x >> 16;
+    x *= 0x85EBCA6Bu;
+    x ^= x >> 13;
+    RollEntry entry;
+    entry.seconds = 30 * i;
+    entry.die1 = 1 + (x >> 8) % 6;
+    entry.die2 = 1 + (x >> 20) % 6;
+    entry.number = entry.die1 + entry.die2;
+    entry.manual = i % 7 == 3;
+    if (entry.manual)
+        entry.die1 = entry.die2 = 0;
+    return entry;
+}
+
+/**
+ * Rolls saved together at a step of the game: usually one, and a burst
+ * of three now and then, as the firmware coalesces quick taps
+ */
+static int rollsAtStep(int step)
+{
+    return step % 25 == 24 ? 3 : 1;
+}
+
+/**
+ * Game after a number of saves: the start, then one step of rolls per save
+ *
+ * @param start Game as started
+ * @param seed Seed of the rolls
+ * @param saves Completed saves, the start included
+ * @param game Output game
+ * @param history Output rolls of the game
+ */
+static void gameAfter(const SavedGame &start, uint32_t seed, int saves, SavedGame &game, RollHistory &history)
+{
+    game = start;
+    history.clear();
+    int roll = 0;
+    for (int step = 0; step < saves - 1; step++)
+    {
+        for (int i = 0; i < rollsAtStep(step); i++)
+        {
+            RollEntry entry = rollAt(seed, roll++);
+            history.record(entry);
+            game.selectedNumber = entry.number;
+        }
+    }
+}
+
+/**
+ * Play a game on a flash: start it, then roll
+ *
+ * @param journal Journal to save through
+ * @param start Game as started
+ * @param seed Seed of the rolls
+ * @param steps Number of saves after the start
+ * @param flash Flash under the journal
+ * @return Number of saves that completed before the power was lost
+ */
+static int playGame(GameJournal &journal, const SavedGame &start, uint32_t seed, int steps, SimFlash &flash)
+{
+    SavedGame game = start;
+    RollHistory history;
+    journal.saveSnapshot(game, history);
+    if (flash.powerLost)
+        return 0;
+
+    int roll = 0;
+    for (int step = 0; step < steps; step++)
+    {
+        RollEntry entries[3];
+        int count = rollsAtStep(step);
+        for (int i = 0; i < count; i++)
+        {
+            entries[i] = rollAt(seed, roll++);
+            history.record(entries[i]);
+        }
+        game.selectedNumber = entries[count - 1].number;
+        journal.saveRolls(game, history, entries, count);
+        if (flash.powerLost)
+            return step + 1;
+    }
+    return steps + 1;
+}
+
+/**
+ * Play a short game, then start a new one with its first rolls in the
+ * same batch: a fresh history holding them is written with the snapshot,
+ * as GameSaver::write does when rolls follow GAME_SAVE_CLEAR |
+ * GAME_SAVE_SNAPSHOT
+ *
+ * @param journal Journal to save through
+ * @param start Old game as started
+ * @param next New game as started
+ * @param seed Seed of the rolls (the new game uses seed + 1)
+ * @param flash Flash under the journal
+ * @return Number of saves that completed before the power was lost,
+ *         OLD_GAME_SAVES + 2 once the new game is on flash
+ */
+static int playNewGame(GameJournal &journal, const SavedGame &start, const SavedGame &next, uint32_t seed,
+                       SimFlash &flash)
+{
+    int saves = playGame(journal, start, seed, OLD_GAME_SAVES, flash);
+    if (flash.powerLost)
+        return saves;
+
+    SavedGame game = next;
+    RollHistory history;
+    for (int i = 0; i < NEW_GAME_ROLLS; i++)
+    {
+        RollEntry entry = rollAt(seed + 1, i);
+        history.record(entry);
+        game.selectedNumber = entry.number;
+    }
+    journal.saveSnapshot(game, history);
+    return flash.powerLost ? saves : saves + 1;
+}
+
+/**
+ * Check what a journal holds after a power cut around a new game
+ *
+ * @param flash Flash after the cut, powered again
+ * @param start Old game as started
+ * @param next New game as started
+ * @param seed Seed of the rolls
+ * @param saves Saves that completed before the cut
+ * @return True if the journal holds the last completed save
+ */
+static bool checkNewGame(SimFlash &flash, const SavedGame &start, const SavedGame &next, uint32_t seed, int saves)
+{
+    GameJournal journal(flash);
+    SavedGame loaded;
+    RollHistory loadedRolls;
+    if (!journal.load(loaded, loadedRolls))
+        return saves == 0;
+
+    SavedGame expected;
+    RollHistory expectedRolls;
+    if (saves <= OLD_GAME_SAVES + 1)
+        gameAfter(start, seed, saves, expected, expectedRolls);
+    else
+    {
+        expected = next;
+        expectedRolls.clear();
+        for (int i = 0; i < NEW_GAME_ROLLS; i++)
+        {
+            RollEntry entry = rollAt(seed + 1, i);
+            expectedRolls.record(entry);
+            expected.selectedNumber = entry.number;
+        }
+    }
+    return sameGame(loaded, expected) && sameRolls(loadedRolls, expectedRolls);
+}
+
+int main(int argc, char **argv)
+{
+    int steps = DEFAULT_SAVES;
+    uint32_t seed = 1;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--saves") == 0 && i + 1 < argc)
+            steps = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+            seed = strtoul(argv[++i], nullptr, 16);
+        else
+        {
+            printf("Usage: %s [--saves N] [--seed HEX]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (steps < 1)
+        steps = 1;
+
+    SavedGame start;
+    start.config.isExtension = true;
+    start.config.minBalance = 50;
+    start.board = generateBoard(start.config, seed, nullptr);
+    start.manualDice = false;
+    start.gameStarted = true;
+    start.selectedNumber = 0;
+
+    // Write amplification of a whole game
+    SimFlash flash;
+    GameJournal journal(flash);
+    playGame(journal, start, seed, steps, flash);
+    uint64_t totalBytes = flash.bytesWritten;
+    SavedGame expected;
+    RollHistory expectedRolls;
+    gameAfter(start, seed, steps + 1, expected, expectedRolls);
+    uint32_t rolls = expectedRolls.rolls();
+
+    char json[GAME_STATE_JSON_SIZE];
+    BoardIndex index;
+    index.build(start.board);
+    GameState state = {&start.board, &start.config, true, false, 12, index.balance()};
+    size_t jsonBytes = writeGameStateJson(state, json, sizeof(json));
+    size_t jsonPages = (jsonBytes + FLASH_PAGE_BYTES - 1) / FLASH_PAGE_BYTES;
+
+    printf("Game of %lu rolls in %d saves on the extension board\n", (unsigned long)rolls, steps);
+    printf("  journal: %llu bytes, %llu pages, %lu journals started\n", (unsigned long long)flash.bytesWritten,
+           (unsigned long long)flash.pagesProgrammed, (unsigned long)journal.compactions());
+    printf("  per save: journal %.1f bytes / %.2f pages, JSON rewrite %lu bytes / %lu pages (%.0fx fewer bytes)\n",
+           (double)flash.bytesWritten / steps, (double)flash.pagesProgrammed / steps, (unsigned long)jsonBytes,
+           (unsigned long)jsonPages, (double)jsonBytes * steps / flash.bytesWritten);
+
+    // Power cut at every byte of the same game
+    int failures = 0;
+    for (uint64_t cut = 0; cut < totalBytes; cut++)
+    {
+        SimFlash cutFlash;
+        cutFlash.budget = (long)cut;
+        GameJournal before(cutFlash);
+        int saves = playGame(before, start, seed, steps, cutFlash);
+
+        cutFlash.reboot();
+        GameJournal after(cutFlash);
+        SavedGame loaded;
+        RollHistory loadedRolls;
+        bool found = after.load(loaded, loadedRolls);
+        bool ok;
+        if (found)
+        {
+            gameAfter(start, seed, saves, expected, expectedRolls);
+            ok = saves > 0 && sameGame(loaded, expected) && sameRolls(loadedRolls, expectedRolls);
+        }
+        else
+            ok = saves == 0;
+
+        // The journal must take new saves after the cut
+        SavedGame game = found ? loaded : start;
+        RollHistory gameRolls = loadedRolls;
+        if (!found)
+        {
+            gameRolls.clear();
+            after.saveSnapshot(game, gameRolls);
+        }
+        for (int i = 0; i < RECOVERY_ROLLS; i++)
+        {
+            RollEntry entry = rollAt(~seed, i);
+            game.selectedNumber = entry.number;
+            gameRolls.record(entry);
+            after.saveRolls(game, gameRolls, &entry, 1);
+        }
+        GameJournal rebooted(cutFlash);
+        SavedGame reloaded;
+        RollHistory reloadedRolls;
+        ok = ok && rebooted.load(reloaded, reloadedRolls) && sameGame(reloaded, game) && sameRolls(reloadedRolls, gameRolls);
+
+        if (!ok)
+        {
+            if (failures < 10)
+                printf("  power cut after %llu bytes: game lost or corrupted\n", (unsigned long long)cut);
+            failures++;
+        }
+    }
+    printf("Power cut at each of %llu bytes: %d failures\n", (unsigned long long)totalBytes, failures);
+
+    // Power cut at every byte of a new game saved together with its first rolls
+    SavedGame next = start;
+    next.config.isExtension = false;
+    next.board = generateBoard(next.config, seed + 1, nullptr);
+    SimFlash newGameFlash;
+    GameJournal newGameJournal(newGameFlash);
+    playNewGame(newGameJournal, start, next, seed, newGameFlash);
+    uint64_t newGameBytes = newGameFlash.bytesWritten;
+    int newGameFailures = 0;
+    for (uint64_t cut = 0; cut < newGameBytes; cut++)
+    {
+        SimFlash cutFlash;
+        cutFlash.budget = (long)cut;
+        GameJournal before(cutFlash);
+        int saves = playNewGame(before, start, next, seed, cutFlash);
+        cutFlash.reboot();
+        if (!checkNewGame(cutFlash, start, next, seed, saves))
+        {
+            if (newGameFailures < 10)
+                printf("  power cut after %llu bytes: new game mixed with the old one\n", (unsigned long long)cut);
+            newGameFailures++;
+        }
+    }
+    printf("Power cut at each of %llu bytes around a new game: %d failures\n", (unsigned long long)newGameBytes,
+           newGameFailures);
+    return failures == 0 && newGameFailures == 0 ? 0 : 1;
+}
@@ -31,21 +31,51 @@
 
 // Internal Project Headers
 #include "BoardGenerator.h"
+#include "BoardMap.h"
+#include "BoardBatch.h"
+#include "BoardIndex.h"
 #include "WebPage.h"
 #include "LedController.h"
+#include "LedIndex.h"
 #include "HomeAssistantTrigger.h"
+#include "BoardPool.h"
+#include "GameStateJson.h"
+#include "StatePush.h"
+#include "GameJournal.h"
+#include "SpiffsJournalStorage.h"
+#include "GameSaver.h"
+#include "RollHistory.h"
 
 // Uncomment to enable Home Assistant integration
 // #define ENABLE_HOME_ASSISTANT
 
 // Configuration for background task handling
-#define BOARD_GEN_STACK_SIZE 8192 // Stack size for board generation task
-#define BOARD_GEN_TASK_PRIORITY 1 // Priority level for the task
-#define BOARD_GEN_TASK_CORE 1     // Core to run the task on (ESP32 has 2 cores)
+#define BOARD_GEN_STACK_SIZE BOARD_SOLVER_STACK_SIZE // Stack size for board generation tasks
+
+#define BOARD_GEN_TASK_PRIORITY 1  // Priority level for the task
+#define BOARD_GEN_TASK_CORE 1      // Core to run the task on (ESP32 has 2 cores)
+#define BOARD_JOB_QUEUE_LENGTH 2   // Finished jobs waiting to be collected by loop()
+#define BOARD_GEN_WORKERS 2        // Searches raced per board, one on each core (1 to disable)
+#define BATCH_MAX_BOARDS 500       // Most boards in one /batch pack
+#define BATCH_DEFAULT_BOARDS 20    // Boards in a /batch pack without a "count" argument
+#define BATCH_QUEUE_LENGTH 4       // Formatted lines waiting to be sent to the /batch client
+#define BATCH_LINES_PER_LOOP 2     // Pack lines sent per loop() pass, so other clients and the LEDs keep going
+#define BATCH_SEND_WAIT_MS 50      // Time a full queue is waited for before the task checks for a cancelled pack
+#define STATE_ETAG_SIZE 24         // Quoted "<boot id>-<version>" ETag of the game state
+#define STATE_CHANGE_NUMBER 1      // Selected number changed (pushed as a "number" event)
+#define STATE_CHANGE_GAME 2        // Game started or ended (pushed as a "game" event)
+#define STATE_CHANGE_FULL 4        // Board or settings changed (pushed as a full "state" event)
+#define STATE_HISTORY_LENGTH 16    // Recent state versions whose changes /getboard can send as a delta
+#define STATE_DELTA_SIZE 64        // Buffer for the JSON of a delta
+#define GAME_SAVE_COALESCE_MS 250  // Quiet time after a change before it is written to flash
+#define GAME_SAVE_BOUND_MS 2000    // Longest a change waits for flash, i.e. the most a power loss can undo
+#define GAME_SAVE_FLUSH_MS 1000    // Longest a handler waits for a flush
+#define HISTORY_CHUNK_SIZE 1024    // Buffer of /history text sent as one chunk (at least ROLL_HISTORY_STATS_SIZE)
 
 // Global State Variables
-volatile bool boardReady = true; // Indicates if board generation is complete
-bool gameLoaded = false;         // Indicates if a saved game was loaded
+bool gameLoaded = false;       // Indicates if a saved game was loaded
+bool hasRequestedSeed = false; // Should the next board be regenerated from requestedSeed?
+uint64_t requestedSeed = 0;    // Seed of a shared board to reproduce
 
 // WiFi Credentials
 // Note: These are placeholders. Create a password.h if you want to help in the development.
@@ -82,6 +112,11 @@ const char *HA_ACCESS_TOKEN = "your_long_lived_access_token";
 // Initialize LED controller
 LedController ledController(LED_STRIP_PIN, LED_COUNT_CLASSIC);
 
+// Scenario maps replacing the built-in boards (see BoardMap.h and tools/compile_map.py)
+#define MAP_PATH_CLASSIC "/maps/classic.bin"     // Map file replacing the classic board
+#define MAP_PATH_EXTENSION "/maps/extension.bin" // Map file replacing the extension board
+LedLayout mapLedLayouts[2];                      // LED tables of the loaded maps
+
 // Currently selected dice number (2-12, 0 means none selected)
 int selectedNumber;
 
@@ -90,6 +125,7 @@ int selectedNumber;
 #define DEFAULT_TWO_TWELVE_CANTOUCH true   // Can 2 & 12 tokens be adjacent?
 #define DEFAULT_SAMENUMBERS_CANTOUCH true  // Can identical token numbers be adjacent?
 #define DEFAULT_SAMERESOURCE_CANTOUCH true // Can identical resources be adjacent?
+#define DEFAULT_MIN_BALANCE 0              // Lowest balance score (0-100) of generated boards
 #define DEFAULT_MANUAL_DICE false          // Allow manual dice number selection?
 #define DEFAULT_IS_EXTENSION false         // Start in extension mode?
 
@@ -103,100 +139,479 @@ String htmlPage;      // Stores the HTML content
 
 // Catan Game Data
 Board board;             // Current board layout
+BoardIndex boardIndex;   // Hexes of the board by number and resource, rebuilt with the board
 BoardConfig boardConfig; // Board configuration settings
+BoardPool boardPool;     // Pre-generated boards for quick shuffles
+
+// Game Persistence (see GameJournal.h)
+#define LEGACY_STATE_PATH "/gamestate.json"  // Game state file of older firmware, read once to migrate
+SpiffsJournalStorage journalStorage;           // Journal files on SPIFFS
+GameJournal gameJournal(journalStorage);       // Snapshot plus one record per selected number
+RollHistory rollHistory;                       // Rolls of the current or last game (see /history), recorded by gameSaver
+GameSaver gameSaver(gameJournal, rollHistory); // Writes the journal off the HTTP path
+uint32_t playSecondsBase = 0;                  // Seconds of play before playClockStart
+unsigned long playClockStart = 0;              // millis() when the play clock last started
+
+// Game State Snapshot (only touched by the loop task)
+uint32_t stateVersion = 1;            // Bumped by markStateChanged()
+uint32_t bootId = 0;                  // Random per boot, part of the ETag
+char stateJson[GAME_STATE_JSON_SIZE]; // Cached JSON of the game state
+size_t stateJsonLength = 0;           // Length of the cached JSON
+uint32_t stateJsonVersion = 0;        // State version of the cached JSON, 0 for none
+uint8_t stateHistory[STATE_HISTORY_LENGTH]; // STATE_CHANGE_* bits of each recent version, by version % length
+StatePush statePush;                  // Pages following the state over /events
+uint8_t pendingChanges = 0;           // STATE_CHANGE_* bits not pushed yet
+unsigned long pendingSince = 0;       // micros() of the oldest change not pushed yet
+
+/**
+ * Board generation job
+ * Submitted by a shuffle request, run by boardGenerationTask and
+ * collected by loop()
+ */
+struct BoardJob
+{
+  uint32_t id;        // Generation id, increases with every request
+  BoardConfig config; // Rules and board size to generate with
+  bool hasSeed;       // Reproduce the board of "seed"?
+  uint64_t seed;      // Seed of a shared board
+  Board board;        // Generated board
+};
+
+// Board Generation Jobs
+QueueHandle_t finishedJobs;     // Jobs handed back by boardGenerationTask
+BoardJob *queuedJob = NULL;     // Job waiting for the running one to finish
+bool jobRunning = false;        // Is a generation task busy?
+uint32_t latestJobId = 0;       // Id of the newest requested board; older results are stale
+uint32_t boardJobId = 0;        // Id of the job that produced the current board
+uint32_t failedJobId = 0;       // Id of the last job that found no board for its rules
 
 //---------------------------------------------------------------
 //                 UTILITY FUNCTIONS
 //---------------------------------------------------------------
 
 /**
- * Creates a JSON representation of the current game state
+ * Formats a board seed as a 16-digit hexadecimal string
+ * (JSON numbers cannot hold all 64 bits in JavaScript)
  *
- * @return String containing JSON data with board configuration,
- *         resource placement, number tokens, and game settings
+ * @param seed 64-bit board seed
+ * @return Hexadecimal representation of the seed
  */
-String generateJSON()
+String formatSeed(uint64_t seed)
 {
-  // Create a JSON document
-  JsonDocument doc;
-  int ledNumber;
+  char buffer[17];
+  snprintf(buffer, sizeof(buffer), "%08lx%08lx", (unsigned long)(seed >> 32), (unsigned long)(seed & 0xFFFFFFFF));
+  return String(buffer);
+}
+
+/**
+ * Parses a hexadecimal board seed
+ *
+ * @param text Hexadecimal seed string
+ * @return 64-bit board seed
+ */
+uint64_t parseSeed(const String &text)
+{
+  return strtoull(text.c_str(), nullptr, 16);
+}
 
-  // Determine number of hexes/LEDs based on board mode
-  if (!boardConfig.isExtension)
+/**
+ * Marks the game state as changed
+ * Must be called by everything that changes what /getboard returns,
+ * so the cached snapshot is rebuilt, clients see a new ETag and the
+ * change is pushed to open pages by pushStateChanges()
+ *
+ * @param change STATE_CHANGE_* bit describing what changed
+ */
+void markStateChanged(uint8_t change)
+{
+  stateVersion++;
+  stateHistory[stateVersion % STATE_HISTORY_LENGTH] = change;
+  if (pendingChanges == 0)
   {
-    ledNumber = LED_COUNT_CLASSIC;
+    pendingSince = micros();
   }
-  else
+  pendingChanges |= change;
+}
+
+/**
+ * Returns the JSON representation of the current game state
+ * (board, game mode, settings, selected number and seed)
+ * The document is only encoded again after markStateChanged()
+ *
+ * @param length Output length of the JSON text
+ * @return Cached JSON text, valid until the state changes
+ */
+const char *stateSnapshot(size_t &length)
+{
+  if (stateJsonVersion != stateVersion)
   {
-    ledNumber = LED_COUNT_EXTENSION;
+    GameState state = {&board, &boardConfig, gameStarted, manualDice, selectedNumber, boardIndex.balance()};
+    stateJsonLength = writeGameStateJson(state, stateJson, sizeof(stateJson));
+    if (stateJsonLength >= sizeof(stateJson))
+    {
+      Serial.println("Game state JSON truncated, GAME_STATE_JSON_SIZE is too small");
+      stateJsonLength = sizeof(stateJson) - 1;
+    }
+    stateJsonVersion = stateVersion;
   }
+  length = stateJsonLength;
+  return stateJson;
+}
+
+/**
+ * Formats the ETag of the current game state: boot id and state version
+ * The boot id keeps a tag from before a restart from matching a new state
+ *
+ * @param buffer Output buffer, STATE_ETAG_SIZE bytes
+ */
+void formatStateETag(char *buffer)
+{
+  snprintf(buffer, STATE_ETAG_SIZE, "\"%08lx-%lx\"", (unsigned long)bootId, (unsigned long)stateVersion);
+}
 
-  // Add the resources array
-  JsonArray resources = doc["resources"].to<JsonArray>();
-  for (int i = 0; i < ledNumber; i++)
+/**
+ * Collects what changed since a version a client has seen
+ *
+ * @param tag ETag the client received with that version, quotes optional
+ * @param changes Output STATE_CHANGE_* bits of every later version
+ * @return False if the tag is from another boot or too old for the history
+ */
+bool changesSince(const String &tag, uint8_t &changes)
+{
+  unsigned long tagBoot, tagVersion;
+  const char *text = tag.c_str();
+  if (*text == '"')
+  {
+    text++;
+  }
+  if (sscanf(text, "%lx-%lx", &tagBoot, &tagVersion) != 2 || tagBoot != bootId || tagVersion > stateVersion ||
+      stateVersion - tagVersion > STATE_HISTORY_LENGTH)
   {
-    resources.add(board.resources[i]);
+    return false;
   }
 
-  // Add the numbers array
-  JsonArray numbers = doc["numbers"].to<JsonArray>();
-  for (int i = 0; i < ledNumber; i++)
+  changes = 0;
+  for (uint32_t version = tagVersion + 1; version <= stateVersion; version++)
   {
-    numbers.add(board.numbers[i]);
+    changes |= stateHistory[version % STATE_HISTORY_LENGTH];
   }
+  return true;
+}
 
-  // Include the game mode and state flags
-  doc["extension"] = boardConfig.isExtension;
-  doc["gameStarted"] = gameStarted;
+/**
+ * Formats the fields touched by number and game changes
+ * {"delta":true,"selectedNumber":N}, plus "gameStarted" after a game change
+ *
+ * @param changes STATE_CHANGE_* bits, without STATE_CHANGE_FULL
+ * @param buffer Output buffer, STATE_DELTA_SIZE bytes
+ * @return Length of the JSON
+ */
+int formatStateDelta(uint8_t changes, char *buffer)
+{
+  if (changes & STATE_CHANGE_GAME)
+  {
+    return snprintf(buffer, STATE_DELTA_SIZE, "{\"delta\":true,\"gameStarted\":%s,\"selectedNumber\":%d}",
+                    gameStarted ? "true" : "false", selectedNumber);
+  }
+  return snprintf(buffer, STATE_DELTA_SIZE, "{\"delta\":true,\"selectedNumber\":%d}", selectedNumber);
+}
 
-  // Include the game settings
-  doc["eightSixCanTouch"] = boardConfig.eightSixCanTouch;
-  doc["twoTwelveCanTouch"] = boardConfig.twoTwelveCanTouch;
-  doc["sameNumbersCanTouch"] = boardConfig.sameNumbersCanTouch;
-  doc["sameResourceCanTouch"] = boardConfig.sameResourceCanTouch;
-  doc["manualDice"] = manualDice;
+/**
+ * Sends game state JSON (whole or delta) with the ETag of the current version
+ * The length is known up front, so the body goes out straight from its buffer
+ *
+ * @param json JSON text
+ * @param length Length of the text
+ */
+void sendStateJson(const char *json, size_t length)
+{
+  char etag[STATE_ETAG_SIZE];
+  formatStateETag(etag);
+
+  server.sendHeader("ETag", etag);
+  server.sendHeader("Cache-Control", "no-cache");
+  server.setContentLength(length);
+  server.send(200, "application/json", "");
+  server.sendContent(json, length);
+}
 
-  // Include currently selected number
-  doc["selectedNumber"] = selectedNumber;
+/**
+ * Sends the current game state snapshot with its ETag
+ */
+void sendGameState()
+{
+  size_t length;
+  const char *json = stateSnapshot(length);
+  sendStateJson(json, length);
+}
 
-  // Serialize the JSON document to a string
-  String jsonResponse;
-  serializeJson(doc, jsonResponse);
+/**
+ * Pushes the changes made since the last call to every open page, called from loop()
+ * Changes made within one loop pass go out as a single event: the
+ * selected number or the game flags alone when nothing else changed,
+ * the whole state otherwise
+ */
+void pushStateChanges()
+{
+  statePush.keepAlive();
+  if (pendingChanges == 0)
+  {
+    return;
+  }
+
+  if (statePush.subscribers() > 0)
+  {
+    if (pendingChanges & STATE_CHANGE_FULL)
+    {
+      size_t length;
+      const char *json = stateSnapshot(length);
+      statePush.broadcast(stateVersion, "state", json, length, pendingSince);
+    }
+    else
+    {
+      char delta[STATE_DELTA_SIZE];
+      int length = formatStateDelta(pendingChanges, delta);
+      const char *event = (pendingChanges & STATE_CHANGE_GAME) ? "game" : "number";
+      statePush.broadcast(stateVersion, event, delta, length, pendingSince);
+    }
+  }
+  pendingChanges = 0;
+}
 
-  return jsonResponse;
+/**
+ * Collects the parts of the game state that survive a reboot
+ *
+ * @return Game in progress, as stored by the journal
+ */
+SavedGame savedGame()
+{
+  SavedGame game;
+  game.board = board;
+  game.config = boardConfig;
+  game.manualDice = manualDice;
+  game.gameStarted = gameStarted;
+  game.selectedNumber = (uint8_t)selectedNumber;
+  return game;
 }
 
 /**
  * Saves the current game state to the ESP32's flash memory
  * This allows persisting the game through power cycles
+ * The save task starts a new journal holding the whole game
  */
 void saveGameState()
 {
-  // Generate the json data
-  String jsonString = generateJSON();
+  gameSaver.markDirty(savedGame(), GAME_SAVE_SNAPSHOT);
+}
 
-  // Write to SPIFFS (SPI Flash File System)
-  File file = SPIFFS.open("/gamestate.json", FILE_WRITE);
-  if (!file)
+/**
+ * Saves a newly started game to flash memory
+ * Starts a fresh roll history; the new journal replaces the one of the
+ * last game, roll history included
+ */
+void saveNewGame()
+{
+  gameSaver.markDirty(savedGame(), GAME_SAVE_CLEAR | GAME_SAVE_SNAPSHOT);
+}
+
+/**
+ * Saves a newly selected number to flash memory
+ * A burst of numbers settles into one journal record
+ */
+void saveSelectedNumber()
+{
+  gameSaver.markDirty(savedGame(), GAME_SAVE_NUMBER);
+}
+
+/**
+ * Seconds of play since the game started
+ * Time while the board was off does not count
+ */
+uint32_t playSeconds()
+{
+  return playSecondsBase + (millis() - playClockStart) / 1000;
+}
+
+/**
+ * Records the new selected number
+ * During a game it joins the roll history and the journal as a roll;
+ * otherwise only the number is saved
+ *
+ * @param die1 First die, 0 if the number was picked by hand
+ * @param die2 Second die, 0 if the number was picked by hand
+ */
+void recordRoll(int die1, int die2)
+{
+  if (!gameStarted || selectedNumber < 2 || selectedNumber > 12)
   {
-    Serial.println("Failed to open file for writing");
+    saveSelectedNumber();
     return;
   }
-  file.print(jsonString);
-  file.close();
-  Serial.println("Game state saved to flash.");
+
+  RollEntry entry;
+  entry.seconds = playSeconds();
+  entry.number = selectedNumber;
+  entry.die1 = die1;
+  entry.die2 = die2;
+  entry.manual = (die1 == 0);
+  gameSaver.markRoll(savedGame(), entry);
 }
 
 /**
  * Deletes any saved game state from flash memory
+ * Waits for the save task, so an ended game cannot come back after a reboot
  */
 void deleteGameState()
 {
-  if (SPIFFS.exists("/gamestate.json"))
+  gameSaver.markDirty(savedGame(), GAME_SAVE_CLEAR);
+  if (!gameSaver.flush(GAME_SAVE_FLUSH_MS))
   {
-    SPIFFS.remove("/gamestate.json");
-    Serial.println("Game state deleted from flash.");
+    Serial.println("Timed out deleting the game journal");
   }
+  if (SPIFFS.exists(LEGACY_STATE_PATH))
+  {
+    SPIFFS.remove(LEGACY_STATE_PATH);
+  }
+  Serial.println("Game state deleted from flash.");
+}
+
+/**
+ * Loads the scenario maps stored in flash memory
+ * A valid map replaces the classic or extension board until the next boot
+ */
+void loadBoardMaps()
+{
+  for (int slot = 0; slot < 2; slot++)
+  {
+    bool isExtension = (slot == 1);
+    const char *path = isExtension ? MAP_PATH_EXTENSION : MAP_PATH_CLASSIC;
+    if (!SPIFFS.exists(path))
+    {
+      continue;
+    }
+
+    File file = SPIFFS.open(path, FILE_READ);
+    if (!file)
+    {
+      Serial.println("Failed to open map file for reading");
+      continue;
+    }
+    uint8_t data[BOARD_MAP_MAX_BYTES];
+    size_t size = file.size();
+    bool fits = size <= sizeof(data);
+    if (fits)
+    {
+      size = file.read(data, size);
+    }
+    file.close();
+
+    Serial.print(path);
+    if (!fits || !installBoardMap(isExtension, data, size))
+    {
+      Serial.println(" is not a valid board map, using the built-in board");
+      continue;
+    }
+    const BoardMap *map = loadedBoardMap(isExtension);
+    mapLedLayouts[slot] = {(uint16_t)map->hexCount, map->tileToLed, map->tileToLed, map->adjacency};
+    Serial.print(" loaded: ");
+    Serial.print(map->hexCount);
+    Serial.println(" hexes");
+  }
+}
+
+/**
+ * Task that checks whether the loaded maps have boards at all
+ * Runs once after boot with the solver's stack, so setup() only checks
+ * the structure of the map files. A map without a board under the
+ * loosest rules can never be played; one without a board under the
+ * default (strictest) rules needs some rules relaxed. Shuffles on such
+ * a map answer 422 either way; this only tells the log why.
+ *
+ * @param parameter Unused
+ */
+void mapCheckTask(void *parameter)
+{
+  for (int slot = 0; slot < 2; slot++)
+  {
+    bool isExtension = (slot == 1);
+    if (loadedBoardMap(isExtension) == nullptr)
+    {
+      continue;
+    }
+    const char *path = isExtension ? MAP_PATH_EXTENSION : MAP_PATH_CLASSIC;
+
+    BoardConfig loosest;
+    loosest.isExtension = isExtension;
+    loosest.eightSixCanTouch = true;
+    loosest.twoTwelveCanTouch = true;
+    loosest.sameNumbersCanTouch = true;
+    loosest.sameResourceCanTouch = true;
+    BoardConfig strictest;
+    strictest.isExtension = isExtension;
+    GenerationStats stats;
+
+    if (generateBoard(loosest, (uint64_t)1).empty())
+    {
+      Serial.print("Warning: ");
+      Serial.print(path);
+      Serial.println(" has no board under any rules");
+    }
+    else if (generateBoard(strictest, (uint64_t)1, &stats).empty())
+    {
+      Serial.print("Warning: ");
+      Serial.print(path);
+      Serial.println(stats.infeasible ? " has no board under the strictest rules"
+                                      : " may have no board under the strictest rules");
+    }
+  }
+  vTaskDelete(NULL);
+}
+
+/**
+ * Starts mapCheckTask if a map was loaded
+ */
+void startMapCheck()
+{
+  if (loadedBoardMap(false) == nullptr && loadedBoardMap(true) == nullptr)
+  {
+    return;
+  }
+  xTaskCreatePinnedToCore(
+      mapCheckTask,         // Task function
+      "MapCheckTask",       // Task name
+      BOARD_GEN_STACK_SIZE, // Stack size (bytes)
+      NULL,                 // Parameters
+      0,                    // Idle priority, after the first board
+      NULL,                 // Task handle
+      BOARD_GEN_TASK_CORE   // Run on core 1
+  );
+}
+
+/**
+ * Length of the LED strip for a board size
+ *
+ * @param isExtension Board size
+ * @return LED count of the loaded map, or of the built-in board
+ */
+uint16_t boardLedCount(bool isExtension)
+{
+  const BoardMap *map = loadedBoardMap(isExtension);
+  if (map != nullptr)
+  {
+    return map->ledCount;
+  }
+  return isExtension ? LED_COUNT_EXTENSION : LED_COUNT_CLASSIC;
+}
+
+/**
+ * LED tables for a board size
+ *
+ * @param isExtension Board size
+ * @return Tables of the loaded map, or nullptr for the built-in board
+ */
+const LedLayout *boardLedLayout(bool isExtension)
+{
+  return loadedBoardMap(isExtension) != nullptr ? &mapLedLayouts[isExtension ? 1 : 0] : nullptr;
 }
 
 /**
@@ -205,10 +620,27 @@ void deleteGameState()
 void loadGameState()
 {
   Serial.print("Load Start!");
-  if (SPIFFS.exists("/gamestate.json"))
+  SavedGame game;
+  if (gameJournal.load(game, rollHistory))
+  {
+    boardConfig = game.config;
+    manualDice = game.manualDice;
+    gameStarted = game.gameStarted;
+    selectedNumber = game.selectedNumber;
+    board = game.board;
+    playSecondsBase = rollHistory.lastSeconds();
+    playClockStart = millis();
+    Serial.print("Game state replayed from journal, ");
+    Serial.print(gameJournal.size());
+    Serial.print(" bytes, ");
+    Serial.print(rollHistory.rolls());
+    Serial.println(" rolls.");
+  }
+  else if (SPIFFS.exists(LEGACY_STATE_PATH))
   {
+    // Game saved by older firmware: load it once, then move it to the journal
     Serial.print("Gamestate.json exists");
-    File file = SPIFFS.open("/gamestate.json", FILE_READ);
+    File file = SPIFFS.open(LEGACY_STATE_PATH, FILE_READ);
     if (!file)
     {
       Serial.println("Failed to open game state file for reading");
@@ -235,27 +667,28 @@ void loadGameState()
     boardConfig.twoTwelveCanTouch = doc["twoTwelveCanTouch"];
     boardConfig.sameNumbersCanTouch = doc["sameNumbersCanTouch"];
     boardConfig.sameResourceCanTouch = doc["sameResourceCanTouch"];
+    boardConfig.minBalance = doc["minBalance"] | DEFAULT_MIN_BALANCE;
     manualDice = doc["manualDice"];
 
     gameStarted = doc["gameStarted"];
     selectedNumber = doc["selectedNumber"];
+    board.seed = parseSeed(doc["seed"] | "0");
 
     // Load board resources and numbers
-    board.resources.clear();
-    board.numbers.clear();
-
     JsonArray resources = doc["resources"].as<JsonArray>();
-    for (JsonVariant v : resources)
+    JsonArray numbers = doc["numbers"].as<JsonArray>();
+    board.reset(std::min(resources.size(), numbers.size()));
+    for (int hex = 0; hex < board.size(); hex++)
     {
-      board.resources.push_back(v.as<int>());
+      board.setHex(hex, resources[hex].as<int>(), numbers[hex].as<int>());
     }
+    Serial.println("Game state loaded from flash.");
 
-    JsonArray numbers = doc["numbers"].as<JsonArray>();
-    for (JsonVariant v : numbers)
+    saveGameState();
+    if (gameSaver.flush(GAME_SAVE_FLUSH_MS))
     {
-      board.numbers.push_back(v.as<int>());
+      SPIFFS.remove(LEGACY_STATE_PATH);
     }
-    Serial.println("Game state loaded from flash.");
   }
   else
   {
@@ -267,52 +700,274 @@ void loadGameState()
 //                  SERVER HANDLER FUNCTIONS
 // --------------------------------------------------------------
 
+/**
+ * Moves a freshly generated board into place
+ * Reinitializes the LED strip when the board size changed
+ *
+ * @param newBoard Generated board
+ * @param isExtension Board size the new board was generated for
+ */
+void applyBoard(const Board &newBoard, bool isExtension)
+{
+  if (boardConfig.isExtension != isExtension)
+  {
+    boardConfig.isExtension = isExtension;
+    ledController.restart(boardLedCount(isExtension), boardLedLayout(isExtension));
+  }
+  board = newBoard;
+  boardIndex.build(board);
+  markStateChanged(STATE_CHANGE_FULL);
+}
+
 /**
  * FreeRTOS task that handles board generation in a separate thread
- * This prevents blocking the main loop during board calculation
+ * The finished job is handed back to loop() through the finishedJobs queue,
+ * so the web server keeps serving other clients meanwhile
+ *
+ * @param pvParameters Pointer to the BoardJob to run
  */
 void boardGenerationTask(void *pvParameters)
 {
-  Serial.println("Board generation task started.");
-
-  // Use the current boardConfig to generate a board
-  board = generateBoard(boardConfig);
+  BoardJob *job = (BoardJob *)pvParameters;
+  Serial.print("Board generation job started: ");
+  Serial.println(job->id);
+
+  // Generate with the job's configuration, reproducing a shared seed if requested.
+  // Fresh boards race a search on each core; the winner keeps its own seed,
+  // so it can still be shared and reproduced
+  if (job->hasSeed)
+  {
+    job->board = generateBoard(job->config, job->seed);
+  }
+  else
+  {
+    job->board = generateBoardPortfolio(job->config, BOARD_GEN_WORKERS);
+  }
 
-  // Signal that the board is ready
-  Serial.println("Board generation complete.");
-  boardReady = true;
+  // Hand the result back to the main loop
+  xQueueSend(finishedJobs, &job, portMAX_DELAY);
 
   // Delete the task when finished
   vTaskDelete(NULL);
 }
 
 /**
- * Creates a new task for board generation
+ * Creates the task that runs a board generation job
+ *
+ * @param job Job to run
  */
-void createBoardTask()
+void startBoardJob(BoardJob *job)
 {
-  // Reset flag and create the board generation task
-  if (boardReady)
+  jobRunning = true;
+  xTaskCreatePinnedToCore(
+      boardGenerationTask,     // Task function
+      "BoardGenTask",          // Task name
+      BOARD_GEN_STACK_SIZE,    // Stack size (bytes)
+      (void *)job,             // Parameters
+      BOARD_GEN_TASK_PRIORITY, // Priority
+      NULL,                    // Task handle
+      BOARD_GEN_TASK_CORE      // Run on core 1
+  );
+}
+
+/**
+ * Submits a board generation job with the current rules
+ * Only one job runs at a time; a job submitted meanwhile waits and
+ * replaces any job still waiting, since only the newest board matters
+ *
+ * @param isExtension Board size to generate
+ * @return Generation id of the job, to be collected via /getjob
+ */
+uint32_t submitBoardJob(bool isExtension)
+{
+  BoardJob *job = new BoardJob;
+  job->id = ++latestJobId;
+  job->config = boardConfig;
+  job->config.isExtension = isExtension;
+  job->hasSeed = hasRequestedSeed;
+  job->seed = requestedSeed;
+  hasRequestedSeed = false;
+
+  if (jobRunning)
+  {
+    delete queuedJob;
+    queuedJob = job;
+  }
+  else
   {
-    boardReady = false;
-    xTaskCreatePinnedToCore(
-        boardGenerationTask, // Task function
-        "BoardGenTask",      // Task name
-        8192,                // Stack size (bytes)
-        NULL,                // Parameters
-        1,                   // Priority
-        NULL,                // Task handle
-        1                    // Run on core 1
-    );
+    startBoardJob(job);
+  }
+  return job->id;
+}
+
+/**
+ * Marks every pending job as stale
+ * Their boards are discarded when they finish
+ */
+void supersedeBoardJobs()
+{
+  latestJobId++;
+  delete queuedJob;
+  queuedJob = NULL;
+}
+
+/**
+ * Collects finished generation jobs, called from loop()
+ * Only the newest job's board is applied; results of superseded
+ * jobs are dropped
+ */
+void collectBoardJobs()
+{
+  BoardJob *job;
+  while (xQueueReceive(finishedJobs, &job, 0) == pdTRUE)
+  {
+    jobRunning = false;
+    if (job->id == latestJobId && job->board.empty())
+    {
+      // The rules allow no board on this map; keep the current one
+      failedJobId = job->id;
+      Serial.print("Board generation job found no board: ");
+      Serial.println(job->id);
+    }
+    else if (job->id == latestJobId)
+    {
+      applyBoard(job->board, job->config.isExtension);
+      boardJobId = job->id;
+      Serial.print("Board generation job complete: ");
+      Serial.println(job->id);
+    }
+    else
+    {
+      Serial.print("Discarding stale board generation job: ");
+      Serial.println(job->id);
+    }
+    delete job;
 
-    // Wait until the board generation task is done
-    while (!boardReady)
+    // Run the job that was submitted while this one was busy
+    if (queuedJob != NULL)
     {
-      delay(10); // Yield to other tasks
+      BoardJob *next = queuedJob;
+      queuedJob = NULL;
+      startBoardJob(next);
     }
   }
 }
 
+/**
+ * BatchJob structure
+ *
+ * A pack of distinct boards requested through /batch
+ */
+struct BatchJob
+{
+  BoardConfig config; // Rules of every board
+  uint32_t count;     // Boards wanted
+  uint64_t seed;      // Seed of the first board
+};
+
+QueueHandle_t batchLines = NULL;      // Formatted /batch lines, an empty line ends the pack
+WiFiClient batchClient;               // Connection the pack is streamed to
+bool batchStreaming = false;          // Is a pack being sent to batchClient?
+volatile bool batchRunning = false;   // Is batchGenerationTask alive?
+volatile bool batchCancelled = false; // Set when the client left; the task stops after the current board
+
+/**
+ * Queue a pack line, giving up if the pack was cancelled meanwhile
+ *
+ * @param line Formatted line, empty to end the pack
+ * @return False if the pack was cancelled
+ */
+bool queueBatchLine(const char *line)
+{
+  while (!batchCancelled)
+  {
+    if (xQueueSend(batchLines, line, pdMS_TO_TICKS(BATCH_SEND_WAIT_MS)) == pdTRUE)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Task that generates a board pack
+ * Runs with the solver's stack and pushes one formatted line per board
+ * to batchLines, then the summary line and an empty line. The queue is
+ * short, so generation waits whenever the client reads slowly, and stops
+ * after the current board once the pack is cancelled.
+ *
+ * @param parameter Pointer to the BatchJob, deleted when done
+ */
+void batchGenerationTask(void *parameter)
+{
+  BatchJob *job = (BatchJob *)parameter;
+  char line[BOARD_BATCH_LINE_SIZE];
+  unsigned long start = micros();
+
+  BoardBatch batch(job->config, job->count, job->seed);
+  Board packBoard;
+  GenerationStats stats;
+  bool sending = true;
+  while (sending && batch.next(packBoard, &stats))
+  {
+    formatBatchLine(packBoard, batch.produced() - 1, batch.canonicalHash(), stats.balance, line, sizeof(line));
+    sending = queueBatchLine(line);
+  }
+
+  if (sending)
+  {
+    formatBatchSummary(batch, (micros() - start) / 1000000.0, line, sizeof(line));
+    if (queueBatchLine(line))
+    {
+      line[0] = '\0';
+      queueBatchLine(line);
+    }
+  }
+
+  delete job;
+  batchRunning = false;
+  vTaskDelete(NULL);
+}
+
+/**
+ * Sends the lines of the pack in progress, called from loop()
+ * At most BATCH_LINES_PER_LOOP lines go out per pass. A client that
+ * disconnected cancels the pack, so the generation task stops early.
+ */
+void pumpBatch()
+{
+  if (!batchStreaming)
+  {
+    return;
+  }
+
+  if (!batchClient.connected())
+  {
+    Serial.println("[/batch] Client left, cancelling the pack");
+    batchCancelled = true;
+    batchClient.stop();
+    batchStreaming = false;
+    return;
+  }
+
+  char line[BOARD_BATCH_LINE_SIZE];
+  for (int i = 0; i < BATCH_LINES_PER_LOOP; i++)
+  {
+    if (xQueueReceive(batchLines, line, 0) != pdTRUE)
+    {
+      return;
+    }
+    if (line[0] == '\0')
+    {
+      // End of the pack: closing the connection ends the response
+      batchClient.stop();
+      batchStreaming = false;
+      return;
+    }
+    batchClient.write((const uint8_t *)line, strlen(line));
+  }
+}
+
 /**
  * Web server handler for the root path
  * Serves the main HTML page
@@ -331,6 +986,9 @@ void handleUpdateEightSixCanTouch()
   boardConfig.eightSixCanTouch = (value == "1");
   Serial.print("8 & 6 Can Touch set to: ");
   Serial.println(boardConfig.eightSixCanTouch ? "true" : "false");
+  boardPool.setConfig(boardConfig);
+  supersedeBoardJobs();
+  markStateChanged(STATE_CHANGE_FULL);
   server.send(200, "text/plain", "eightSixCanTouch updated");
 }
 
@@ -343,6 +1001,9 @@ void handleUpdateTwoTwelveCanTouch()
   boardConfig.twoTwelveCanTouch = (value == "1");
   Serial.print("2 & 12 Can Touch set to: ");
   Serial.println(boardConfig.twoTwelveCanTouch ? "true" : "false");
+  boardPool.setConfig(boardConfig);
+  supersedeBoardJobs();
+  markStateChanged(STATE_CHANGE_FULL);
   server.send(200, "text/plain", "twoTwelveCanTouch updated");
 }
 
@@ -355,6 +1016,9 @@ void handleUpdateSameNumbersCanTouch()
   boardConfig.sameNumbersCanTouch = (value == "1");
   Serial.print("Same Numbers Can Touch set to: ");
   Serial.println(boardConfig.sameNumbersCanTouch ? "true" : "false");
+  boardPool.setConfig(boardConfig);
+  supersedeBoardJobs();
+  markStateChanged(STATE_CHANGE_FULL);
   server.send(200, "text/plain", "sameNumbersCanTouch updated");
 }
 
@@ -367,9 +1031,27 @@ void handleUpdateSameResourceCanTouch()
   boardConfig.sameResourceCanTouch = (value == "1");
   Serial.print("Same Resource Can Touch set to: ");
   Serial.println(boardConfig.sameResourceCanTouch ? "true" : "false");
+  boardPool.setConfig(boardConfig);
+  supersedeBoardJobs();
+  markStateChanged(STATE_CHANGE_FULL);
   server.send(200, "text/plain", "sameResourceCanTouch updated");
 }
 
+/**
+ * Web server handler to update the minimum balance score of new boards
+ */
+void handleUpdateMinBalance()
+{
+  int value = constrain(server.arg("value").toInt(), 0, 100);
+  boardConfig.minBalance = value;
+  Serial.print("Minimum balance set to: ");
+  Serial.println(boardConfig.minBalance);
+  boardPool.setConfig(boardConfig);
+  supersedeBoardJobs();
+  markStateChanged(STATE_CHANGE_FULL);
+  server.send(200, "text/plain", "minBalance updated");
+}
+
 /**
  * Web server handler to update the "Manual Dice" setting
  */
@@ -379,79 +1061,344 @@ void handleUpdateManualDice()
   manualDice = (value == "1");
   Serial.print("Manual Dice set to: ");
   Serial.println(manualDice ? "true" : "false");
+  markStateChanged(STATE_CHANGE_FULL);
   server.send(200, "text/plain", "manualDice updated");
 }
 
 /**
- * Web server handler to set or shuffle classic board mode
+ * Reads the optional "seed" argument of a shuffle request
+ * so the next generated board reproduces a shared one
  */
-void handleSetClassic()
+void readRequestedSeed()
 {
-  Serial.println("[/setclassic] Request received. Setting game as classic");
+  hasRequestedSeed = server.hasArg("seed");
+  if (hasRequestedSeed)
+  {
+    requestedSeed = parseSeed(server.arg("seed"));
+    Serial.print("Reproducing board from seed: ");
+    Serial.println(formatSeed(requestedSeed));
+  }
+}
+
+/**
+ * Replaces the current board with a new one of the given size
+ * A pre-generated board from the pool is applied and returned right away.
+ * Otherwise a generation job is submitted and the client gets its id
+ * (HTTP 202) to collect the board from /getjob once it is ready.
+ *
+ * @param isExtension Board size to shuffle
+ */
+void shuffleBoard(bool isExtension)
+{
+  readRequestedSeed();
 
-  // Only reinitialize LED strip if it was in Extension mode before
-  if (boardConfig.isExtension)
+  if (!hasRequestedSeed)
   {
-    boardConfig.isExtension = false;
-    ledController.restart(LED_COUNT_CLASSIC);
+    BoardConfig config = boardConfig;
+    config.isExtension = isExtension;
+    boardPool.setConfig(config);
+
+    Board pooled;
+    if (boardPool.pop(isExtension, pooled))
+    {
+      Serial.println("Board taken from the pool.");
+      supersedeBoardJobs();
+      applyBoard(pooled, isExtension);
+      boardJobId = latestJobId;
+
+      // Send the JSON response
+      sendGameState();
+
+      // Debug output
+      Serial.println(stateJson);
+      return;
+    }
+    Serial.println("Board pool empty, submitting generation job.");
   }
 
-  // Generate a new board
-  createBoardTask();
+  uint32_t id = submitBoardJob(isExtension);
 
-  // Send the JSON response
-  String jsonResponse = generateJSON();
-  server.send(200, "application/json", jsonResponse);
+  JsonDocument doc;
+  doc["pending"] = true;
+  doc["job"] = id;
+  String jsonResponse;
+  serializeJson(doc, jsonResponse);
+  server.send(202, "application/json", jsonResponse);
+}
 
-  // Debug output
-  Serial.println(jsonResponse);
+/**
+ * Web server handler to set or shuffle classic board mode
+ * An optional "seed" argument regenerates a shared board
+ */
+void handleSetClassic()
+{
+  Serial.println("[/setclassic] Request received. Setting game as classic");
+  shuffleBoard(false);
 }
 
 /**
  * Web server handler to set or shuffle extension board mode
+ * An optional "seed" argument regenerates a shared board
  */
 void handleSetExtension()
 {
   Serial.println("[/setextension] Request received. Setting game as Extension");
+  shuffleBoard(true);
+}
+
+/**
+ * Web server handler to collect the result of a generation job
+ * Answers 200 with the board once job "id" was applied, 202 while it
+ * is still running, 422 if no board satisfies its rules, and 410 if a
+ * newer request or rule change superseded it
+ */
+void handleGetJob()
+{
+  uint32_t id = server.arg("id").toInt();
+
+  if (id != 0 && id == boardJobId)
+  {
+    sendGameState();
+  }
+  else if (id != 0 && id == failedJobId)
+  {
+    server.send(422, "application/json", "{\"error\":\"No board satisfies these rules\"}");
+  }
+  else if (id != 0 && id == latestJobId)
+  {
+    server.send(202, "application/json", "{\"pending\":true}");
+  }
+  else
+  {
+    server.send(410, "application/json", "{\"superseded\":true}");
+  }
+}
 
-  // Only reinitialize LED strip if it was in Classic mode before
-  if (!boardConfig.isExtension)
+/**
+ * Web server handler to get current board state
+ * A client that sends the ETag of the state it has as "since" only gets
+ * what changed during play ({"delta":true,...}) while that version is
+ * in the recent history; otherwise, or after a board or settings
+ * change, it gets the whole state. Without a board yet (the first job
+ * is still running, or no board fits the rules) the state has empty
+ * board arrays, so the page keeps polling instead of hanging.
+ */
+void handleGetBoard()
+{
+  Serial.println("[/getboard] Request received. Returning current board state.");
+  if (!gameLoaded)
   {
-    boardConfig.isExtension = true;
-    ledController.restart(LED_COUNT_EXTENSION);
+    server.send(503, "text/plain", "Starting up");
+    return;
+  }
+
+  // Nothing changed since the client's last poll
+  char etag[STATE_ETAG_SIZE];
+  formatStateETag(etag);
+  if (server.header("If-None-Match") == etag)
+  {
+    server.sendHeader("ETag", etag);
+    server.send(304);
+    return;
   }
 
-  // Generate a new board
-  createBoardTask();
+  // Only the selected number or game flags changed since the client's version
+  uint8_t changes;
+  if (server.hasArg("since") && changesSince(server.arg("since"), changes) && !(changes & STATE_CHANGE_FULL))
+  {
+    char delta[STATE_DELTA_SIZE];
+    int length = formatStateDelta(changes, delta);
+    sendStateJson(delta, length);
+    return;
+  }
 
   // Send the JSON response
-  String jsonResponse = generateJSON();
-  server.send(200, "application/json", jsonResponse);
+  sendGameState();
 
   // Debug output
-  Serial.println(jsonResponse);
+  Serial.println(stateJson);
 }
 
 /**
- * Web server handler to get current board state
+ * Web server handler to get board pool statistics
  */
-void handleGetBoard()
+void handleGetPoolStats()
 {
-  Serial.println("[/getboard] Request received. Returning current board state.");
-  // Only respond if the board has been initialized
-  if (gameLoaded)
+  JsonDocument doc;
+  doc["hits"] = boardPool.hits();
+  doc["misses"] = boardPool.misses();
+  doc["classic"] = boardPool.available(false);
+  doc["extension"] = boardPool.available(true);
+
+  String jsonResponse;
+  serializeJson(doc, jsonResponse);
+  server.send(200, "application/json", jsonResponse);
+}
+
+/**
+ * Web server handler to download a pack of distinct boards
+ * Arguments: "count" (1-BATCH_MAX_BOARDS), optional "seed" of the first
+ * board and "extension" (1 or 0, default the current board size); the
+ * current rules apply. Boards are streamed as newline-delimited JSON
+ * while they are generated, followed by a summary line. The handler
+ * only starts the pack: loop() sends it (see pumpBatch), so other
+ * requests are served meanwhile. One pack is generated at a time.
+ */
+void handleBatch()
+{
+  if (batchStreaming || batchRunning)
+  {
+    server.send(503, "text/plain", "A pack is already being generated");
+    return;
+  }
+
+  BatchJob *job = new BatchJob;
+  job->config = boardConfig;
+  if (server.hasArg("extension"))
   {
-    int totalHexes = boardConfig.isExtension ? LED_COUNT_EXTENSION : LED_COUNT_CLASSIC;
+    job->config.isExtension = (server.arg("extension") == "1");
+  }
+  long count = server.hasArg("count") ? server.arg("count").toInt() : BATCH_DEFAULT_BOARDS;
+  job->count = constrain(count, 1, BATCH_MAX_BOARDS);
+  job->seed = server.hasArg("seed") ? parseSeed(server.arg("seed")) : ((uint64_t)esp_random() << 32) | esp_random();
+
+  Serial.print("[/batch] Generating ");
+  Serial.print(job->count);
+  Serial.print(" boards from seed ");
+  Serial.println(formatSeed(job->seed));
+
+  if (batchLines == NULL)
+  {
+    batchLines = xQueueCreate(BATCH_QUEUE_LENGTH, BOARD_BATCH_LINE_SIZE);
+  }
+  // Lines a cancelled pack queued before it stopped
+  xQueueReset(batchLines);
+
+  // Answer the request here and keep the connection; the response ends
+  // when loop() closes it after the summary line
+  batchClient = server.client();
+  batchClient.setNoDelay(true);
+  batchClient.print("HTTP/1.1 200 OK\r\n"
+                    "Content-Type: application/x-ndjson\r\n"
+                    "Cache-Control: no-cache\r\n"
+                    "Connection: close\r\n\r\n");
+  batchStreaming = true;
+  batchCancelled = false;
+  batchRunning = true;
+
+  xTaskCreatePinnedToCore(
+      batchGenerationTask,     // Task function
+      "BatchGenTask",          // Task name
+      BOARD_GEN_STACK_SIZE,    // Stack size (bytes)
+      (void *)job,             // Parameters
+      BOARD_GEN_TASK_PRIORITY, // Priority
+      NULL,                    // Task handle
+      BOARD_GEN_TASK_CORE      // Run on core 1
+  );
+}
+
+/**
+ * Web server handler for the push channel
+ * Keeps the connection open as a Server-Sent Events stream that starts
+ * with the whole state and then gets every change (see pushStateChanges)
+ */
+void handleEvents()
+{
+  WiFiClient client = server.client();
+  size_t length;
+  const char *json = stateSnapshot(length);
+  if (statePush.subscribe(client, stateVersion, "state", json, length))
+  {
+    Serial.print("[/events] Page subscribed, subscribers: ");
+    Serial.println(statePush.subscribers());
+  }
+  else
+  {
+    // The page keeps polling /getboard instead
+    server.send(503, "text/plain", "Too many subscribers");
+  }
+}
+
+/**
+ * Web server handler to get push channel statistics
+ */
+void handleGetPushStats()
+{
+  JsonDocument doc;
+  doc["subscribers"] = statePush.subscribers();
+  doc["broadcasts"] = statePush.broadcasts();
+  doc["lastLatencyUs"] = statePush.lastLatencyUs();
+  doc["maxLatencyUs"] = statePush.maxLatencyUs();
+
+  String jsonResponse;
+  serializeJson(doc, jsonResponse);
+  server.send(200, "application/json", jsonResponse);
+}
+
+/**
+ * Web server handler to get flash write statistics of the game
+ */
+void handleGetSaveStats()
+{
+  JsonDocument doc;
+  doc["changes"] = gameSaver.changes();
+  doc["writes"] = gameSaver.writes();
+  doc["failures"] = gameSaver.failures();
+  doc["lastWriteUs"] = gameSaver.lastWriteUs();
+  doc["coalesceMs"] = GAME_SAVE_COALESCE_MS;
+  doc["maxDelayMs"] = GAME_SAVE_BOUND_MS;
 
-    // Generate the json data
-    String jsonResponse = generateJSON();
+  String jsonResponse;
+  serializeJson(doc, jsonResponse);
+  server.send(200, "application/json", jsonResponse);
+}
 
-    // Send the JSON response
-    server.send(200, "application/json", jsonResponse);
+/**
+ * Web server handler to get LED frame statistics
+ */
+void handleGetLedStats()
+{
+  JsonDocument doc;
+  doc["framesShown"] = ledController.framesShown();
+  doc["framesSkipped"] = ledController.framesSkipped();
+
+  String jsonResponse;
+  serializeJson(doc, jsonResponse);
+  server.send(200, "application/json", jsonResponse);
+}
 
-    // Debug output
-    Serial.println(jsonResponse);
+/**
+ * Web server handler to get the roll history of the current or last game
+ * Statistics cover every roll of the game; the entries are the rolls
+ * still in the history ring, from roll index "from" on (default: all)
+ */
+void handleGetHistory()
+{
+  uint32_t first = rollHistory.firstIndex();
+  if (server.hasArg("from"))
+  {
+    long from = server.arg("from").toInt();
+    first = constrain(from, (long)rollHistory.firstIndex(), (long)rollHistory.rolls());
   }
+
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "application/json", "");
+
+  char chunk[HISTORY_CHUNK_SIZE];
+  size_t length = formatRollStats(rollHistory, boardIndex, first, chunk, sizeof(chunk));
+  for (int i = first - rollHistory.firstIndex(); i < rollHistory.size(); i++)
+  {
+    if (length + ROLL_HISTORY_ENTRY_SIZE > sizeof(chunk))
+    {
+      server.sendContent(chunk, length);
+      length = 0;
+    }
+    length += formatRollEntry(rollHistory.entry(i), i == (int)(first - rollHistory.firstIndex()),
+                              chunk + length, sizeof(chunk) - length);
+  }
+  server.sendContent(chunk, length);
+  server.sendContent("]}");
+  server.sendContent("");
 }
 
 /**
@@ -476,17 +1423,18 @@ void handleStartGame()
   ledController.stopAnimation();
   ledController.startAnimation(START_GAME_ANIMATION, nullptr, 0, 250);
 
-  // Generate JSON response
-  String jsonResponse = generateJSON();
+  markStateChanged(STATE_CHANGE_GAME);
 
-  // Save game state to flash for persistence
-  saveGameState();
+  // Restart the play clock and save the new game to flash with a fresh roll history
+  playSecondsBase = 0;
+  playClockStart = millis();
+  saveNewGame();
 
   // Send the response
-  server.send(200, "application/json", jsonResponse);
+  sendGameState();
 
   // Debug output
-  Serial.println(jsonResponse);
+  Serial.println(stateJson);
 }
 
 /**
@@ -505,25 +1453,23 @@ void handleEndGame()
   // Delete the saved game state
   deleteGameState();
 
-  // Generate JSON response
-  String jsonResponse = generateJSON();
+  markStateChanged(STATE_CHANGE_GAME);
 
   // Send the response
-  server.send(200, "application/json", jsonResponse);
+  sendGameState();
 
   // Debug output
-  Serial.println(jsonResponse);
+  Serial.println(stateJson);
 }
 
 /**
  * Updates the LED display based on the currently selected number
  * For normal numbers (2-6, 8-12): Lights up hexes with that number
  * For 7 (robber): Triggers the robber animation
+ * Only the hexes of the number are visited, through the board index
  */
 void turnOnNumber()
 {
-  // Determine number of tiles based on board mode
-  int tileCount = boardConfig.isExtension ? LED_COUNT_EXTENSION : LED_COUNT_CLASSIC;
   ledController.stopAnimation();
 
   // Trigger Home Assistant with the selected number
@@ -536,41 +1482,26 @@ void turnOnNumber()
 
   if (selectedNumber == 7)
   {
-    // Special handling for the robber (7)
-    uint8_t requiredTiles = boardConfig.isExtension ? 2 : 1;
-    uint8_t foundCount = 0;
-
-    // Allocate array for desert tiles (robber locations)
-    uint16_t *robberTiles = new uint16_t[requiredTiles];
-
-    // Find desert tiles (number token 0)
-    for (int tile = 0; tile < tileCount && foundCount < requiredTiles; tile++)
+    // Special handling for the robber (7): start from the desert tiles
+    int desertCount = boardIndex.countResource(RESOURCE_DESERT);
+    const uint8_t *deserts = boardIndex.hexesOfResource(RESOURCE_DESERT);
+    for (int i = 0; i < desertCount; i++)
     {
-      if (board.numbers[tile] == 0)
-      {
-        Serial.print("Desert found at tile: ");
-        Serial.println(tile);
-        robberTiles[foundCount++] = tile;
-      }
+      Serial.print("Desert found at tile: ");
+      Serial.println(deserts[i]);
     }
 
     // Start robber animation from the desert tiles
-    ledController.startAnimation(ROBBER_ANIMATION, robberTiles, foundCount, 500);
+    ledController.startAnimation(ROBBER_ANIMATION, deserts, desertCount, 500);
   }
   else
   {
     // For regular numbers, highlight matching hexes
-    for (int tile = 0; tile < tileCount; tile++)
+    int tileCount = boardIndex.countNumber(selectedNumber);
+    const uint8_t *tiles = boardIndex.hexesWithNumber(selectedNumber);
+    for (int i = 0; i < tileCount; i++)
     {
-      if (board.numbers[tile] == selectedNumber)
-      {
-        ledController.turnTileOn(tile, ledController.Color(255, 255, 255));
-      }
-      else
-      {
-        // Turn off LEDs for non-matching tiles
-        ledController.turnTileOn(tile, 0);
-      }
+      ledController.turnTileOn(tiles[i], ledController.Color(255, 255, 255));
     }
 
     // Update the LED strip
@@ -593,8 +1524,10 @@ void handleSelectNumber()
   // Update LEDs to reflect the selected number
   turnOnNumber();
 
-  // Save the current game state
-  saveGameState();
+  markStateChanged(STATE_CHANGE_NUMBER);
+
+  // Save the roll
+  recordRoll(0, 0);
 
   // Respond to the client
   server.send(200, "text/plain", value);
@@ -623,8 +1556,10 @@ void handleRollDice()
   // Update the board display
   turnOnNumber();
 
-  // Save the current game state
-  saveGameState();
+  markStateChanged(STATE_CHANGE_NUMBER);
+
+  // Save the roll
+  recordRoll(die1, die2);
 
   // Respond to the client with the dice result
   server.send(200, "text/plain", result);
@@ -651,11 +1586,18 @@ void setup()
     return;
   }
 
-  // Attempt to load saved game state
+  // Queue through which generation tasks hand back finished boards
+  finishedJobs = xQueueCreate(BOARD_JOB_QUEUE_LENGTH, sizeof(BoardJob *));
+
+  // Replace built-in boards with scenario maps, if any are stored
+  loadBoardMaps();
+
+  // Start the task writing the game to flash, then replay the saved game
+  gameSaver.begin(GAME_SAVE_COALESCE_MS, GAME_SAVE_BOUND_MS);
   loadGameState();
 
   // If no game state was loaded, set default configuration
-  if (board.resources.size() == 0)
+  if (board.empty())
   {
     Serial.print("No settings in flash! Loading defaults");
     boardConfig.isExtension = DEFAULT_IS_EXTENSION;
@@ -663,10 +1605,20 @@ void setup()
     boardConfig.twoTwelveCanTouch = DEFAULT_TWO_TWELVE_CANTOUCH;
     boardConfig.sameNumbersCanTouch = DEFAULT_SAMENUMBERS_CANTOUCH;
     boardConfig.sameResourceCanTouch = DEFAULT_SAMERESOURCE_CANTOUCH;
+    boardConfig.minBalance = DEFAULT_MIN_BALANCE;
     manualDice = DEFAULT_MANUAL_DICE;
     gameStarted = false;
     selectedNumber = 0;
   }
+  else if (board.size() != boardLayout(boardConfig.isExtension).hexCount)
+  {
+    // The saved board was drawn before a map was added or removed
+    Serial.println("Saved board does not fit the current map, discarding it");
+    board = Board();
+    gameStarted = false;
+    selectedNumber = 0;
+  }
+  boardIndex.build(board);
 
   // Connect to WiFi
   connectWifi(WIFI_SSID, WIFI_PASS);
@@ -678,11 +1630,10 @@ void setup()
   randomSeed(micros());
 
   // Initialize LED strip based on board mode
-  uint16_t ledCount = boardConfig.isExtension ? LED_COUNT_EXTENSION : LED_COUNT_CLASSIC;
-  ledController.begin(ledCount);
+  ledController.begin(boardLedCount(boardConfig.isExtension), boardLedLayout(boardConfig.isExtension));
 
   // Start appropriate LED animation
-  if (board.resources.size() == 0)
+  if (board.empty())
   {
     // If no board loaded, show waiting animation
     ledController.startAnimation(WAITING_ANIMATION, nullptr, 0, 50);
@@ -701,6 +1652,7 @@ void setup()
   server.on("/twoTwelveCanTouch", HTTP_GET, handleUpdateTwoTwelveCanTouch);
   server.on("/sameNumbersCanTouch", HTTP_GET, handleUpdateSameNumbersCanTouch);
   server.on("/sameResourceCanTouch", HTTP_GET, handleUpdateSameResourceCanTouch);
+  server.on("/minBalance", HTTP_GET, handleUpdateMinBalance);
   server.on("/manualDice", HTTP_GET, handleUpdateManualDice);
 
   // Game control endpoints
@@ -712,26 +1664,32 @@ void setup()
   server.on("/endgame", HTTP_GET, handleEndGame);
   server.on("/selectNumber", HTTP_GET, handleSelectNumber);
   server.on("/rollDice", HTTP_GET, handleRollDice);
+  server.on("/poolstats", HTTP_GET, handleGetPoolStats);
+  server.on("/getjob", HTTP_GET, handleGetJob);
+  server.on("/batch", HTTP_GET, handleBatch);
+  server.on("/events", HTTP_GET, handleEvents);
+  server.on("/pushstats", HTTP_GET, handleGetPushStats);
+  server.on("/savestats", HTTP_GET, handleGetSaveStats);
+  server.on("/ledstats", HTTP_GET, handleGetLedStats);
+  server.on("/history", HTTP_GET, handleGetHistory);
 
   // Generate a new board if none was loaded
-  if (board.resources.size() == 0)
+  if (board.empty())
   {
     Serial.print("No board loaded, generating new board!");
-    xTaskCreatePinnedToCore(
-        boardGenerationTask,     // Task function
-        "BoardGenTask",          // Task name
-        BOARD_GEN_STACK_SIZE,    // Stack size
-        NULL,                    // Parameters
-        BOARD_GEN_TASK_PRIORITY, // Priority
-        NULL,                    // Task handle
-        BOARD_GEN_TASK_CORE      // Core to run on
-    );
+    submitBoardJob(boardConfig.isExtension);
   }
   else
   {
     Serial.println("Using saved board state.");
   }
 
+  // Keep a few boards ready so shuffles don't wait for the solver
+  boardPool.begin(boardConfig);
+
+  // Tell the log about maps that have no board, off the loop task's stack
+  startMapCheck();
+
   // Initialize Home Assistant if enabled
 #ifdef ENABLE_HOME_ASSISTANT
   initHomeAssistant(HA_IP, HA_PORT, HA_ACCESS_TOKEN, "/api/services/script/turn_on");
@@ -747,6 +1705,11 @@ void setup()
   }
   Serial.println("mDNS responder started");
 
+  // Let /getboard see the ETag a client already has
+  const char *stateHeaders[] = {"If-None-Match"};
+  server.collectHeaders(stateHeaders, 1);
+  bootId = esp_random();
+
   // Start the web server
   server.begin();
   Serial.println("HTTP server started.");
@@ -762,4 +1725,7 @@ void setup()
 void loop()
 {
   server.handleClient();
+  collectBoardJobs();
+  pumpBatch();
+  pushStateChanges();
 }
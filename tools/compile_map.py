@@ -0,0 +1,88 @@
+#!/usr/bin/env python3
+"""
+compile_map.py
+
+Compiles a JSON board map into the binary format read by the firmware
+(see lib/BoardGenerator/src/BoardMap.h for the byte layout).
+
+Copy the result to data/maps/classic.bin or data/maps/extension.bin and
+upload the file system image (pio run -t uploadfs) to replace that board.
+
+Usage:
+    python3 tools/compile_map.py tools/maps/classic.json data/maps/classic.bin
+"""
+
+import json
+import sys
+
+MAP_MAGIC = b"CMAP"
+MAP_VERSION = 1
+MAX_HEXES = 30
+MAX_ROWS = 12
+RESOURCES = ["sheep", "wood", "wheat", "brick", "ore", "desert"]
+TOKENS = [2, 3, 4, 5, 6, 8, 9, 10, 11, 12]
+NO_NEIGHBOR = 255
+
+
+def fail(message):
+    sys.exit("compile_map: " + message)
+
+
+def compile_map(board):
+    """Check a map description and return its binary form."""
+    neighbors = board["neighbors"]
+    hex_count = len(neighbors)
+    rows = board["rows"]
+    tile_to_led = board.get("leds", list(range(hex_count)))
+    led_count = board.get("ledCount", max(tile_to_led) + 1)
+
+    if not 1 <= hex_count <= MAX_HEXES:
+        fail("a map has 1 to %d hexes, not %d" % (MAX_HEXES, hex_count))
+    if not 1 <= len(rows) <= MAX_ROWS or sum(rows) != hex_count:
+        fail("rows must list 1 to %d row sizes adding up to %d" % (MAX_ROWS, hex_count))
+    if len(tile_to_led) != hex_count or len(set(tile_to_led)) != hex_count:
+        fail("leds must give a different LED to each of the %d hexes" % hex_count)
+    if not hex_count <= led_count <= 255 or max(tile_to_led) >= led_count:
+        fail("ledCount must cover every LED index (at most 255)")
+
+    for hex_index, slots in enumerate(neighbors):
+        if len(slots) != 6:
+            fail("hex %d must list 6 neighbour slots" % hex_index)
+        for slot, neighbor in enumerate(slots):
+            if neighbor == -1:
+                continue
+            if not 0 <= neighbor < hex_count or neighbors[neighbor][5 - slot] != hex_index:
+                fail("hex %d slot %d: neighbour %d does not list it back in slot %d"
+                     % (hex_index, slot, neighbor, 5 - slot))
+
+    resources = [board["resources"].get(name, 0) for name in RESOURCES]
+    tokens = [board["tokens"].get(str(value), 0) for value in TOKENS]
+    if sum(resources) != hex_count:
+        fail("the resource pool has %d hexes, the map %d" % (sum(resources), hex_count))
+    if sum(tokens) != hex_count - resources[-1]:
+        fail("the token pool needs one token per non-desert hex (%d)" % (hex_count - resources[-1]))
+
+    data = bytearray(MAP_MAGIC)
+    data += bytes([MAP_VERSION, hex_count, led_count, len(rows)])
+    data += bytes(rows)
+    for slots in neighbors:
+        data += bytes(NO_NEIGHBOR if n == -1 else n for n in slots)
+    data += bytes(tile_to_led)
+    data += bytes(resources)
+    data += bytes(tokens)
+    return bytes(data)
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit("Usage: %s MAP.json OUTPUT.bin" % sys.argv[0])
+    with open(sys.argv[1]) as source:
+        board = json.load(source)
+    data = compile_map(board)
+    with open(sys.argv[2], "wb") as output:
+        output.write(data)
+    print("%s: %d hexes, %d bytes" % (sys.argv[2], len(board["neighbors"]), len(data)))
+
+
+if __name__ == "__main__":
+    main()